@@ -63,4 +63,10 @@
 # include <odbcinst.h>
 #endif
 
+/* ODBC 3.81 driver-aware connection pooling */
+#if defined(HAVE_SQLSPI_H) && ODBCVER >= 0x0380
+# include <sqlspi.h>
+# define MYODBC_DRIVER_AWARE_POOLING
+#endif
+
 #endif /* !MYODBC_ODBC_H */
@@ -574,6 +574,7 @@ SQLGetConnectAttrImpl(SQLHDBC hdbc, SQLINTEGER attribute, SQLPOINTER value,
 {
   DBC *dbc= (DBC *)hdbc;
   SQLCHAR *char_value= NULL;
+  my_bool free_char_value= FALSE;
   SQLRETURN rc= 0;
 
   /* 
@@ -581,10 +582,12 @@ SQLGetConnectAttrImpl(SQLHDBC hdbc, SQLINTEGER attribute, SQLPOINTER value,
     the valid output buffer to prevent crashes
   */
   if (value)
-    rc= MySQLGetConnectAttr(hdbc, attribute, &char_value, value);
+    rc= MySQLGetConnectAttr(hdbc, attribute, &char_value, value,
+                            &free_char_value);
 
   if (char_value)
   {
+    SQLCHAR *attr_value= char_value;
     SQLSMALLINT free_value= FALSE;
     SQLINTEGER len= SQL_NTS;
     uint errors;
@@ -621,6 +624,9 @@ SQLGetConnectAttrImpl(SQLHDBC hdbc, SQLINTEGER attribute, SQLPOINTER value,
 
     if (free_value)
       x_free(char_value);
+
+    if (free_char_value)
+      x_free(attr_value);
   }
 
   return rc;
@@ -1245,6 +1251,78 @@ SQLSetConnectAttrImpl(SQLHDBC hdbc, SQLINTEGER attribute,
 }
 
 
+#ifdef MYODBC_DRIVER_AWARE_POOLING
+SQLRETURN SQL_API
+SQLSetConnectAttrForDbcInfo(SQLHDBC_INFO_TOKEN token, SQLINTEGER attribute,
+                            SQLPOINTER value, SQLINTEGER value_len)
+{
+  SQLRETURN rc;
+  SQLWCHAR *valuew;
+  uint errors;
+
+  CHECK_HANDLE(token);
+
+  /* SQL_ATTR_CURRENT_CATALOG is the only string attribute we support. */
+  if (attribute != SQL_ATTR_CURRENT_CATALOG)
+    return MySQLSetConnectAttrForDbcInfo(token, attribute, value, value_len);
+
+  valuew= sqlchar_as_sqlwchar(default_charset_info, value, &value_len, &errors);
+  rc= MySQLSetConnectAttrForDbcInfo(token, attribute, valuew, SQL_NTS);
+  x_free(valuew);
+
+  return rc;
+}
+
+
+SQLRETURN SQL_API
+SQLSetConnectInfo(SQLHDBC_INFO_TOKEN token,
+                  SQLCHAR *dsn, SQLSMALLINT dsn_len_in,
+                  SQLCHAR *user, SQLSMALLINT user_len_in,
+                  SQLCHAR *auth, SQLSMALLINT auth_len_in)
+{
+  uint errors;
+  SQLRETURN rc;
+  SQLINTEGER dsn_len= dsn_len_in, user_len= user_len_in,
+             auth_len= auth_len_in;
+  SQLWCHAR *dsnw, *userw, *authw;
+
+  CHECK_HANDLE(token);
+
+  dsnw=  sqlchar_as_sqlwchar(default_charset_info, dsn, &dsn_len, &errors);
+  userw= sqlchar_as_sqlwchar(default_charset_info, user, &user_len, &errors);
+  authw= sqlchar_as_sqlwchar(default_charset_info, auth, &auth_len, &errors);
+
+  rc= MySQLSetConnectInfo(token, dsnw, SQL_NTS, userw, SQL_NTS,
+                          authw, SQL_NTS);
+
+  x_free(dsnw);
+  x_free(userw);
+  x_free(authw);
+
+  return rc;
+}
+
+
+SQLRETURN SQL_API
+SQLSetDriverConnectInfo(SQLHDBC_INFO_TOKEN token, SQLCHAR *in,
+                        SQLSMALLINT in_len)
+{
+  SQLRETURN rc;
+  uint errors;
+  SQLINTEGER inw_len= in_len;
+  SQLWCHAR *inw;
+
+  CHECK_HANDLE(token);
+
+  inw= sqlchar_as_sqlwchar(utf8_charset_info, in, &inw_len, &errors);
+  rc= MySQLSetDriverConnectInfo(token, inw, SQL_NTS);
+  x_free(inw);
+
+  return rc;
+}
+#endif
+
+
 SQLRETURN SQL_API
 SQLSetConnectOption(SQLHDBC hdbc, SQLUSMALLINT option, SQLULEN param)
 {
@@ -1301,7 +1379,7 @@ SQLSetStmtAttr(SQLHSTMT hstmt, SQLINTEGER attribute,
 {
   CHECK_HANDLE(hstmt);
 
-  /* Nothing special to do, since we don't have any string stmt attribs */
+  /* The export path is the only string stmt attribute, it is taken as is */
   return MySQLSetStmtAttr(hstmt, attribute, value, value_len);
 }
 
@@ -220,7 +220,8 @@ server_list_dbcolumns(STMT *stmt,
   strncpy(column_buff, szColumn, cbColumn);
   column_buff[cbColumn]= '\0';
 
-  result= mysql_list_fields(mysql, buff, column_buff);
+  result= full_result_metadata(dbc) ? NULL :
+            mysql_list_fields(mysql, buff, column_buff);
 
   /* If before this call no database were selected - we cannot revert that */
   if (cbCatalog && dbc->database)
@@ -924,7 +925,8 @@ MYSQL_RES *server_show_create_table(STMT        *stmt,
 
   assert(to - buff < sizeof(buff));
 
-  if (mysql_real_query(mysql,buff,(unsigned long)(to - buff)))
+  if (full_result_metadata(stmt->dbc) ||
+      mysql_real_query(mysql,buff,(unsigned long)(to - buff)))
   {
     return NULL;
   }
@@ -2441,7 +2443,8 @@ tables_no_i_s(SQLHSTMT hstmt,
                                       (char *)catalog, catalog_len);
         to= myodbc_stpmov(to, "'");
         MYLOG_QUERY(stmt, buff);
-        if (!mysql_query(&stmt->dbc->mysql, buff))
+        if (!full_result_metadata(stmt->dbc) &&
+            !mysql_query(&stmt->dbc->mysql, buff))
           catalog_res= mysql_store_result(&stmt->dbc->mysql);
       }
       myodbc_mutex_unlock(&stmt->dbc->lock);
@@ -140,43 +140,106 @@ SQLRETURN myodbc_set_initial_character_set(DBC *dbc, const char *charset)
 
 
 /**
-  Try to establish a connection to a MySQL server based on the data source
-  configuration.
+  Set up the session variables the driver relies on: the character set and
+  SQL_AUTO_IS_NULL. Done after connecting and again after the session was
+  reset, as mysql_reset_connection() puts them back to server defaults.
 
   @param[in]  dbc  Database connection
   @param[in]  ds   Data source information
 
-  @return Standard SQLRETURN code. If it is @c SQL_SUCCESS or @c
-  SQL_SUCCESS_WITH_INFO, a connection has been established.
+  @return Standard SQLRETURN code.
 */
-SQLRETURN myodbc_do_connect(DBC *dbc, DataSource *ds)
+SQLRETURN myodbc_init_session(DBC *dbc, DataSource *ds)
 {
-  SQLRETURN rc= SQL_SUCCESS;
-  MYSQL *mysql= &dbc->mysql;
-  unsigned long flags;
-  /* Use 'int' and fill all bits to avoid alignment Bug#25920 */
-  unsigned int opt_ssl_verify_server_cert = ~0;
-  const my_bool on= 1;
-  unsigned long max_long = ~0L;
+  SQLRETURN rc= myodbc_set_initial_character_set(dbc,
+                  ds_get_utf8attr(ds->charset, &ds->charset8));
+  if (!SQL_SUCCEEDED(rc))
+  {
+    return rc;
+  }
 
-#ifdef WIN32
   /*
-   Detect if we are running with ADO present, and force on the
-   FLAG_COLUMN_SIZE_S32 option if we are.
+    The MySQL server has a workaround for old versions of Microsoft Access
+    (and possibly other products) that is no longer necessary, but is
+    unfortunately enabled by default. We have to turn it off, or it causes
+    other problems.
   */
-  if (GetModuleHandle("msado15.dll") != NULL)
-    ds->limit_column_size= 1;
+  if (!ds->auto_increment_null_search &&
+      odbc_stmt(dbc, "SET SQL_AUTO_IS_NULL = 0", SQL_NTS, TRUE) != SQL_SUCCESS)
+  {
+    return SQL_ERROR;
+  }
 
-  /* Detect another problem specific to MS Access */
-  if (GetModuleHandle("msaccess.exe") != NULL)
-    ds->default_bigint_bind_str= 1;
-#endif
+  return rc;
+}
 
-  mysql_init(mysql);
 
-  flags= get_client_flags(ds);
+/**
+  Validate the data source and attach it to the connection without talking
+  to the server (LAZY_CONNECT). The physical connection is established by
+  myodbc_connect_deferred() on the first operation that needs the server.
+
+  @param[in]  dbc  Database connection
+  @param[in]  ds   Data source information
+
+  @return Standard SQLRETURN code.
+*/
+static SQLRETURN myodbc_defer_connect(DBC *dbc, DataSource *ds)
+{
+  if (ds->initstmt && ds->initstmt[0] &&
+      is_set_names_statement((SQLCHAR *)ds_get_utf8attr(ds->initstmt,
+                                                        &ds->initstmt8)))
+  {
+    return set_dbc_error(dbc, "HY000",
+                         "SET NAMES not allowed by driver", 0);
+  }
+
+  if (ds->charset && ds->charset[0] &&
+      !get_charset_by_csname(ds_get_utf8attr(ds->charset, &ds->charset8),
+                             MYF(MY_CS_PRIMARY), MYF(0)))
+  {
+    char errmsg[NAME_LEN + 32*SYSTEM_CHARSET_MBMAXLEN];
+    sprintf(errmsg, "Wrong character set name %.*s", NAME_LEN, ds->charset8);
+    return set_dbc_error(dbc, "HY000", errmsg, 0);
+  }
+
+  dbc->ds= ds;
+  /* init all needed UTF-8 strings */
+  ds_get_utf8attr(ds->name, &ds->name8);
+  ds_get_utf8attr(ds->server, &ds->server8);
+  ds_get_utf8attr(ds->uid, &ds->uid8);
+  ds_get_utf8attr(ds->pwd, &ds->pwd8);
+  ds_get_utf8attr(ds->socket, &ds->socket8);
+  if (ds->database)
+  {
+    x_free(dbc->database);
+    dbc->database= myodbc_strdup(ds_get_utf8attr(ds->database, &ds->database8),
+                             MYF(MY_WME));
+  }
+
+  if (ds->save_queries && !dbc->query_log)
+    dbc->query_log= init_query_log();
+
+  dbc->need_to_connect= 1;
+  return SQL_SUCCESS;
+}
 
-  /* Set other connection options */
+
+/**
+  Set the options of a connection to the data source, other than the
+  character set: timeouts, authentication plugins, SSL and INITSTMT.
+  Used for the connection of the handle and for its side connections.
+
+  @param[in]  dbc    Database connection
+  @param[in]  mysql  Connection to set the options of
+  @param[in]  ds     Data source information
+*/
+void myodbc_set_connect_options(DBC *dbc, MYSQL *mysql, DataSource *ds)
+{
+  /* Use 'int' and fill all bits to avoid alignment Bug#25920 */
+  unsigned int opt_ssl_verify_server_cert = ~0;
+  const my_bool on= 1;
+  unsigned long max_long = ~0L;
 
   if (ds->allow_big_results || ds->safe)
 #if MYSQL_VERSION_ID >= 50709
@@ -193,16 +256,8 @@ SQLRETURN myodbc_do_connect(DBC *dbc, DataSource *ds)
     mysql_options(mysql, MYSQL_READ_DEFAULT_GROUP, "odbc");
 
   if (ds->initstmt && ds->initstmt[0])
-  {
-    /* Check for SET NAMES */
-    if (is_set_names_statement((SQLCHAR *)ds_get_utf8attr(ds->initstmt,
-                                                          &ds->initstmt8)))
-    {
-      return set_dbc_error(dbc, "HY000",
-                           "SET NAMES not allowed by driver", 0);
-    }
-    mysql_options(mysql, MYSQL_INIT_COMMAND, ds->initstmt8);
-  }
+    mysql_options(mysql, MYSQL_INIT_COMMAND,
+                  ds_get_utf8attr(ds->initstmt, &ds->initstmt8));
 
   if (dbc->login_timeout)
     mysql_options(mysql, MYSQL_OPT_CONNECT_TIMEOUT,
@@ -272,42 +327,6 @@ SQLRETURN myodbc_do_connect(DBC *dbc, DataSource *ds)
   }
 #endif
 
-
-  if (dbc->unicode)
-  {
-    /*
-      Get the ANSI charset info before we change connection to UTF-8.
-    */
-    MY_CHARSET_INFO my_charset;
-    mysql_get_character_set_info(&dbc->mysql, &my_charset);
-    dbc->ansi_charset_info= get_charset(my_charset.number, MYF(0));
-    /*
-      We always use utf8 for the connection, and change it afterwards if needed.
-    */
-    mysql_options(mysql, MYSQL_SET_CHARSET_NAME, "utf8");
-    dbc->cxn_charset_info= utf8_charset_info;
-  }
-  else
-  {
-#ifdef _WIN32
-    char cpbuf[64];
-    const char *client_cs_name= NULL;
-
-    myodbc_snprintf(cpbuf, sizeof(cpbuf), "cp%u", GetACP());
-    client_cs_name= my_os_charset_to_mysql_charset(cpbuf);
-
-    if (client_cs_name)
-    {
-      mysql_options(mysql, MYSQL_SET_CHARSET_NAME, client_cs_name);
-      dbc->ansi_charset_info= dbc->cxn_charset_info= get_charset_by_csname(client_cs_name, MYF(MY_CS_PRIMARY), MYF(0));
-    }
-#else
-    MY_CHARSET_INFO my_charset;
-    mysql_get_character_set_info(&dbc->mysql, &my_charset);
-    dbc->ansi_charset_info= get_charset(my_charset.number, MYF(0));
-#endif
-}
-
 #if MYSQL_VERSION_ID >= 50610
   if (ds->can_handle_exp_pwd)
   {
@@ -353,6 +372,123 @@ SQLRETURN myodbc_do_connect(DBC *dbc, DataSource *ds)
       mysql_options(mysql, MYSQL_OPT_SSL_MODE, &mode);
   }
 #endif
+}
+
+
+/**
+  Open a side connection to the server of the connection, with the same
+  options, user and character set. No database is selected.
+
+  @param[in]  dbc    Database connection
+  @param[in]  mysql  Handle for the side connection, after mysql_init()
+
+  @return Non-zero if the connection has been established
+*/
+my_bool myodbc_side_connect(DBC *dbc, MYSQL *mysql)
+{
+  DataSource *ds= dbc->ds;
+
+  myodbc_set_connect_options(dbc, mysql, ds);
+  mysql_options(mysql, MYSQL_SET_CHARSET_NAME, dbc->cxn_charset_info->csname);
+
+  return mysql_real_connect(mysql, ds->server8, ds->uid8, ds->pwd8,
+                            NULL, ds->port, ds->socket8,
+                            get_client_flags(ds) & ~CLIENT_MULTI_STATEMENTS)
+         != NULL;
+}
+
+
+/**
+  Try to establish a connection to a MySQL server based on the data source
+  configuration.
+
+  @param[in]  dbc  Database connection
+  @param[in]  ds   Data source information
+
+  @return Standard SQLRETURN code. If it is @c SQL_SUCCESS or @c
+  SQL_SUCCESS_WITH_INFO, a connection has been established.
+*/
+SQLRETURN myodbc_do_connect(DBC *dbc, DataSource *ds)
+{
+  SQLRETURN rc= SQL_SUCCESS;
+  MYSQL *mysql= &dbc->mysql;
+  unsigned long flags;
+  const my_bool on= 1;
+
+  /* File DSNs are validated by connecting, so they are never deferred */
+  if (ds->lazy_connect && !dbc->need_to_connect && !ds->savefile)
+    return myodbc_defer_connect(dbc, ds);
+
+#ifdef WIN32
+  /*
+   Detect if we are running with ADO present, and force on the
+   FLAG_COLUMN_SIZE_S32 option if we are.
+  */
+  if (GetModuleHandle("msado15.dll") != NULL)
+    ds->limit_column_size= 1;
+
+  /* Detect another problem specific to MS Access */
+  if (GetModuleHandle("msaccess.exe") != NULL)
+    ds->default_bigint_bind_str= 1;
+#endif
+
+  mysql_init(mysql);
+
+  flags= get_client_flags(ds);
+
+  if (ds->initstmt && ds->initstmt[0] &&
+      is_set_names_statement((SQLCHAR *)ds_get_utf8attr(ds->initstmt,
+                                                         &ds->initstmt8)))
+  {
+    /* Check for SET NAMES */
+    set_dbc_error(dbc, "HY000", "SET NAMES not allowed by driver", 0);
+    goto error;
+  }
+
+  /* Set other connection options */
+  myodbc_set_connect_options(dbc, mysql, ds);
+
+  if (dbc->unicode)
+  {
+    /*
+      Get the ANSI charset info before we change connection to UTF-8.
+    */
+    MY_CHARSET_INFO my_charset;
+    mysql_get_character_set_info(&dbc->mysql, &my_charset);
+    dbc->ansi_charset_info= get_charset(my_charset.number, MYF(0));
+    /*
+      We always use utf8 for the connection, and change it afterwards if needed.
+    */
+    mysql_options(mysql, MYSQL_SET_CHARSET_NAME, "utf8");
+    dbc->cxn_charset_info= utf8_charset_info;
+  }
+  else
+  {
+#ifdef _WIN32
+    char cpbuf[64];
+    const char *client_cs_name= NULL;
+
+    myodbc_snprintf(cpbuf, sizeof(cpbuf), "cp%u", GetACP());
+    client_cs_name= my_os_charset_to_mysql_charset(cpbuf);
+
+    if (client_cs_name)
+    {
+      mysql_options(mysql, MYSQL_SET_CHARSET_NAME, client_cs_name);
+      dbc->ansi_charset_info= dbc->cxn_charset_info= get_charset_by_csname(client_cs_name, MYF(MY_CS_PRIMARY), MYF(0));
+    }
+#else
+    MY_CHARSET_INFO my_charset;
+    mysql_get_character_set_info(&dbc->mysql, &my_charset);
+    dbc->ansi_charset_info= get_charset(my_charset.number, MYF(0));
+#endif
+}
+
+#if MYSQL_VERSION_ID >= 80003
+  if (ds->optional_metadata)
+  {
+    mysql_options(mysql, MYSQL_OPT_OPTIONAL_RESULTSET_METADATA, (char *)&on);
+  }
+#endif
 
   if (!mysql_real_connect(mysql,
                           ds_get_utf8attr(ds->server,   &ds->server8),
@@ -382,16 +518,18 @@ SQLRETURN myodbc_do_connect(DBC *dbc, DataSource *ds)
          that, but the driver was linked  that
          does not support this option. Thus we change native error. */
       /* TODO: enum/defines for driver specific errors */
-      return set_conn_error(dbc, MYERR_08004,
+      set_conn_error(dbc, MYERR_08004,
         "Your password has expired, but underlying library doesn't support "
         "this functionlaity", 0);
+      goto error;
     }
 #endif
     set_dbc_error(dbc, "HY000", mysql_error(mysql), native_error);
 
     translate_error(dbc->error.sqlstate, MYERR_S1000, native_error);
 
-    return SQL_ERROR;
+    /* Closed, so that a deferred connect can init the handle again */
+    goto error;
   }
 
   if (!is_minimum_version(dbc->mysql.server_version, "4.1.1"))
@@ -401,27 +539,13 @@ SQLRETURN myodbc_do_connect(DBC *dbc, DataSource *ds)
     return SQL_ERROR;
   }
 
-  rc= myodbc_set_initial_character_set(dbc, ds_get_utf8attr(ds->charset,
-                                                            &ds->charset8));
+  rc= myodbc_init_session(dbc, ds);
   if (!SQL_SUCCEEDED(rc))
   {
     /** @todo set failure reason */
     goto error;
   }
 
-  /*
-    The MySQL server has a workaround for old versions of Microsoft Access
-    (and possibly other products) that is no longer necessary, but is
-    unfortunately enabled by default. We have to turn it off, or it causes
-    other problems.
-  */
-  if (!ds->auto_increment_null_search &&
-      odbc_stmt(dbc, "SET SQL_AUTO_IS_NULL = 0", SQL_NTS, TRUE) != SQL_SUCCESS)
-  {
-    /** @todo set error reason */
-    goto error;
-  }
-
   dbc->ds= ds;
   /* init all needed UTF-8 strings */
   ds_get_utf8attr(ds->name, &ds->name8);
@@ -439,6 +563,15 @@ SQLRETURN myodbc_do_connect(DBC *dbc, DataSource *ds)
   if (ds->save_queries && !dbc->query_log)
     dbc->query_log= init_query_log();
 
+  if (ds->flight_recorder && !dbc->flight)
+    dbc->flight= myodbc_malloc(sizeof(FLIGHT_RECORDER), MYF(MY_ZEROFILL));
+
+  if (ds->max_queries)
+    dbc->admission= admission_get(ds->server8 ? (char *)ds->server8 :
+                                  ds->socket8 ? (char *)ds->socket8 :
+                                  "localhost", ds->port, ds->max_queries);
+  FLIGHT_RECORD(dbc, dbc, FE_CONNECT, 0, mysql_thread_id(mysql));
+
   /* Set the statement error prefix based on the server version. */
   strxmov(dbc->st_error_prefix, MYODBC_ERROR_PREFIX, "[mysqld-",
           mysql->server_version, "]", NullS);
@@ -510,6 +643,13 @@ SQLRETURN myodbc_do_connect(DBC *dbc, DataSource *ds)
     }
   }
 
+  dbc->metadata_none= FALSE;
+#if MYSQL_VERSION_ID >= 80003
+  /* If the server does not support it, the metadata is simply always sent */
+  dbc->optional_metadata= ds->optional_metadata &&
+    (mysql->server_capabilities & CLIENT_OPTIONAL_RESULTSET_METADATA) != 0;
+#endif
+
 #if MYSQL_VERSION_ID >= 50709
   mysql_get_option(mysql, MYSQL_OPT_NET_BUFFER_LENGTH, &dbc->net_buffer_len);
 #else
@@ -524,6 +664,56 @@ error:
 }
 
 
+/**
+  Establish the physical connection that was deferred by LAZY_CONNECT.
+  The catalog may have been changed by the application in the meantime,
+  in which case it is selected once the connection is up.
+
+  @param[in]  dbc  Database connection
+
+  @return Standard SQLRETURN code. If the connection fails it stays
+  deferred, so the next operation that needs the server retries it.
+*/
+SQLRETURN myodbc_connect_deferred(DBC *dbc)
+{
+  SQLRETURN rc;
+  char *database= dbc->database;
+
+  /* Do not let myodbc_do_connect() free the catalog set by application */
+  dbc->database= NULL;
+
+  rc= myodbc_do_connect(dbc, dbc->ds);
+
+  if (!SQL_SUCCEEDED(rc))
+  {
+    x_free(dbc->database);
+    dbc->database= database;
+    return rc;
+  }
+
+  dbc->need_to_connect= 0;
+
+  if (database && (!dbc->database || cmp_database(database, dbc->database)))
+  {
+    if (mysql_select_db(&dbc->mysql, database))
+    {
+      set_conn_error(dbc, MYERR_S1000, mysql_error(&dbc->mysql),
+                     mysql_errno(&dbc->mysql));
+      x_free(database);
+      return SQL_ERROR;
+    }
+  }
+
+  if (database)
+  {
+    x_free(dbc->database);
+    dbc->database= database;
+  }
+
+  return rc;
+}
+
+
 /**
   Establish a connection to a data source.
 
@@ -555,7 +745,7 @@ SQLRETURN SQL_API MySQLConnect(SQLHDBC   hdbc,
 #else
 
   /* Can't connect if we're already connected. */
-  if (is_connected(dbc))
+  if (is_connected(dbc) || dbc->need_to_connect)
     return set_conn_error(hdbc, MYERR_08002, NULL, 0);
 
   /* Reset error state */
@@ -668,6 +858,13 @@ SQLRETURN SQL_API MySQLDriverConnect(SQLHDBC hdbc, SQLHWND hwnd,
   if (ds->dont_prompt_upon_connect)
     fDriverCompletion= SQL_DRIVER_NOPROMPT;
 
+  /*
+    A deferred connect can't fail here, so the dialog would never be shown.
+    LAZY_CONNECT only applies if there is no prompting.
+  */
+  if (fDriverCompletion != SQL_DRIVER_NOPROMPT)
+    ds->lazy_connect= FALSE;
+
   /*
     We only prompt if we need to.
 
@@ -961,17 +1158,47 @@ SQLRETURN SQL_API SQLDisconnect(SQLHDBC hdbc)
 
   free_connection_stmts(dbc);
   
-  mysql_close(&dbc->mysql);
+  /* Nothing to close if the deferred connection was never established */
+  if (dbc->need_to_connect)
+  {
+    dbc->need_to_connect= 0;
+  }
+  else
+  {
+    mysql_close(&dbc->mysql);
+
+    /* free allocated packet buffer */
+    if (dbc->mysql.net.buff)
+    {
+      myodbc_net_end(&dbc->mysql.net);
+    }
+  }
+
+  if (dbc->ds && dbc->ds->adaptive_ssps)
+  {
+    char buff[96];
+    sprintf(buff, "Adaptive SSPS: %u queries prepared on server, %u kept on text protocol",
+            dbc->ssps_adaptive_binary, dbc->ssps_adaptive_text);
+    MYLOG_DBC_QUERY(dbc, buff);
+    dbc->ssps_adaptive_binary= dbc->ssps_adaptive_text= 0;
+  }
 
   if (dbc->ds && dbc->ds->save_queries)
     end_query_log(dbc->query_log);
 
-  /* free allocated packet buffer */
-  if (dbc->mysql.net.buff)
+  if (dbc->flight)
   {
-    myodbc_net_end(&dbc->mysql.net);
+    x_free(dbc->flight);
+    dbc->flight= NULL;
   }
 
+  x_free(dbc->admission_dump);
+  dbc->admission= NULL;
+  dbc->admission_dump= NULL;
+  dbc->session_dirty= FALSE;
+
+  slow_query_end(dbc);
+
   x_free(dbc->database);
 
   if(dbc->ds)
@@ -1600,6 +1600,261 @@ static SQLRETURN setpos_dae_check_and_init(STMT *stmt, SQLSETPOSIROW irow,
 }
 
 
+/*
+  @type    : myodbc3 internal
+  @purpose : finds the result set columns of the unique key, returns FALSE
+  if the result set is not made of columns of one table with such a key
+*/
+
+static my_bool refresh_key_columns(STMT *stmt, uint *key)
+{
+  MYSQL_RES *result= stmt->result;
+  const char *table= NULL;
+  uint i, j;
+
+  for (i= 0; i < result->field_count; ++i)
+  {
+    MYSQL_FIELD *field= result->fields + i;
+
+    /* Every column has to be read back from the table */
+    if (!field->org_table || !field->org_table[0] ||
+        !field->org_name || !field->org_name[0] ||
+        (table && strcmp(table, field->org_table)))
+      return FALSE;
+    table= field->org_table;
+  }
+
+  if (!table || !find_used_table(stmt) ||
+      !check_if_usable_unique_key_exists(stmt))
+    return FALSE;
+
+  for (i= 0; i < stmt->cursor.pk_count; ++i)
+  {
+    for (j= 0; j < result->field_count; ++j)
+    {
+      if (!myodbc_strcasecmp(stmt->cursor.pkcol[i].name,
+                             result->fields[j].org_name))
+        break;
+    }
+    key[i]= j;
+  }
+
+  return TRUE;
+}
+
+
+/*
+  @type    : myodbc3 internal
+  @purpose : SQL_REFRESH by the unique key. The rows of the rowset (or row
+  irow of it) are read again by one query and replaced in the stored result
+  in place, instead of re-executing the whole query. Returns SQL_NO_DATA
+  if the result set can't be refreshed this way.
+*/
+
+static SQLRETURN setpos_refresh(STMT *stmt, SQLSETPOSIROW irow)
+{
+  MYSQL_RES     *result= stmt->result, *res;
+  MYSQL_ROWS    **rows, *saved_cursor, *row;
+  MYSQL_ROW     values;
+  SQLUSMALLINT  *status= stmt->stmt_options.rowStatusPtr_ex ?
+                         stmt->stmt_options.rowStatusPtr_ex :
+                         stmt->ird->array_status_ptr;
+  DYNAMIC_STRING dynQuery;
+  SQLRETURN     rc= SQL_SUCCESS;
+  my_bool       *found;
+  uint          key[MY_MAX_PK_PARTS], first, count, i, j, k, errors= 0;
+  long          pos;
+
+  if (ssps_used(stmt) || stmt->fix_fields || stmt->result_array ||
+      stmt->fake_result || if_forward_cache(stmt) || scroller_exists(stmt) ||
+      !result->data || !stmt->rows_found_in_set)
+    return SQL_NO_DATA;
+
+  first= irow ? (uint)irow - 1 : 0;
+  count= irow ? 1 : stmt->rows_found_in_set;
+
+  if (!refresh_key_columns(stmt, key))
+  {
+    CLEAR_STMT_ERROR(stmt);
+    return SQL_NO_DATA;
+  }
+
+  if (!(rows= (MYSQL_ROWS **)myodbc_malloc(count * (sizeof(MYSQL_ROWS *) +
+                                                    sizeof(my_bool)),
+                                           MYF(MY_ZEROFILL))))
+    return set_error(stmt, MYERR_S1001, NULL, 4001);
+  found= (my_bool *)(rows + count);
+
+  /* The stored rows of the rowset */
+  row= result->data->data;
+  for (pos= 0; row && pos < stmt->current_row + (long)first; ++pos)
+    row= row->next;
+  for (i= 0; row && i < count; ++i, row= row->next)
+    rows[i]= row;
+  count= i;
+
+  if (init_dynamic_string(&dynQuery, "SELECT ", 1024, 1024))
+  {
+    x_free(rows);
+    return set_error(stmt, MYERR_S1001, NULL, 4001);
+  }
+
+  for (j= 0; j < result->field_count; ++j)
+  {
+    if (j)
+      dynstr_append_mem(&dynQuery, ",", 1);
+    dynstr_append_quoted_name(&dynQuery, result->fields[j].org_name);
+  }
+  dynstr_append_mem(&dynQuery, " FROM ", 6);
+  dynstr_append_quoted_name(&dynQuery, stmt->table_name);
+  dynstr_append_mem(&dynQuery, " WHERE ", 7);
+
+  /* (key=value AND ...) OR (...) for every row, insert_field() reads
+     the values at the data cursor */
+  saved_cursor= result->data_cursor;
+  for (i= 0; i < count; ++i)
+  {
+    dynstr_append_mem(&dynQuery, i ? " OR (" : "(", i ? 5 : 1);
+    result->data_cursor= rows[i];
+
+    for (k= 0; k < stmt->cursor.pk_count; ++k)
+    {
+      /* NULL is not a unique value, the rows would be ambiguous */
+      if (!rows[i]->data[key[k]])
+      {
+        rc= SQL_NO_DATA;
+        goto exit;
+      }
+
+      dynstr_append_quoted_name(&dynQuery, result->fields[key[k]].org_name);
+      dynstr_append_mem(&dynQuery, "=", 1);
+      if (insert_field(stmt, result, &dynQuery, (SQLUSMALLINT)key[k]))
+      {
+        rc= SQL_ERROR;
+        goto exit;
+      }
+    }
+
+    /* Replace the trailing ' AND ' */
+    dynQuery.length-= 5;
+    dynstr_append_mem(&dynQuery, ")", 1);
+  }
+  result->data_cursor= saved_cursor;
+
+  MYLOG_QUERY(stmt, dynQuery.str);
+
+  myodbc_mutex_lock(&stmt->dbc->lock);
+  if (exec_stmt_query(stmt, dynQuery.str, dynQuery.length, FALSE) ||
+      !(res= mysql_store_result(&stmt->dbc->mysql)))
+  {
+    rc= set_error(stmt, MYERR_S1000, mysql_error(&stmt->dbc->mysql),
+                  mysql_errno(&stmt->dbc->mysql));
+    myodbc_mutex_unlock(&stmt->dbc->lock);
+    goto exit;
+  }
+  myodbc_mutex_unlock(&stmt->dbc->lock);
+
+  if (!stmt->dbc->ds->dont_use_set_locale)
+    setlocale(LC_NUMERIC, "C");
+
+  while ((values= mysql_fetch_row(res)))
+  {
+    ulong *lengths= mysql_fetch_lengths(res), size;
+    MYSQL_ROW data;
+    char *to;
+
+    /* Find the row of the rowset by the key values */
+    for (i= 0; i < count; ++i)
+    {
+      MYSQL_ROW old= rows[i]->data;
+
+      if (found[i])
+        continue;
+
+      for (k= 0; k < stmt->cursor.pk_count; ++k)
+      {
+        uint col= key[k];
+        ulong old_len= (ulong)strlen(old[col]);
+
+        if (!values[col] || lengths[col] != old_len ||
+            memcmp(values[col], old[col], old_len))
+          break;
+      }
+
+      if (k == stmt->cursor.pk_count)
+        break;
+    }
+
+    if (i == count)
+      continue;
+
+    /* Same layout as libmysql uses, the lengths are taken from it */
+    size= (result->field_count + 1) * sizeof(char *);
+    for (j= 0; j < result->field_count; ++j)
+      size+= lengths[j] + 1;
+
+    if (!(data= (MYSQL_ROW)alloc_root(&stmt->alloc_root, size)))
+    {
+      rc= set_error(stmt, MYERR_S1001, NULL, 4001);
+      break;
+    }
+
+    to= (char *)(data + result->field_count + 1);
+    for (j= 0; j < result->field_count; ++j)
+    {
+      if (!values[j])
+      {
+        data[j]= NULL;
+        continue;
+      }
+      data[j]= to;
+      memcpy(to, values[j], lengths[j]);
+      to+= lengths[j];
+      *to++= '\0';
+    }
+    data[result->field_count]= to;
+
+    if (stmt->current_values == rows[i]->data)
+      stmt->current_values= data;
+    rows[i]->data= data;
+    found[i]= TRUE;
+
+    fill_ird_data_lengths(stmt->ird, lengths, result->field_count);
+    j= sqlreturn2row_status(fill_fetch_buffers(stmt, data, lengths,
+                                               first + i));
+    if (j == SQL_ROW_ERROR)
+      ++errors;
+    if (status)
+      status[first + i]= (SQLUSMALLINT)j;
+  }
+
+  mysql_free_result(res);
+
+  if (!stmt->dbc->ds->dont_use_set_locale)
+    setlocale(LC_NUMERIC, default_locale);
+
+  /* The rows not found by their key are gone */
+  for (i= 0; i < count && status && SQL_SUCCEEDED(rc); ++i)
+  {
+    if (!found[i])
+      status[first + i]= SQL_ROW_DELETED;
+  }
+
+  if (SQL_SUCCEEDED(rc) && errors)
+  {
+    rc= errors == count ? SQL_ERROR : SQL_SUCCESS_WITH_INFO;
+    set_stmt_error(stmt, "01S01", "Error in row", 0);
+  }
+
+exit:
+  result->data_cursor= saved_cursor;
+  dynstr_free(&dynQuery);
+  x_free(rows);
+
+  return rc;
+}
+
+
 /*!
     \brief  Shadow function for SQLSetPos.
     
@@ -1795,6 +2050,10 @@ SQLRETURN SQL_API my_SQLSetPos(SQLHSTMT hstmt, SQLSETPOSIROW irow,
 
         case SQL_REFRESH:
             {
+                /* Only the rows of the rowset, by their key, if we can */
+                if ((sqlRet= setpos_refresh(stmt, irow)) != SQL_NO_DATA)
+                    break;
+
                 /*
                   Bug ...SQL_REFRESH is not suppose to fetch any
                   new rows, instead it needs to refresh the positioned
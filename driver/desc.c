@@ -668,6 +668,8 @@ MySQLGetDescField(SQLHDESC hdesc, SQLSMALLINT recnum, SQLSMALLINT fldid,
                 MYERR_07009);
     src_struct= desc_get_rec(desc, recnum - 1, FALSE);
     assert(src_struct);
+    if (IS_IRD(desc))
+      fill_ird_rec(desc->stmt, (DESCREC *)src_struct);
   }
 
   src= ((char *)src_struct) + fld->offset;
@@ -998,6 +1000,10 @@ SQLRETURN MySQLCopyDesc(SQLHDESC SourceDescHandle, SQLHDESC TargetDescHandle)
               "Associated statement is not prepared",
               MYERR_S1007);
 
+  /* the copy has no way back to the result set fields */
+  if (IS_IRD(src))
+    fill_ird_recs(src->stmt);
+
   /* copy the records */
   delete_dynamic(&dest->records);
   if (myodbc_init_dynamic_array(&dest->records, sizeof(DESCREC),
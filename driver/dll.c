@@ -86,6 +86,12 @@ void myodbc_init(void)
 
     utf8_charset_info= get_charset_by_csname("utf8", MYF(MY_CS_PRIMARY),
                                              MYF(0));
+    worker_pool_init();
+    admission_init();
+#ifdef MYODBC_DRIVER_AWARE_POOLING
+    pool_init();
+#endif
+    myodbc_kernels_init();
   }
 }
 
@@ -98,6 +104,11 @@ void myodbc_end()
 {
   if (!--myodbc_inited)
   {
+    worker_pool_end();
+    admission_end();
+#ifdef MYODBC_DRIVER_AWARE_POOLING
+    pool_end();
+#endif
     x_free(decimal_point);
     x_free(default_locale);
     x_free(thousands_sep);
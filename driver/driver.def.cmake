@@ -104,6 +104,7 @@ SQLSetDescField@WIDECHARCALL@
 SQLSetDescRec@WIDECHARCALL@
 SQLSetEnvAttr
 SQLSetConnectAttr@WIDECHARCALL@
+SQLSetConnectInfo@WIDECHARCALL@
 SQLSetConnectOption@WIDECHARCALL@
 SQLSetParam
 SQLSetPos
@@ -115,6 +116,7 @@ SQLStatistics@WIDECHARCALL@
 SQLTables@WIDECHARCALL@
 SQLTablePrivileges@WIDECHARCALL@
 SQLTransact
+@POOLING_EXPORTS@
 ;
 DllMain
 LoadByOrdinal
@@ -93,17 +93,30 @@ extern "C"
 #if defined(__APPLE__)
 
 #define DRIVER_QUERY_LOGFILE "/tmp/myodbc.sql"
+#define DRIVER_FLIGHT_LOGFILE "/tmp/myodbc_flight.log"
+#define DRIVER_SLOW_LOGFILE "/tmp/myodbc_slow.log"
 
 #elif defined(_UNIX_)
 
 #define DRIVER_QUERY_LOGFILE "/tmp/myodbc.sql"
+#define DRIVER_FLIGHT_LOGFILE "/tmp/myodbc_flight.log"
+#define DRIVER_SLOW_LOGFILE "/tmp/myodbc_slow.log"
 
 #else
 
 #define DRIVER_QUERY_LOGFILE "myodbc.sql"
+#define DRIVER_FLIGHT_LOGFILE "myodbc_flight.log"
+#define DRIVER_SLOW_LOGFILE "myodbc_slow.log"
 
 #endif
 
+/* Driver specific connection attribute, returns FLIGHT_RECORDER events */
+#define SQL_ATTR_MYODBC_FLIGHT_RECORDER (SQL_DRIVER_CONN_ATTR_BASE + 1)
+/* Driver specific connection attribute, returns MAX_QUERIES counters */
+#define SQL_ATTR_MYODBC_ADMISSION (SQL_DRIVER_CONN_ATTR_BASE + 2)
+/* Driver specific statement attribute, writes the result set to a file */
+#define SQL_ATTR_MYODBC_EXPORT (SQL_DRIVER_STMT_ATTR_BASE + 1)
+
 /*
    Internal driver definitions
 */
@@ -111,6 +124,8 @@ extern "C"
 #define MYSQL_RESET 1001	  /* param to SQLFreeStmt */
 #define MYSQL_3_21_PROTOCOL 10	  /* OLD protocol */
 #define CHECK_IF_ALIVE	    1800  /* Seconds between queries for ping */
+#define LOCAL_PROBE_ALIVE   5     /* Seconds a successful query proves the
+                                     connection alive for LOCAL_PROBES */
 
 #define MYSQL_MAX_CURSOR_LEN 18   /* Max cursor name length */
 #define MYSQL_STMT_LEN 1024	  /* Max statement length */
@@ -319,6 +334,8 @@ typedef struct {
   struct {
     MYSQL_FIELD * field; /* Used *only* by IRD */
     ulong datalen; /* actual length, maintained for *each* row */
+    /* IRD attributes are not yet derived from field, see fill_ird_rec() */
+    my_bool pending;
     /* TODO ugly, but easiest way to handle memory */
     SQLCHAR type_name[40];
   } row;
@@ -354,6 +371,123 @@ typedef struct	tagENV
 } ENV;
 
 
+/* FLIGHT_RECORDER: the latest events of the connection, kept in memory */
+#define FLIGHT_RECORDER_SIZE 256  /* power of 2 */
+#define FLIGHT_DUMP_LINE     96   /* max length of one event as text */
+#define FLIGHT_DUMP_SIZE     (FLIGHT_RECORDER_SIZE * FLIGHT_DUMP_LINE + 1)
+
+enum FLIGHT_EVENT_TYPE
+{
+  FE_CONNECT= 1,    /* value - connection id */
+  FE_QUERY_START,   /* value - query length */
+  FE_QUERY_END,     /* code - native error, value - microseconds */
+  FE_FETCH,         /* code - SQLRETURN, value - rows fetched */
+  FE_LOCK_WAIT,     /* value - microseconds waited for the connection lock */
+  FE_ERROR          /* code - native error, value - SQLSTATE */
+};
+
+typedef struct flight_event
+{
+  /* 2 * number + 1 while the event is written, 2 * number + 2 when done */
+  volatile longlong seq;
+  ulonglong     time;     /* microseconds since epoch */
+  void          *handle;
+  uint          type;
+  int           code;
+  ulonglong     value;
+} FLIGHT_EVENT;
+
+typedef struct flight_recorder
+{
+  /* number of the next event, only grows, slot is next % FLIGHT_RECORDER_SIZE */
+  volatile longlong next;
+  FLIGHT_EVENT  event[FLIGHT_RECORDER_SIZE];
+} FLIGHT_RECORDER;
+
+
+/* SLOW_QUERY_MS: plans of slow queries by their normalized text */
+#define SLOW_QUERY_PLANS      16
+#define SLOW_QUERY_PLAN_LEN   4096
+/* EXPLAIN is run at most once in that many seconds per connection */
+#define SLOW_QUERY_EXPLAIN_INTERVAL 1
+
+typedef struct slow_query_plan
+{
+  ulonglong     query_hash;   /* 0 - the entry is empty */
+  char          *plan;
+} SLOW_QUERY_PLAN;
+
+
+/*
+  FETCH_THREADS: the driver-wide pool of threads filling rowsets. Rowsets
+  of fewer rows are filled by the fetching thread alone.
+*/
+#define WORKER_POOL_MAX_THREADS   32
+#define PARALLEL_FETCH_MIN_ROWS   64
+
+typedef void (*WORKER_FUNC)(void *arg);
+
+typedef struct worker_task
+{
+  WORKER_FUNC   func;
+  void          *arg;
+} WORKER_TASK;
+
+
+/*
+  Hot loops with implementations for several instruction set tiers. The
+  best tier the CPU supports is chosen once in myodbc_init(), the
+  MYODBC_CPU_TIER environment variable can lower it for tests and
+  benchmarks (scalar, sse2, avx2 or avx512).
+*/
+enum myodbc_cpu_tier
+{
+  MYODBC_CPU_SCALAR= 0, MYODBC_CPU_SSE2, MYODBC_CPU_AVX2, MYODBC_CPU_AVX512
+};
+
+typedef struct myodbc_kernels
+{
+  enum myodbc_cpu_tier tier;
+  const char *tier_name;
+  /* Length of the leading run of ASCII (< 0x80) bytes */
+  size_t (*ascii_span)(const char *src, size_t len);
+  /* Length of the leading run of ASCII bytes needing no escape in literals */
+  size_t (*plain_span)(const char *src, size_t len);
+  /* Length of the leading run of decimal digits */
+  size_t (*digit_span)(const char *src, size_t len);
+  /* Widens ASCII bytes to SQLWCHARs */
+  void (*ascii_to_wchar)(SQLWCHAR *to, const char *src, size_t len);
+  /* Writes 2 * len upper case hex digits, returns the end of them */
+  char * (*hex_encode)(char *to, const char *src, size_t len);
+} MYODBC_KERNELS;
+
+extern MYODBC_KERNELS myodbc_kernels;
+
+
+/*
+  MAX_QUERIES: limit of queries executing at once against one server, shared
+  by all connections to it. Queries over the limit wait in FIFO order, for
+  at most QUEUE_TIMEOUT milliseconds if it is set.
+*/
+typedef struct admission_waiter
+{
+  myodbc_cond_t     cond;
+  my_bool           admitted;     /* the slot was handed over to the waiter */
+  struct admission_waiter *next;
+} ADMISSION_WAITER;
+
+typedef struct admission
+{
+  struct admission  *next;
+  char              *key;         /* host:port */
+  uint              limit, in_flight;
+  ADMISSION_WAITER  *head, *tail;
+  uint              queued, max_queued;
+  ulonglong         admitted, waited, timeouts;
+  ulonglong         wait_us, max_wait_us;
+} ADMISSION;
+
+
 /* Connection handler */
 
 typedef struct tagDBC
@@ -370,6 +504,7 @@ typedef struct tagDBC
   char          *database;
   SQLUINTEGER   login_timeout;
   time_t        last_query_time;
+  time_t        alive_time;         /* when a query succeeded last time */
   int           txn_isolation;
   uint          port;
   uint          cursor_count;
@@ -387,6 +522,23 @@ typedef struct tagDBC
   SQLULEN       sql_select_limit;   /* value of the sql_select_limit currently set for a session
                                        (SQLULEN)(-1) if wasn't set */
   int           need_to_wakeup;      /* Connection have been put to the pool */
+  int           need_to_connect;     /* Physical connect is deferred (LAZY_CONNECT) */
+  my_bool       session_dirty;      /* Queries may have left state in the session */
+  /* ADAPTIVE_SSPS decisions: queries kept on text protocol/prepared on server */
+  uint          ssps_adaptive_text, ssps_adaptive_binary;
+  /* OPTIONAL_METADATA: server can omit result set metadata on request */
+  my_bool       optional_metadata;
+  my_bool       metadata_none;      /* resultset_metadata=NONE is set for the session */
+  uint          schema_version;     /* changed by queries that may alter results */
+  FLIGHT_RECORDER *flight;          /* FLIGHT_RECORDER events, if enabled */
+  /* SLOW_QUERY_MS: side connection for EXPLAIN and the plans it returned */
+  myodbc_mutex_t explain_lock;       /* guards the slow query state */
+  MYSQL         *explain_mysql;
+  time_t        explain_time;       /* when EXPLAIN was run last time */
+  SLOW_QUERY_PLAN slow_plans[SLOW_QUERY_PLANS];
+  uint          slow_plan_next;
+  ADMISSION     *admission;         /* MAX_QUERIES limiter of the server */
+  char          *admission_dump;    /* last text dump of its counters */
 } DBC;
 
 
@@ -411,6 +563,16 @@ typedef struct limit_scroller
    unsigned long long start_offset;
    unsigned long long next_offset, total_rows, query_len;
 
+   /* Keyset mode - chunks continue from the last ORDER BY key seen */
+   char               *order_pos, *where_pos, *key_name;
+   char               *key_table;   /* ORDER BY qualifier, in key_name's buffer */
+   char               *key_query, *key_value;
+   unsigned long      key_value_len;
+   int                key_column;   /* -1 not checked yet, -2 not usable */
+   my_bool            key_desc;
+   unsigned long long key_query_len, key_dups;
+   unsigned long long chunk_offset, result_offset;
+
 } MY_LIMIT_SCROLLER;
 
 /* Statement primary key handler for cursors */
@@ -438,6 +600,119 @@ enum OUT_PARAM_STATE
   OPS_STREAMS_PENDING
 };
 
+/* ADAPTIVE_SSPS choice of the protocol for the prepared query */
+enum SSPS_POLICY
+{
+  SSPS_POLICY_FIXED= 0,   /* decided at prepare time */
+  SSPS_POLICY_UNDECIDED,  /* text protocol until the policy decides otherwise */
+  SSPS_POLICY_TEXT        /* binary protocol would not pay off */
+};
+
+/* CONVERSION_MEMO: values of a column converted lately to a C type */
+#define CONV_MEMO_SLOTS   32
+#define CONV_MEMO_MAX_SRC 32  /* longer values are converted every time */
+#define CONV_MEMO_MAX_DST ((CONV_MEMO_MAX_SRC + 1) * sizeof(SQLWCHAR))
+/* After that many lookups the memo is switched off if it does not pay off */
+#define CONV_MEMO_PROBE   256
+
+typedef struct conv_memo_slot
+{
+  uint          src_len;      /* 0 - the slot is empty */
+  uint          dst_len;
+  SQLLEN        dst_ind;      /* value for the length/indicator */
+  char          src[CONV_MEMO_MAX_SRC];
+  char          dst[CONV_MEMO_MAX_DST];
+} CONV_MEMO_SLOT;
+
+typedef struct conv_memo
+{
+  SQLSMALLINT     c_type;     /* slots are filled for this target type */
+  SQLSMALLINT     precision, scale;  /* for SQL_C_NUMERIC */
+  my_bool         disabled;
+  uint            lookups, hits;
+  CONV_MEMO_SLOT  slot[CONV_MEMO_SLOTS];
+} CONV_MEMO;
+
+
+/* OPTIONAL_METADATA: field definitions of the query executed last */
+typedef struct metadata_cache
+{
+  char          *query;
+  SQLULEN       query_length;
+  MYSQL_FIELD   *fields;
+  uint          field_count;
+  uint          schema_version;   /* of the connection, when cached */
+} METADATA_CACHE;
+
+
+/* SQL_ATTR_MAX_LENGTH: a query rewritten to truncate long columns */
+typedef struct max_length_field
+{
+  my_bool               truncated;
+  /* type of the column as it is without truncation */
+  enum enum_field_types type;
+  unsigned long         length;
+  unsigned int          flags, decimals, charsetnr;
+} MAX_LENGTH_FIELD;
+
+typedef struct max_length_cache
+{
+  char              *query;
+  SQLULEN           query_length;
+  SQLULEN           max_length;
+  char              *rewritten;   /* NULL if the query is executed as is */
+  SQLULEN           rewritten_length;
+  MAX_LENGTH_FIELD  *fields;
+  uint              field_count;
+} MAX_LENGTH_CACHE;
+
+
+/* READ_AHEAD: a row read from the network in advance, with its own copy */
+typedef struct read_ahead_row
+{
+  MYSQL_ROW     values;
+  unsigned long *lengths;
+  char          *data;
+  size_t        data_size;
+} READ_AHEAD_ROW;
+
+typedef struct read_ahead
+{
+  myodbc_mutex_t    lock;
+  myodbc_cond_t     cond;     /* signalled when a row is read or released */
+  struct tagSTMT    *stmt;
+  READ_AHEAD_ROW    *ring;
+  uint              size;
+  uint              count;    /* rows read and not released yet */
+  uint              read_pos, take_pos;
+  my_bool           eof;      /* the reading thread is done */
+  my_bool           oom;      /* it is done because a row could not be copied */
+  my_bool           stop;
+  my_bool           running;  /* the thread hasn't finished yet */
+  my_bool           locking;  /* it waits for the connection lock */
+  my_bool           orphaned; /* nobody waits for it, it frees the rest */
+  my_bool           holding;  /* the application has the row at take_pos */
+} READ_AHEAD;
+
+#define READ_AHEAD_MIN_ROWS 2
+
+
+#ifdef MYODBC_DRIVER_AWARE_POOLING
+/* Driver-aware pooling: the connection request the driver manager rates */
+typedef struct dbc_info_token
+{
+  ENV           *env;
+  DataSource    *ds;
+  SQLWCHAR      *conn_str;      /* given to SQLSetDriverConnectInfo */
+  SQLWCHAR      *catalog;       /* SQL_ATTR_CURRENT_CATALOG */
+  SQLCHAR       *catalog8;
+  SQLUINTEGER   autocommit;
+  my_bool       autocommit_set;
+  my_bool       unicode;        /* the info has been set with W functions */
+  SQLINTEGER    txn_isolation;  /* 0 if not set */
+} DBC_INFO_TOKEN;
+#endif
+
 
 /* Main statement handler */
 
@@ -502,10 +777,23 @@ typedef struct tagSTMT
 
   MYSQL_STMT *ssps;
   MYSQL_BIND *result_bind;
+  /* Signature of param binds given to mysql_stmt_bind_param, 0 - not bound */
+  ulonglong   param_bind_sig;
 
   MY_LIMIT_SCROLLER scroller;
 
   enum OUT_PARAM_STATE out_params_state;
+
+  enum SSPS_POLICY  ssps_policy;
+  uint              exec_count;   /* executions of the prepared query */
+
+  CONV_MEMO         *conv_memo;   /* per column, allocated in alloc_root */
+  /* per column C type, conversion to which has been verified (alloc_root) */
+  SQLSMALLINT       *verified_ctype;
+
+  METADATA_CACHE    *metadata_cache;
+  MAX_LENGTH_CACHE  *max_length_cache;
+  READ_AHEAD        *read_ahead;
 } STMT;
 
 
@@ -578,7 +866,8 @@ SQLRETURN SQL_API MySQLGetInfo(SQLHDBC hdbc, SQLUSMALLINT fInfoType,
                                SQLCHAR **char_info, SQLPOINTER num_info,
                                SQLSMALLINT *value_len);
 SQLRETURN SQL_API MySQLGetConnectAttr(SQLHDBC hdbc, SQLINTEGER attrib,
-                                      SQLCHAR **char_attr, SQLPOINTER num_attr);
+                                      SQLCHAR **char_attr, SQLPOINTER num_attr,
+                                      my_bool *free_char_attr);
 SQLRETURN MySQLGetDescField(SQLHDESC hdesc, SQLSMALLINT recnum,
                             SQLSMALLINT fldid, SQLPOINTER valptr,
                             SQLINTEGER buflen, SQLINTEGER *strlen);
@@ -177,6 +177,10 @@ SQLRETURN set_dbc_error(DBC *dbc, char *state,
     myodbc_stpmov(dbc->error.sqlstate, state);
     strxmov(dbc->error.message, MYODBC_ERROR_PREFIX, message, NullS);
     dbc->error.native_error= errcode;
+
+    if (dbc->flight)
+      flight_error(dbc, dbc, state, errcode);
+
     return SQL_ERROR;
 }
 
@@ -196,6 +200,9 @@ SQLRETURN set_stmt_error( STMT       *  stmt,
     strxmov(stmt->error.message, stmt->dbc->st_error_prefix, message, NullS);
     stmt->error.native_error = errcode;
 
+    if (stmt->dbc->flight)
+      flight_error(stmt->dbc, stmt, state, errcode);
+
     return SQL_ERROR;
 }
 
@@ -329,7 +336,13 @@ SQLRETURN set_env_error(ENV *env, myodbc_errid errid, const char *errtext,
 SQLRETURN set_conn_error(DBC *dbc, myodbc_errid errid, const char *errtext,
                          SQLINTEGER errcode)
 {
-    return copy_error(&dbc->error,errid,errtext,errcode,MYODBC_ERROR_PREFIX);
+    SQLRETURN rc= copy_error(&dbc->error,errid,errtext,errcode,
+                             MYODBC_ERROR_PREFIX);
+
+    if (dbc->flight)
+      flight_error(dbc, dbc, dbc->error.sqlstate, dbc->error.native_error);
+
+    return rc;
 }
 
 
@@ -341,8 +354,14 @@ SQLRETURN set_conn_error(DBC *dbc, myodbc_errid errid, const char *errtext,
 SQLRETURN set_error(STMT *stmt, myodbc_errid errid, const char *errtext,
                     SQLINTEGER errcode)
 {
-    return copy_error(&stmt->error, errid, errtext, errcode,
-                      stmt->dbc->st_error_prefix);
+    SQLRETURN rc= copy_error(&stmt->error, errid, errtext, errcode,
+                             stmt->dbc->st_error_prefix);
+
+    if (stmt->dbc->flight)
+      flight_error(stmt->dbc, stmt, stmt->error.sqlstate,
+                   stmt->error.native_error);
+
+    return rc;
 }
 
 
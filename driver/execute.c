@@ -28,6 +28,7 @@
 */
 
 #include "driver.h"
+#include "catalog.h"
 #include <locale.h>
 
 
@@ -39,6 +40,9 @@
 SQLRETURN do_query(STMT *stmt,char *query, SQLULEN query_length)
 {
     int error= SQL_ERROR, native_error= 0;
+    ulonglong query_start= 0, slow_elapsed= 0;
+    char *exec_query;
+    SQLULEN exec_length;
 
     if (!query)
     {
@@ -63,8 +67,27 @@ SQLRETURN do_query(STMT *stmt,char *query, SQLULEN query_length)
       query_length= strlen(query);
     }
 
+    /* Direct execution may use a rewrite of the query */
+    exec_query= query;
+    exec_length= query_length;
+
     MYLOG_QUERY(stmt, query);
-    myodbc_mutex_lock(&stmt->dbc->lock);
+
+    /* Wait for a slot before taking the connection lock */
+    if (stmt->dbc->admission &&
+        admission_enter(stmt->dbc->admission, stmt->dbc->ds->queue_timeout))
+    {
+      set_stmt_error(stmt, "HYT00", "Timeout expired waiting for the "
+                     "MAX_QUERIES limit of the server", 0);
+      goto skip_unlock_exit;
+    }
+
+    flight_mutex_lock(stmt->dbc, stmt);
+    FLIGHT_RECORD(stmt->dbc, stmt, FE_QUERY_START, 0, query_length);
+    if (stmt->dbc->flight || stmt->dbc->ds->slow_query_ms)
+    {
+      query_start= myodbc_micro_time();
+    }
 
     if ( check_if_server_is_alive( stmt->dbc ) )
     {
@@ -101,7 +124,8 @@ SQLRETURN do_query(STMT *stmt,char *query, SQLULEN query_length)
       scroller_move(stmt);
       MYLOG_QUERY(stmt, stmt->scroller.query);
 
-      native_error= mysql_real_query(&stmt->dbc->mysql, stmt->scroller.query,
+      native_error= full_result_metadata(stmt->dbc) ||
+                    mysql_real_query(&stmt->dbc->mysql, stmt->scroller.query,
                                   (unsigned long)stmt->scroller.query_len);
     }
       /* Not using ssps for scroller so far. Relaxing a bit condition
@@ -109,8 +133,26 @@ SQLRETURN do_query(STMT *stmt,char *query, SQLULEN query_length)
        this is a batch of queries */
     else if (ssps_used(stmt))
     {
-      native_error= mysql_stmt_bind_param(stmt->ssps,
+      ulonglong bind_sig= ssps_param_bind_signature(stmt);
+
+      /* Result of prepared statement always comes with metadata */
+      if (full_result_metadata(stmt->dbc))
+      {
+        set_stmt_error(stmt, "HY000", mysql_error(&stmt->dbc->mysql),
+                       mysql_errno(&stmt->dbc->mysql));
+        translate_error(stmt->error.sqlstate, MYERR_S1000,
+                        mysql_errno(&stmt->dbc->mysql));
+        goto exit;
+      }
+
+      /* Re-executing with the same buffers does not need new bind */
+      if (bind_sig != stmt->param_bind_sig)
+      {
+        native_error= mysql_stmt_bind_param(stmt->ssps,
                                         (MYSQL_BIND*)stmt->param_bind->buffer);
+        stmt->param_bind_sig= native_error == 0 ? bind_sig : 0;
+      }
+
       if (native_error == 0)
       {
         native_error= mysql_stmt_execute(stmt->ssps);
@@ -134,10 +176,15 @@ SQLRETURN do_query(STMT *stmt,char *query, SQLULEN query_length)
       /* Need to close ps handler if it is open as our relsult will be generated
          by direct execution. and ps handler may create some chaos */
       ssps_close(stmt);
-      native_error= mysql_real_query(&stmt->dbc->mysql,query,query_length);
+      exec_query= max_length_query(stmt, query, &exec_length);
+      native_error= metadata_cache_before_exec(stmt, exec_query, exec_length) ||
+                    mysql_real_query(&stmt->dbc->mysql, exec_query,
+                                     (unsigned long)exec_length);
     }
 
     MYLOG_QUERY(stmt, "query has been executed");
+    pool_track_session(stmt, query, query_length);
+    metadata_cache_track(stmt);
 
     if (native_error)
     {
@@ -169,6 +216,28 @@ SQLRETURN do_query(STMT *stmt,char *query, SQLULEN query_length)
       }
     }
 
+    if (!ssps_used(stmt) && metadata_cache_after_exec(stmt, exec_query,
+                                                      exec_length))
+    {
+      /* The table has changed since the definitions were cached, so the
+         query is executed again and its metadata is cached anew */
+      free_current_result(stmt);
+      if (full_result_metadata(stmt->dbc) ||
+          mysql_real_query(&stmt->dbc->mysql, exec_query,
+                           (unsigned long)exec_length) ||
+          !get_result_metadata(stmt, FALSE))
+      {
+        set_stmt_error(stmt, "HY000", mysql_error(&stmt->dbc->mysql),
+                       mysql_errno(&stmt->dbc->mysql));
+        translate_error(stmt->error.sqlstate, MYERR_S1000,
+                        mysql_errno(&stmt->dbc->mysql));
+        goto exit;
+      }
+      metadata_cache_after_exec(stmt, exec_query, exec_length);
+    }
+
+    max_length_fix_fields(stmt, exec_query);
+
     /* If the only resultset is OUT params, then we can only detect
        corresponding server_status right after execution.
        If the RS is OUT params - we do not need to do store_result obviously */
@@ -196,13 +265,38 @@ SQLRETURN do_query(STMT *stmt,char *query, SQLULEN query_length)
       /* Caching row counts for queries returning resultset as well */
       //update_affected_rows(stmt);
       fix_result_types(stmt);
+      read_ahead_start(stmt);
     }
 
     error= SQL_SUCCESS;
 
+    if (stmt->dbc->ds->slow_query_ms && is_select_statement(&stmt->query))
+    {
+      ulonglong elapsed= myodbc_micro_time() - query_start;
+
+      if (elapsed >= (ulonglong)stmt->dbc->ds->slow_query_ms * 1000)
+      {
+        slow_elapsed= elapsed;
+      }
+    }
+
 exit:
+    stmt->dbc->alive_time= SQL_SUCCEEDED(error) ? time(NULL) : 0;
+    FLIGHT_RECORD(stmt->dbc, stmt, FE_QUERY_END, native_error,
+                  myodbc_micro_time() - query_start);
     myodbc_mutex_unlock(&stmt->dbc->lock);
 
+    if (stmt->dbc->admission)
+    {
+      admission_leave(stmt->dbc->admission);
+    }
+
+    /* EXPLAIN takes a round trip, the connection is not held meanwhile */
+    if (slow_elapsed)
+    {
+      slow_query_record(stmt, query, query_length, slow_elapsed);
+    }
+
 skip_unlock_exit:
     if (query != GET_QUERY(&stmt->query))
     {
@@ -1207,6 +1301,8 @@ SQLRETURN insert_param(STMT *stmt, uchar *place4param, DESC* apd,
       }
       else
       {
+        long plain= 0;
+
         to= add_to_buffer(net,to,"'",1);
         /* Make sure we have room for a fully-escaped string. */
         if ( !(to= extend_buffer(net, to, length * 2)) )
@@ -1214,7 +1310,16 @@ SQLRETURN insert_param(STMT *stmt, uchar *place4param, DESC* apd,
           goto memerror;
         }
 
-        to+= mysql_real_escape_string(&dbc->mysql, to, data, length);
+        /* The leading run that needs no escaping is copied as is */
+        if (my_charset_is_ascii_based(dbc->mysql.charset))
+        {
+          plain= (long)myodbc_kernels.plain_span(data, length);
+          memcpy(to, data, plain);
+          to+= plain;
+        }
+
+        to+= mysql_real_escape_string(&dbc->mysql, to, data + plain,
+                                      length - plain);
         to= add_to_buffer(net, to, "'", 1);
       }
     }
@@ -1329,6 +1434,57 @@ BOOL map_error_to_param_status( SQLUSMALLINT *param_status_ptr, SQLRETURN rc)
   exist in the statement
 */
 
+static MYSQL_FIELD local_probe_fields[]=
+{
+  MYODBC_FIELD_LONGLONG("1", NOT_NULL_FLAG | BINARY_FLAG | NUM_FLAG),
+  MYODBC_FIELD_STRING("@@version", 60, 0),
+  MYODBC_FIELD_STRING("VERSION()", 60, NOT_NULL_FLAG)
+};
+
+
+/**
+  LOCAL_PROBES: answers a connection validation query with a result set
+  made by the driver, if a query succeeded on the connection within the
+  last LOCAL_PROBE_ALIVE seconds. Otherwise the query goes to the server
+  and checks the connection as before.
+
+  @return TRUE if the statement has been answered
+*/
+static BOOL answer_local_probe(STMT *stmt, SQLRETURN *rc)
+{
+  DBC *dbc= stmt->dbc;
+  LOCAL_PROBE_ENUM probe;
+  MYSQL_FIELD *field;
+  char *row[1];
+
+  if (!dbc->ds->local_probes || ssps_used(stmt) || stmt->apd->array_size > 1
+    || time(NULL) - dbc->alive_time >= LOCAL_PROBE_ALIVE)
+  {
+    return FALSE;
+  }
+
+  switch ((probe= local_probe_type(&stmt->query)))
+  {
+    case myprobeOne:
+      row[0]= "1";
+      field= &local_probe_fields[0];
+      break;
+    case myprobeVersion:
+      row[0]= (char *)mysql_get_server_info(&dbc->mysql);
+      field= &local_probe_fields[myodbc_casecmp(get_token(&stmt->query, 1),
+                                                "VERSION", 7) ? 1 : 2];
+      break;
+    default:
+      return FALSE;
+  }
+
+  MYLOG_QUERY(stmt, "Validation query answered locally");
+
+  *rc= create_fake_resultset(stmt, row, sizeof(row), 1, field, 1);
+  return TRUE;
+}
+
+
 SQLRETURN my_SQLExecute( STMT *pStmt )
 {
   char       *query, *cursor_pos;
@@ -1385,6 +1541,16 @@ SQLRETURN my_SQLExecute( STMT *pStmt )
 
   is_select_stmt= is_select_statement(&pStmt->query);
 
+  if (is_select_stmt && answer_local_probe(pStmt, &rc))
+  {
+    return rc;
+  }
+
+  if (pStmt->ssps_policy == SSPS_POLICY_UNDECIDED)
+  {
+    ssps_adapt_before_exec(pStmt, is_select_stmt);
+  }
+
   /* if ssps is used for select query then convert it to non ssps
    single statement using UNION
   */
@@ -1607,6 +1773,11 @@ SQLRETURN my_SQLExecute( STMT *pStmt )
     }
   }
 
+  if (SQL_SUCCEEDED(rc))
+  {
+    ssps_adapt_after_exec(pStmt);
+  }
+
   if (pStmt->dummy_state == ST_DUMMY_PREPARED)
       pStmt->dummy_state= ST_DUMMY_EXECUTED;
 
@@ -1807,6 +1978,9 @@ SQLRETURN SQL_API SQLParamData(SQLHSTMT hstmt, SQLPOINTER *prbgValue)
         return SQL_ERROR;
       }
 
+      /* do_query must not bind again - that would drop the long data */
+      stmt->param_bind_sig= ssps_param_bind_signature(stmt);
+
       /* Do all stuff for stmt->send_data_param as a dae */
       return SQL_NEED_DATA;
     }
@@ -87,6 +87,7 @@ SQLRETURN SQL_API my_SQLAllocEnv(SQLHENV *phenv)
     }
 #endif /* _UNIX_ */
     myodbc_mutex_init(&(*env)->lock,NULL);
+    worker_pool_attach();
 
 #ifndef USE_IODBC
     ((ENV *) *phenv)->odbc_ver= SQL_OV_ODBC3_80;
@@ -120,6 +121,7 @@ SQLRETURN SQL_API my_SQLFreeEnv(SQLHENV henv)
 {
     ENV *env= (ENV *) henv;
     myodbc_mutex_destroy(&env->lock);
+    worker_pool_detach();
 #ifndef _UNIX_
     GlobalUnlock(GlobalHandle((HGLOBAL) henv));
     GlobalFree(GlobalHandle((HGLOBAL) henv));
@@ -261,6 +263,7 @@ SQLRETURN SQL_API my_SQLAllocConnect(SQLHENV henv, SQLHDBC *phdbc)
     dbc->exp_desc= NULL;
     dbc->sql_select_limit= (SQLULEN) -1;
     myodbc_mutex_init(&dbc->lock,NULL);
+    myodbc_mutex_init(&dbc->explain_lock,NULL);
     myodbc_mutex_lock(&dbc->lock);
     myodbc_ov_init(penv->odbc_ver); /* Initialize based on ODBC version */
     myodbc_mutex_unlock(&dbc->lock);
@@ -310,10 +313,62 @@ int reset_connection(DBC *dbc)
 }
 
 
+/* The session is back to defaults and in the DSN database */
+static void wakeup_done(DBC *dbc)
+{
+  DataSource *ds= dbc->ds;
+
+  dbc->need_to_wakeup= 0;
+  /* resultset_metadata is back to default as well */
+  dbc->metadata_none= FALSE;
+  dbc->session_dirty= FALSE;
+  ++dbc->schema_version;
+
+  if (ds->database)
+  {
+    x_free(dbc->database);
+    dbc->database= myodbc_strdup(ds->database8, MYF(MY_WME));
+  }
+}
+
+
 int wakeup_connection(DBC *dbc)
 {
   DataSource *ds= dbc->ds;
 
+  /* Deferred connection has no session state to reset */
+  if (dbc->need_to_connect)
+  {
+    dbc->need_to_wakeup= 0;
+    return 0;
+  }
+
+#if MYSQL_VERSION_ID >= 50703
+  /*
+    Resetting the session keeps the authenticated connection, so the auth
+    plugin (SCRAM key derivation for mongosql_auth) does not run again.
+    mysql_change_user() is the fallback for servers that do not support it.
+    The reset does not run the init command, and the character set and
+    session variables are back to server defaults, so set them up again.
+  */
+  if (!mysql_reset_connection(&dbc->mysql))
+  {
+    dbc->metadata_none= FALSE;
+
+    if ((!ds->initstmt || !ds->initstmt[0] ||
+         odbc_stmt(dbc, ds_get_utf8attr(ds->initstmt, &ds->initstmt8),
+                   SQL_NTS, TRUE) == SQL_SUCCESS) &&
+        SQL_SUCCEEDED(myodbc_init_session(dbc, ds)) &&
+        (!ds->database ||
+         !mysql_select_db(&dbc->mysql, ds_get_utf8attr(ds->database,
+                                                        &ds->database8))))
+    {
+      wakeup_done(dbc);
+      return 0;
+    }
+  }
+#endif
+
   if (mysql_change_user(&dbc->mysql, ds_get_utf8attr(ds->uid, &ds->uid8),
                                      ds_get_utf8attr(ds->pwd, &ds->pwd8),
                                      ds_get_utf8attr(ds->database, &ds->database8)))
@@ -321,7 +376,14 @@ int wakeup_connection(DBC *dbc)
     return 1;
   }
 
-  dbc->need_to_wakeup= 0;
+  /* Without a database in the DSN the new session has none selected */
+  if (!ds->database)
+  {
+    x_free(dbc->database);
+    dbc->database= NULL;
+  }
+
+  wakeup_done(dbc);
   return 0;
 }
 
@@ -345,6 +407,7 @@ SQLRETURN SQL_API my_SQLFreeConnect(SQLHDBC hdbc)
       ds_delete(dbc->ds);
     }
     myodbc_mutex_destroy(&dbc->lock);
+    myodbc_mutex_destroy(&dbc->explain_lock);
 
     free_explicit_descriptors(dbc);
 
@@ -472,6 +535,8 @@ SQLRETURN SQL_API my_SQLAllocStmt(SQLHDBC hdbc,SQLHSTMT *phstmt)
   /* In fact it should be awaken when DM checks whether connection is alive before taking it from pool.
     Keeping the check here to stay on the safe side */
   WAKEUP_CONN_IF_NEEDED(dbc);
+  /* Everything done with a statement handle may need the server */
+  CONNECT_IF_NEEDED(dbc);
 
 #ifndef _UNIX_
   hstmt= GlobalAlloc(GMEM_MOVEABLE | GMEM_ZEROINIT, sizeof(STMT));
@@ -599,6 +664,8 @@ SQLRETURN SQL_API my_SQLFreeStmtExtended(SQLHSTMT hstmt,SQLUSMALLINT fOption,
       return SQL_SUCCESS;
     }
 
+    read_ahead_stop(stmt);
+
     if (stmt->out_params_state == OPS_STREAMS_PENDING)
     {
       /* Magical out params fetch */
@@ -708,6 +775,8 @@ SQLRETURN SQL_API my_SQLFreeStmtExtended(SQLHSTMT hstmt,SQLUSMALLINT fOption,
     /* At this point, only MYSQL_RESET and SQL_DROP left out */
     reset_parsed_query(&stmt->orig_query, NULL, NULL, NULL);
     reset_parsed_query(&stmt->query, NULL, NULL, NULL);
+    metadata_cache_free(stmt);
+    max_length_cache_free(stmt);
 
     if (stmt->param_bind != NULL)
     {
@@ -867,6 +936,14 @@ SQLRETURN SQL_API SQLAllocHandle(SQLSMALLINT HandleType,
             error= my_SQLAllocDesc(InputHandle, OutputHandlePtr);
             break;
 
+#ifdef MYODBC_DRIVER_AWARE_POOLING
+        case SQL_HANDLE_DBC_INFO_TOKEN:
+            CHECK_HANDLE(InputHandle);
+            CHECK_DBC_OUTPUT(InputHandle, OutputHandlePtr);
+            error= my_SQLAllocDbcInfoToken(InputHandle, OutputHandlePtr);
+            break;
+#endif
+
         default:
             return set_conn_error(InputHandle,MYERR_S1C00,NULL,0);
     }
@@ -931,6 +1008,12 @@ SQLRETURN SQL_API SQLFreeHandle(SQLSMALLINT HandleType,
             error= my_SQLFreeDesc((DESC *) Handle);
             break;
 
+#ifdef MYODBC_DRIVER_AWARE_POOLING
+        case SQL_HANDLE_DBC_INFO_TOKEN:
+            error= my_SQLFreeDbcInfoToken(Handle);
+            break;
+#endif
+
 
         default:
             break;
@@ -77,6 +77,25 @@ MySQLGetInfo(SQLHDBC hdbc, SQLUSMALLINT fInfoType,
   if (!num_info)
     num_info= &dummy_value;
 
+  /* Only these depend on the server, so only they force a deferred connect */
+  switch (fInfoType) {
+  case SQL_COLLATION_SEQ:
+  case SQL_CREATE_VIEW:
+  case SQL_DATABASE_NAME:
+  case SQL_DBMS_VER:
+  case SQL_DROP_VIEW:
+  case SQL_INFO_SCHEMA_VIEWS:
+  case SQL_KEYWORDS:
+  case SQL_MAX_INDEX_SIZE:
+  case SQL_MAX_STATEMENT_LEN:
+  case SQL_MAX_TABLES_IN_SELECT:
+  case SQL_PROCEDURE_TERM:
+  case SQL_PROCEDURES:
+  case SQL_SERVER_NAME:
+    CONNECT_IF_NEEDED(dbc);
+    break;
+  }
+
   switch (fInfoType) {
   case SQL_ACTIVE_ENVIRONMENTS:
     MYINFO_SET_USHORT(0);
@@ -263,6 +282,11 @@ MySQLGetInfo(SQLHDBC hdbc, SQLUSMALLINT fInfoType,
     MYINFO_SET_STR("libmdbodbc5a.so");
 # endif
 #endif
+#ifdef MYODBC_DRIVER_AWARE_POOLING
+  case SQL_DRIVER_AWARE_POOLING_SUPPORTED:
+    MYINFO_SET_ULONG(SQL_DRIVER_AWARE_POOLING_CAPABLE);
+#endif
+
   case SQL_DRIVER_ODBC_VER:
     MYINFO_SET_STR("03.80");               /* What standard we implement */
 
@@ -0,0 +1,638 @@
+/*
+  Copyright (c) 2000, 2014, Oracle and/or its affiliates. All rights reserved.
+
+  The MySQL Connector/ODBC is licensed under the terms of the GPLv2
+  <http://www.gnu.org/licenses/old-licenses/gpl-2.0.html>, like most
+  MySQL Connectors. There are special exceptions to the terms and
+  conditions of the GPLv2 as it is applied to this software, see the
+  FLOSS License Exception
+  <http://www.mysql.com/about/legal/licensing/foss-exception.html>.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published
+  by the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+  for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/**
+  @file  kernels.c
+  @brief Hot loops for several instruction set tiers and their dispatch.
+
+  The driver is built for the baseline CPU, so the vector implementations
+  are compiled for their own targets and only called if the CPU has been
+  found to support them.
+*/
+
+#include "driver.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define KERNELS_X86
+# define KERNEL_TARGET(T) __attribute__((target(T)))
+# include <immintrin.h>
+# if __GNUC__ >= 5 || (defined(__clang__) && __clang_major__ >= 4)
+#  define KERNELS_AVX512
+# endif
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+# define KERNELS_X86
+# define KERNEL_TARGET(T)
+# include <intrin.h>
+# include <immintrin.h>
+# if _MSC_VER >= 1910
+#  define KERNELS_AVX512
+# endif
+#endif
+
+#define KERNEL_HIGH_BITS 0x8080808080808080ULL
+
+static const char *kernel_tier_names[]= {"scalar", "sse2", "avx2", "avx512"};
+static const char kernel_hex_digits[]= "0123456789ABCDEF";
+
+
+/* ------------------------------ scalar ---------------------------------- */
+
+static size_t ascii_span_scalar(const char *src, size_t len)
+{
+  size_t i= 0;
+  unsigned long long word;
+
+  for (; i + sizeof(word) <= len; i+= sizeof(word))
+  {
+    memcpy(&word, src + i, sizeof(word));
+    if (word & KERNEL_HIGH_BITS)
+    {
+      break;
+    }
+  }
+
+  while (i < len && !(src[i] & 0x80))
+  {
+    ++i;
+  }
+
+  return i;
+}
+
+
+/* Same set of characters as mysql_real_escape_string() escapes */
+static my_bool plain_char(char c)
+{
+  switch (c)
+  {
+    case 0:
+    case '\n':
+    case '\r':
+    case '\\':
+    case '\'':
+    case '"':
+    case '\032':
+      return FALSE;
+  }
+
+  return !(c & 0x80);
+}
+
+
+static size_t plain_span_scalar(const char *src, size_t len)
+{
+  size_t i= 0;
+
+  while (i < len && plain_char(src[i]))
+  {
+    ++i;
+  }
+
+  return i;
+}
+
+
+static size_t digit_span_scalar(const char *src, size_t len)
+{
+  size_t i= 0;
+
+  while (i < len && src[i] >= '0' && src[i] <= '9')
+  {
+    ++i;
+  }
+
+  return i;
+}
+
+
+static void ascii_to_wchar_scalar(SQLWCHAR *to, const char *src, size_t len)
+{
+  while (len--)
+  {
+    *to++= (SQLWCHAR)(uchar)*src++;
+  }
+}
+
+
+static char * hex_encode_scalar(char *to, const char *src, size_t len)
+{
+  const uchar *from= (const uchar *)src, *end= from + len;
+
+  for (; from < end; ++from)
+  {
+    *to++= kernel_hex_digits[*from >> 4];
+    *to++= kernel_hex_digits[*from & 15];
+  }
+
+  return to;
+}
+
+
+MYODBC_KERNELS myodbc_kernels=
+{
+  MYODBC_CPU_SCALAR, "scalar",
+  ascii_span_scalar, plain_span_scalar, digit_span_scalar,
+  ascii_to_wchar_scalar, hex_encode_scalar
+};
+
+
+#ifdef KERNELS_X86
+
+static unsigned int kernel_ctz(unsigned int mask)
+{
+#ifdef _MSC_VER
+  unsigned long pos;
+  _BitScanForward(&pos, mask);
+  return (unsigned int)pos;
+#else
+  return (unsigned int)__builtin_ctz(mask);
+#endif
+}
+
+
+/* ------------------------------- sse2 ----------------------------------- */
+
+KERNEL_TARGET("sse2")
+static size_t ascii_span_sse2(const char *src, size_t len)
+{
+  size_t i= 0;
+
+  for (; i + 16 <= len; i+= 16)
+  {
+    int mask= _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(src + i)));
+
+    if (mask)
+    {
+      return i + kernel_ctz(mask);
+    }
+  }
+
+  return i + ascii_span_scalar(src + i, len - i);
+}
+
+
+KERNEL_TARGET("sse2")
+static size_t plain_span_sse2(const char *src, size_t len)
+{
+  size_t i= 0;
+
+  for (; i + 16 <= len; i+= 16)
+  {
+    __m128i v= _mm_loadu_si128((const __m128i *)(src + i));
+    __m128i special= _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_setzero_si128()),
+                   _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+                   _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))));
+    int mask;
+
+    special= _mm_or_si128(special,
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\'')),
+                   _mm_cmpeq_epi8(v, _mm_set1_epi8('"'))));
+    special= _mm_or_si128(special, _mm_cmpeq_epi8(v, _mm_set1_epi8('\032')));
+
+    /* Bytes >= 0x80 have the sign bit set already */
+    if ((mask= _mm_movemask_epi8(_mm_or_si128(special, v))))
+    {
+      return i + kernel_ctz(mask);
+    }
+  }
+
+  return i + plain_span_scalar(src + i, len - i);
+}
+
+
+KERNEL_TARGET("sse2")
+static size_t digit_span_sse2(const char *src, size_t len)
+{
+  size_t i= 0;
+
+  for (; i + 16 <= len; i+= 16)
+  {
+    __m128i v= _mm_loadu_si128((const __m128i *)(src + i));
+    /* Signed compare puts bytes >= 0x80 below '0' */
+    int mask= _mm_movemask_epi8(
+      _mm_or_si128(_mm_cmplt_epi8(v, _mm_set1_epi8('0')),
+                   _mm_cmpgt_epi8(v, _mm_set1_epi8('9'))));
+
+    if (mask)
+    {
+      return i + kernel_ctz(mask);
+    }
+  }
+
+  return i + digit_span_scalar(src + i, len - i);
+}
+
+
+KERNEL_TARGET("sse2")
+static void ascii_to_wchar_sse2(SQLWCHAR *to, const char *src, size_t len)
+{
+  const __m128i zero= _mm_setzero_si128();
+  size_t i= 0;
+
+  for (; i + 16 <= len; i+= 16, to+= 16)
+  {
+    __m128i v= _mm_loadu_si128((const __m128i *)(src + i));
+    __m128i lo= _mm_unpacklo_epi8(v, zero), hi= _mm_unpackhi_epi8(v, zero);
+
+    if (sizeof(SQLWCHAR) == 2)
+    {
+      _mm_storeu_si128((__m128i *)to, lo);
+      _mm_storeu_si128((__m128i *)(to + 8), hi);
+    }
+    else
+    {
+      _mm_storeu_si128((__m128i *)to, _mm_unpacklo_epi16(lo, zero));
+      _mm_storeu_si128((__m128i *)(to + 4), _mm_unpackhi_epi16(lo, zero));
+      _mm_storeu_si128((__m128i *)(to + 8), _mm_unpacklo_epi16(hi, zero));
+      _mm_storeu_si128((__m128i *)(to + 12), _mm_unpackhi_epi16(hi, zero));
+    }
+  }
+
+  ascii_to_wchar_scalar(to, src + i, len - i);
+}
+
+
+KERNEL_TARGET("sse2")
+static char * hex_encode_sse2(char *to, const char *src, size_t len)
+{
+  const __m128i low= _mm_set1_epi8(0x0f), nine= _mm_set1_epi8(9),
+                digit0= _mm_set1_epi8('0'), gap= _mm_set1_epi8('A' - '0' - 10);
+  size_t i= 0;
+
+  for (; i + 16 <= len; i+= 16, to+= 32)
+  {
+    __m128i v= _mm_loadu_si128((const __m128i *)(src + i));
+    __m128i hi= _mm_and_si128(_mm_srli_epi16(v, 4), low);
+    __m128i lo= _mm_and_si128(v, low);
+
+    /* '0' + n, and the gap up to 'A' for n > 9 */
+    hi= _mm_add_epi8(_mm_add_epi8(hi, digit0),
+                     _mm_and_si128(_mm_cmpgt_epi8(hi, nine), gap));
+    lo= _mm_add_epi8(_mm_add_epi8(lo, digit0),
+                     _mm_and_si128(_mm_cmpgt_epi8(lo, nine), gap));
+
+    _mm_storeu_si128((__m128i *)to, _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128((__m128i *)(to + 16), _mm_unpackhi_epi8(hi, lo));
+  }
+
+  return hex_encode_scalar(to, src + i, len - i);
+}
+
+
+/* ------------------------------- avx2 ----------------------------------- */
+
+KERNEL_TARGET("avx2")
+static size_t ascii_span_avx2(const char *src, size_t len)
+{
+  size_t i= 0;
+
+  for (; i + 32 <= len; i+= 32)
+  {
+    unsigned int mask= (unsigned int)_mm256_movemask_epi8(
+      _mm256_loadu_si256((const __m256i *)(src + i)));
+
+    if (mask)
+    {
+      return i + kernel_ctz(mask);
+    }
+  }
+
+  return i + ascii_span_sse2(src + i, len - i);
+}
+
+
+KERNEL_TARGET("avx2")
+static size_t plain_span_avx2(const char *src, size_t len)
+{
+  size_t i= 0;
+
+  for (; i + 32 <= len; i+= 32)
+  {
+    __m256i v= _mm256_loadu_si256((const __m256i *)(src + i));
+    __m256i special= _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_setzero_si256()),
+                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')),
+                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))));
+    unsigned int mask;
+
+    special= _mm256_or_si256(special,
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\'')),
+                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))));
+    special= _mm256_or_si256(special,
+                             _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\032')));
+
+    if ((mask= (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(special, v))))
+    {
+      return i + kernel_ctz(mask);
+    }
+  }
+
+  return i + plain_span_sse2(src + i, len - i);
+}
+
+
+KERNEL_TARGET("avx2")
+static size_t digit_span_avx2(const char *src, size_t len)
+{
+  size_t i= 0;
+
+  for (; i + 32 <= len; i+= 32)
+  {
+    __m256i v= _mm256_loadu_si256((const __m256i *)(src + i));
+    unsigned int mask= (unsigned int)_mm256_movemask_epi8(
+      _mm256_or_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8('0'), v),
+                      _mm256_cmpgt_epi8(v, _mm256_set1_epi8('9'))));
+
+    if (mask)
+    {
+      return i + kernel_ctz(mask);
+    }
+  }
+
+  return i + digit_span_sse2(src + i, len - i);
+}
+
+
+KERNEL_TARGET("avx2")
+static void ascii_to_wchar_avx2(SQLWCHAR *to, const char *src, size_t len)
+{
+  size_t i= 0;
+
+  if (sizeof(SQLWCHAR) == 2)
+  {
+    for (; i + 16 <= len; i+= 16, to+= 16)
+    {
+      _mm256_storeu_si256((__m256i *)to, _mm256_cvtepu8_epi16(
+        _mm_loadu_si128((const __m128i *)(src + i))));
+    }
+  }
+  else
+  {
+    for (; i + 8 <= len; i+= 8, to+= 8)
+    {
+      _mm256_storeu_si256((__m256i *)to, _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64((const __m128i *)(src + i))));
+    }
+  }
+
+  ascii_to_wchar_scalar(to, src + i, len - i);
+}
+
+
+KERNEL_TARGET("avx2")
+static char * hex_encode_avx2(char *to, const char *src, size_t len)
+{
+  const __m256i low= _mm256_set1_epi8(0x0f), nine= _mm256_set1_epi8(9),
+                digit0= _mm256_set1_epi8('0'),
+                gap= _mm256_set1_epi8('A' - '0' - 10);
+  size_t i= 0;
+
+  for (; i + 32 <= len; i+= 32, to+= 64)
+  {
+    __m256i v= _mm256_loadu_si256((const __m256i *)(src + i));
+    __m256i hi= _mm256_and_si256(_mm256_srli_epi16(v, 4), low);
+    __m256i lo= _mm256_and_si256(v, low);
+    __m256i first, second;
+
+    hi= _mm256_add_epi8(_mm256_add_epi8(hi, digit0),
+                        _mm256_and_si256(_mm256_cmpgt_epi8(hi, nine), gap));
+    lo= _mm256_add_epi8(_mm256_add_epi8(lo, digit0),
+                        _mm256_and_si256(_mm256_cmpgt_epi8(lo, nine), gap));
+
+    /* Unpacking works within 128 bit lanes, the halves are put in order */
+    first= _mm256_unpacklo_epi8(hi, lo);
+    second= _mm256_unpackhi_epi8(hi, lo);
+    _mm256_storeu_si256((__m256i *)to,
+                        _mm256_permute2x128_si256(first, second, 0x20));
+    _mm256_storeu_si256((__m256i *)(to + 32),
+                        _mm256_permute2x128_si256(first, second, 0x31));
+  }
+
+  return hex_encode_sse2(to, src + i, len - i);
+}
+
+
+/* ------------------------------ avx512 ---------------------------------- */
+
+#ifdef KERNELS_AVX512
+
+static unsigned int kernel_ctz64(unsigned long long mask)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+  unsigned long pos;
+  _BitScanForward64(&pos, mask);
+  return (unsigned int)pos;
+#elif defined(_MSC_VER)
+  return (unsigned int)mask ? kernel_ctz((unsigned int)mask)
+                            : 32 + kernel_ctz((unsigned int)(mask >> 32));
+#else
+  return (unsigned int)__builtin_ctzll(mask);
+#endif
+}
+
+
+KERNEL_TARGET("avx512f,avx512bw")
+static size_t ascii_span_avx512(const char *src, size_t len)
+{
+  size_t i= 0;
+
+  for (; i + 64 <= len; i+= 64)
+  {
+    unsigned long long mask= _mm512_movepi8_mask(
+      _mm512_loadu_si512((const void *)(src + i)));
+
+    if (mask)
+    {
+      return i + kernel_ctz64(mask);
+    }
+  }
+
+  return i + ascii_span_avx2(src + i, len - i);
+}
+
+
+KERNEL_TARGET("avx512f,avx512bw")
+static size_t plain_span_avx512(const char *src, size_t len)
+{
+  size_t i= 0;
+
+  for (; i + 64 <= len; i+= 64)
+  {
+    __m512i v= _mm512_loadu_si512((const void *)(src + i));
+    unsigned long long mask= _mm512_movepi8_mask(v)
+      | _mm512_cmpeq_epi8_mask(v, _mm512_setzero_si512())
+      | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\n'))
+      | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\r'))
+      | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\\'))
+      | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\''))
+      | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('"'))
+      | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\032'));
+
+    if (mask)
+    {
+      return i + kernel_ctz64(mask);
+    }
+  }
+
+  return i + plain_span_avx2(src + i, len - i);
+}
+
+
+KERNEL_TARGET("avx512f,avx512bw")
+static size_t digit_span_avx512(const char *src, size_t len)
+{
+  size_t i= 0;
+
+  for (; i + 64 <= len; i+= 64)
+  {
+    __m512i v= _mm512_loadu_si512((const void *)(src + i));
+    unsigned long long mask= _mm512_cmplt_epi8_mask(v, _mm512_set1_epi8('0'))
+                           | _mm512_cmpgt_epi8_mask(v, _mm512_set1_epi8('9'));
+
+    if (mask)
+    {
+      return i + kernel_ctz64(mask);
+    }
+  }
+
+  return i + digit_span_avx2(src + i, len - i);
+}
+
+#endif /* KERNELS_AVX512 */
+
+
+/* Best tier supported by both the CPU and the OS */
+static enum myodbc_cpu_tier kernels_probe(void)
+{
+#if defined(__GNUC__)
+  __builtin_cpu_init();
+
+# ifdef KERNELS_AVX512
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+    return MYODBC_CPU_AVX512;
+# endif
+  if (__builtin_cpu_supports("avx2"))
+    return MYODBC_CPU_AVX2;
+  if (__builtin_cpu_supports("sse2"))
+    return MYODBC_CPU_SSE2;
+#else
+  int info[4], max_leaf;
+  unsigned long long xcr0= 0;
+  my_bool sse2, avx, avx2= FALSE, avx512= FALSE;
+
+  __cpuid(info, 0);
+  max_leaf= info[0];
+
+  __cpuid(info, 1);
+  sse2= (info[3] >> 26) & 1;
+  avx= (info[2] >> 28) & 1;
+  /* The OS has to save the vector registers */
+  if ((info[2] >> 27) & 1)
+    xcr0= _xgetbv(0);
+
+  if (max_leaf >= 7)
+  {
+    __cpuidex(info, 7, 0);
+    avx2= (info[1] >> 5) & 1;
+    avx512= ((info[1] >> 16) & 1) && ((info[1] >> 30) & 1);
+  }
+
+# ifdef KERNELS_AVX512
+  if (avx512 && (xcr0 & 0xe6) == 0xe6)
+    return MYODBC_CPU_AVX512;
+# endif
+  if (avx && avx2 && (xcr0 & 6) == 6)
+    return MYODBC_CPU_AVX2;
+  if (sse2)
+    return MYODBC_CPU_SSE2;
+#endif
+
+  return MYODBC_CPU_SCALAR;
+}
+
+#endif /* KERNELS_X86 */
+
+
+/*
+  Chooses implementations of the kernels for the CPU. MYODBC_CPU_TIER may
+  only lower the tier, a tier the CPU does not support would crash.
+*/
+void myodbc_kernels_init(void)
+{
+  enum myodbc_cpu_tier tier= MYODBC_CPU_SCALAR;
+  const char *forced= getenv("MYODBC_CPU_TIER");
+  int i;
+
+#ifdef KERNELS_X86
+  tier= kernels_probe();
+#endif
+
+  if (forced)
+  {
+    for (i= MYODBC_CPU_SCALAR; i <= MYODBC_CPU_AVX512; ++i)
+    {
+      if (!myodbc_strcasecmp(forced, kernel_tier_names[i]))
+      {
+        tier= myodbc_min(tier, (enum myodbc_cpu_tier)i);
+        break;
+      }
+    }
+  }
+
+#ifdef KERNELS_X86
+  if (tier >= MYODBC_CPU_SSE2)
+  {
+    myodbc_kernels.ascii_span= ascii_span_sse2;
+    myodbc_kernels.plain_span= plain_span_sse2;
+    myodbc_kernels.digit_span= digit_span_sse2;
+    myodbc_kernels.ascii_to_wchar= ascii_to_wchar_sse2;
+    myodbc_kernels.hex_encode= hex_encode_sse2;
+  }
+
+  if (tier >= MYODBC_CPU_AVX2)
+  {
+    myodbc_kernels.ascii_span= ascii_span_avx2;
+    myodbc_kernels.plain_span= plain_span_avx2;
+    myodbc_kernels.digit_span= digit_span_avx2;
+    myodbc_kernels.ascii_to_wchar= ascii_to_wchar_avx2;
+    myodbc_kernels.hex_encode= hex_encode_avx2;
+  }
+
+# ifdef KERNELS_AVX512
+  /* Widening and hex stay with avx2, they are bound by stores anyway */
+  if (tier >= MYODBC_CPU_AVX512)
+  {
+    myodbc_kernels.ascii_span= ascii_span_avx512;
+    myodbc_kernels.plain_span= plain_span_avx512;
+    myodbc_kernels.digit_span= digit_span_avx512;
+  }
+# endif
+#endif
+
+  myodbc_kernels.tier= tier;
+  myodbc_kernels.tier_name= kernel_tier_names[tier];
+}
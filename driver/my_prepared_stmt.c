@@ -32,28 +32,86 @@
 
 
 /* {{{ my_l_to_a() -I- */
-static char * my_l_to_a(char * buf, size_t buf_size, long long a)
+/* Returns the length of the string, buf needs room for 21 characters */
+static size_t my_l_to_a(char * buf, long long a)
 {
-	myodbc_snprintf(buf, buf_size, "%lld", (long long) a);
-	return buf;
+  return longlong10_to_str((longlong)a, buf, -10) - buf;
 }
 /* }}} */
 
 
 /* {{{ my_ul_to_a() -I- */
-static char * my_ul_to_a(char * buf, size_t buf_size, unsigned long long a)
+static size_t my_ul_to_a(char * buf, unsigned long long a)
 {
-	myodbc_snprintf(buf, buf_size, "%llu", (unsigned long long) a);
-	return buf;
+  return longlong10_to_str((longlong)a, buf, 10) - buf;
 }
 /* }}} */
 
 
 /* {{{ my_f_to_a() -I- */
-static char * my_f_to_a(char * buf, size_t buf_size, double a)
+/* Shortest representation that reads back to the same value, as the server
+   sends it in text protocol. buf needs MY_GCVT_MAX_FIELD_WIDTH + 1 chars */
+static size_t my_f_to_a(char * buf, double a, my_gcvt_arg_type type)
 {
-	myodbc_snprintf(buf, buf_size, "%f", a);
-	return buf;
+  return my_gcvt(a, type, MY_GCVT_MAX_FIELD_WIDTH, buf, NULL);
+}
+/* }}} */
+
+
+/* {{{ my_digits_to_a() -I- */
+/* Writes a zero-padded to width digits, returns the end of written string */
+static char * my_digits_to_a(char * buf, unsigned int width, unsigned long a)
+{
+  char *p= buf + width;
+
+  while (p > buf)
+  {
+    *--p= (char)('0' + a % 10);
+    a/= 10;
+  }
+
+  return buf + width;
+}
+/* }}} */
+
+
+/* {{{ my_date_to_a() -I- */
+/* YYYY-MM-DD, returns the end of written string */
+static char * my_date_to_a(char * buf, MYSQL_TIME *t)
+{
+  buf= my_digits_to_a(buf, 4, t->year);
+  *buf++= '-';
+  buf= my_digits_to_a(buf, 2, t->month);
+  *buf++= '-';
+  return my_digits_to_a(buf, 2, t->day);
+}
+/* }}} */
+
+
+/* {{{ my_time_to_a() -I- */
+/* [-]HH:MM:SS[.ffffff], hours of TIME values may take 3 digits. Returns
+   the end of written string */
+static char * my_time_to_a(char * buf, MYSQL_TIME *t)
+{
+  if (t->neg)
+  {
+    *buf++= '-';
+  }
+
+  buf= my_digits_to_a(buf, t->hour > 99 ? (t->hour > 999 ? 4 : 3) : 2,
+                      t->hour);
+  *buf++= ':';
+  buf= my_digits_to_a(buf, 2, t->minute);
+  *buf++= ':';
+  buf= my_digits_to_a(buf, 2, t->second);
+
+  if (t->second_part > 0)
+  {
+    *buf++= '.';
+    buf= my_digits_to_a(buf, 6, t->second_part);
+  }
+
+  return buf;
 }
 /* }}} */
 
@@ -64,6 +122,7 @@ void ssps_init(STMT *stmt)
   stmt->ssps= mysql_stmt_init(&stmt->dbc->mysql);
 
   stmt->result_bind= 0;
+  stmt->param_bind_sig= 0;
 }
 /* }}} */
 
@@ -290,6 +349,91 @@ void free_result_bind(STMT *stmt)
 }
 
 
+/*
+  ADAPTIVE_SSPS: called before execution of the query, that has not been
+  prepared on the server yet. The first execution goes over text protocol
+  and saves the prepare round trip for queries executed only once. The query
+  is prepared on the server when it is executed again, or right away if an
+  array of parameters is about to execute it many times. SELECTs with
+  parameter arrays are glued with UNION ALL and executed as text anyway.
+*/
+void ssps_adapt_before_exec(STMT *stmt, BOOL is_select)
+{
+  if (stmt->apd->array_size > 1 ? is_select : stmt->exec_count == 0)
+  {
+    return;
+  }
+
+  stmt->ssps_policy= SSPS_POLICY_FIXED;
+  MYLOG_QUERY(stmt, stmt->exec_count > 0 ?
+                    "Adaptive SSPS: preparing re-executed query on server" :
+                    "Adaptive SSPS: preparing query with parameter array on server");
+
+  if (!SQL_SUCCEEDED(prepare_on_server(stmt)))
+  {
+    /* The query still can be executed as text */
+    ssps_close(stmt);
+    stmt->param_count= PARAM_COUNT(&stmt->query);
+    stmt->ssps_policy= SSPS_POLICY_TEXT;
+    ++stmt->dbc->ssps_adaptive_text;
+    CLEAR_STMT_ERROR(stmt);
+    MYLOG_QUERY(stmt, "Adaptive SSPS: prepare failed, staying with text protocol");
+  }
+  else
+  {
+    ++stmt->dbc->ssps_adaptive_binary;
+  }
+}
+
+
+/*
+  ADAPTIVE_SSPS: called after successful text protocol execution of the
+  query. If the result has no columns, that binary protocol transfers in
+  native form, preparing on the server would not pay off.
+*/
+void ssps_adapt_after_exec(STMT *stmt)
+{
+  unsigned int i;
+
+  if (stmt->ssps_policy != SSPS_POLICY_UNDECIDED
+    || stmt->dummy_state == ST_DUMMY_PREPARED)
+  {
+    return;
+  }
+
+  if (stmt->exec_count++ > 0 || stmt->result == NULL)
+  {
+    return;
+  }
+
+  for (i= 0; i < field_count(stmt); ++i)
+  {
+    switch (stmt->result->fields[i].type)
+    {
+      case MYSQL_TYPE_TINY:
+      case MYSQL_TYPE_SHORT:
+      case MYSQL_TYPE_INT24:
+      case MYSQL_TYPE_LONG:
+      case MYSQL_TYPE_LONGLONG:
+      case MYSQL_TYPE_YEAR:
+      case MYSQL_TYPE_FLOAT:
+      case MYSQL_TYPE_DOUBLE:
+      case MYSQL_TYPE_DATE:
+      case MYSQL_TYPE_TIME:
+      case MYSQL_TYPE_DATETIME:
+      case MYSQL_TYPE_TIMESTAMP:
+        return;
+      default:
+        break;
+    }
+  }
+
+  stmt->ssps_policy= SSPS_POLICY_TEXT;
+  ++stmt->dbc->ssps_adaptive_text;
+  MYLOG_QUERY(stmt, "Adaptive SSPS: result has no binary columns, staying with text protocol");
+}
+
+
 void ssps_close(STMT *stmt)
 {
   if (stmt->ssps != NULL)
@@ -303,6 +447,7 @@ void ssps_close(STMT *stmt)
     */
     mysql_stmt_close(stmt->ssps);
     stmt->ssps= NULL;
+    stmt->param_bind_sig= 0;
   }
 }
 
@@ -364,6 +509,28 @@ typedef struct tagBST
 } st_buffer_size_type;
 
 
+/*
+  String and BLOB columns, for which buffer is not allocated upfront. It is
+  allocated by fetch_varlength_columns() when the first value arrives and
+  then grows with the values.
+*/
+static BOOL is_varlength_field(const MYSQL_FIELD * const field)
+{
+  switch (field->type)
+  {
+    case MYSQL_TYPE_TINY_BLOB:
+    case MYSQL_TYPE_MEDIUM_BLOB:
+    case MYSQL_TYPE_LONG_BLOB:
+    case MYSQL_TYPE_BLOB:
+    case MYSQL_TYPE_STRING:
+    case MYSQL_TYPE_VAR_STRING:
+      return field->length == 0 || field->length > 1024;
+    default:
+      return FALSE;
+  }
+}
+
+
 /* {{{ allocate_buffer_for_field() -I- */
 static st_buffer_size_type
 allocate_buffer_for_field(const MYSQL_FIELD * const field, BOOL outparams)
@@ -412,7 +579,7 @@ allocate_buffer_for_field(const MYSQL_FIELD * const field, BOOL outparams)
     case MYSQL_TYPE_STRING:
     case MYSQL_TYPE_VAR_STRING:
       /* We will get length with fetch and then fetch column */
-      if (field->length > 0 && field->length < 1025)
+      if (!is_varlength_field(field))
         result.size= field->length + 1;
       break;
 
@@ -464,11 +631,19 @@ allocate_buffer_for_field(const MYSQL_FIELD * const field, BOOL outparams)
 /* }}} */
 
 
+/*
+  Columns without a buffer allocated upfront (variable length ones, JSON,
+  GEOMETRY etc) are bound to the buffers of the previous row, so the values,
+  that fit there, are placed by mysql_stmt_fetch() and need no more copying.
+  Only values that did not fit are fetched again into the grown buffer,
+  which is then bound for the following rows.
+*/
 static MYSQL_ROW fetch_varlength_columns(STMT *stmt, MYSQL_ROW columns)
 {
   const unsigned int  num_fields= field_count(stmt);
   unsigned int i;
   uint desc_index= ~0L, stream_column= ~0L;
+  BOOL rebind= FALSE;
 
   if (stmt->out_params_state == OPS_STREAMS_PENDING)
   {
@@ -484,7 +659,9 @@ static MYSQL_ROW fetch_varlength_columns(STMT *stmt, MYSQL_ROW columns)
     }
     else
     {
-      if (stmt->result_bind[i].buffer == NULL)
+      if (stmt->result_bind[i].buffer == stmt->array[i]
+        && (stmt->result_bind[i].buffer == NULL
+          || *stmt->result_bind[i].length > stmt->result_bind[i].buffer_length))
       {
         if (stmt->lengths[i] < *stmt->result_bind[i].length)
         {
@@ -498,10 +675,16 @@ static MYSQL_ROW fetch_varlength_columns(STMT *stmt, MYSQL_ROW columns)
         stmt->result_bind[i].buffer_length= stmt->lengths[i];
 
         mysql_stmt_fetch_column(stmt->ssps, &stmt->result_bind[i], i, 0);
+        rebind= TRUE;
       }
     }
   }
 
+  if (rebind)
+  {
+    mysql_stmt_bind_result(stmt->ssps, stmt->result_bind);
+  }
+
   fill_ird_data_lengths(stmt->ird, stmt->result_bind[0].length,
                                   stmt->result->field_count);
 
@@ -519,31 +702,9 @@ int ssps_bind_result(STMT *stmt)
     return 0;
   }
 
-  if (stmt->result_bind)
-  {
-    /* We have fields requiring to read real length first */
-    if (stmt->fix_fields != NULL)
-    {
-      for (i=0; i < num_fields; ++i)
-      {
-        /* length marks such fields */
-        if (stmt->lengths[i] > 0)
-        {
-          if (stmt->result_bind[i].buffer == stmt->array[i])
-          {
-            /* make sure we do not free it twice */
-            stmt->array[i]= NULL;
-            stmt->lengths[i]= 0;
-          }
-          /* Resetting buffer and buffer_length for those fields */
-          x_free(stmt->result_bind[i].buffer);
-          stmt->result_bind[i].buffer       = 0;
-          stmt->result_bind[i].buffer_length= 0;
-        }
-      }
-    }
-  }
-  else
+  /* Once bound, buffers stay for all rows of the result. Buffers of variable
+     length columns are grown and rebound by fetch_varlength_columns() */
+  if (stmt->result_bind == NULL)
   {
     my_bool       *is_null= myodbc_malloc(sizeof(my_bool)*num_fields,
                                       MYF(MY_ZEROFILL));
@@ -613,7 +774,9 @@ BOOL ssps_0buffers_truncated_only(STMT *stmt)
     {
       if (*stmt->result_bind[i].error != 0
         && stmt->result_bind[i].buffer_length > 0
-        && stmt->result_bind[i].buffer != NULL)
+        && stmt->result_bind[i].buffer != NULL
+        /* Grown buffers are refetched by fetch_varlength_columns() */
+        && stmt->lengths[i] == 0)
       {
         return FALSE;
       }
@@ -648,19 +811,15 @@ char * ssps_get_string(STMT *stmt, ulong column_number, char *value, ulong *leng
     case MYSQL_TYPE_DATETIME:
     {
       MYSQL_TIME * t = (MYSQL_TIME *)(col_rbind->buffer);
+      char *end;
 
       buffer= ALLOC_IFNULL(buffer, 30);
-      myodbc_snprintf(buffer, 20, "%04u-%02u-%02u %02u:%02u:%02u",
-                      t->year, t->month, t->day, t->hour, t->minute, t->second);
-
-      *length= 19;
-
-      if (t->second_part > 0)
-      {
-        myodbc_snprintf(buffer+*length, 8, ".%06lu", t->second_part);
-        *length= 26;
-      }
+      end= my_date_to_a(buffer, t);
+      *end++= ' ';
+      end= my_time_to_a(end, t);
+      *end= '\0';
 
+      *length= (ulong)(end - buffer);
       return buffer;
     }
     case MYSQL_TYPE_DATE:
@@ -668,7 +827,7 @@ char * ssps_get_string(STMT *stmt, ulong column_number, char *value, ulong *leng
       MYSQL_TIME * t = (MYSQL_TIME *)(col_rbind->buffer);
 
       buffer= ALLOC_IFNULL(buffer, 12);
-      myodbc_snprintf(buffer, 11, "%04u-%02u-%02u", t->year, t->month, t->day);
+      *my_date_to_a(buffer, t)= '\0';
       *length= 10;
 
       return buffer;
@@ -676,17 +835,13 @@ char * ssps_get_string(STMT *stmt, ulong column_number, char *value, ulong *leng
     case MYSQL_TYPE_TIME:
     {
       MYSQL_TIME * t = (MYSQL_TIME *)(col_rbind->buffer);
+      char *end;
 
       buffer= ALLOC_IFNULL(buffer, 20);
-      myodbc_snprintf(buffer, 10, "%s%02u:%02u:%02u", t->neg? "-":"", t->hour,
-                                              t->minute, t->second);
-      *length= t->neg ? 9 : 8;
+      end= my_time_to_a(buffer, t);
+      *end= '\0';
 
-      if (t->second_part > 0)
-      {
-        myodbc_snprintf(buffer+*length, 8, ".%06lu", t->second_part);
-        *length+= 7;
-      }
+      *length= (ulong)(end - buffer);
       return buffer;
     }
     case MYSQL_TYPE_BIT:
@@ -701,26 +856,25 @@ char * ssps_get_string(STMT *stmt, ulong column_number, char *value, ulong *leng
 
       if (col_rbind->is_unsigned)
       {
-        my_ul_to_a(buffer, 29,
+        *length= my_ul_to_a(buffer,
           (unsigned long long)ssps_get_int64(stmt, column_number, value, *length));
       }
       else
       {
-        my_l_to_a(buffer, 29,
-                  ssps_get_int64(stmt, column_number, value, *length));
+        *length= my_l_to_a(buffer,
+                           ssps_get_int64(stmt, column_number, value, *length));
       }
 
-      *length= strlen(buffer);
       return buffer;
     }
     case MYSQL_TYPE_FLOAT:
     case MYSQL_TYPE_DOUBLE:
     {
       buffer= ALLOC_IFNULL(buffer, 50);
-      my_f_to_a(buffer, 49, ssps_get_double(stmt, column_number, value,
-                                            *length));
-
-      *length= strlen(buffer);
+      *length= my_f_to_a(buffer, (double)ssps_get_double(stmt, column_number,
+                                                         value, *length),
+                         col_rbind->buffer_type == MYSQL_TYPE_FLOAT ?
+                         MY_GCVT_ARG_FLOAT : MY_GCVT_ARG_DOUBLE);
       return buffer;
     }
 
@@ -981,3 +1135,35 @@ MYSQL_BIND * get_param_bind(STMT *stmt, unsigned int param_number, int reset)
 
   return bind;
 }
+
+
+/*
+  The client library copies MYSQL_BIND structures on mysql_stmt_bind_param(),
+  but reads the values, lengths and null flags through the pointers at
+  execute time. Thus binding again is only needed if buffers, their types
+  or the number of parameters have changed since the last bind.
+  Returns FNV-1a hash of those, never 0.
+*/
+ulonglong ssps_param_bind_signature(STMT *stmt)
+{
+  ulonglong sig= 14695981039346656037ULL;
+  unsigned int i;
+
+#define SIG_ADD(val) sig= (sig ^ (ulonglong)(val)) * 1099511628211ULL
+
+  SIG_ADD(stmt->param_count);
+
+  for (i= 0; i < stmt->param_count; ++i)
+  {
+    MYSQL_BIND *bind= (MYSQL_BIND *)stmt->param_bind->buffer + i;
+
+    SIG_ADD((size_t)bind->buffer);
+    SIG_ADD(bind->buffer_type);
+    SIG_ADD(bind->is_unsigned);
+    SIG_ADD(bind->buffer_length);
+  }
+
+#undef SIG_ADD
+
+  return sig != 0 ? sig : 1;
+}
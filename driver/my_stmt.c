@@ -65,6 +65,9 @@ BOOL returned_result(STMT *stmt)
 my_bool free_current_result(STMT *stmt)
 {
   my_bool res= 0;
+
+  read_ahead_stop(stmt);
+
   if (stmt->result)
   {
     if (ssps_used(stmt))
@@ -105,10 +108,795 @@ MYSQL_RES * stmt_get_result(STMT *stmt, BOOL force_use)
 }
 
 
+/*
+  OPTIONAL_METADATA: when the statement executes the same query again over
+  text protocol, the server is asked to omit the result set metadata and the
+  field definitions saved at the previous execution are used. Only SELECTs
+  without parameters are cached - the shape of their result does not change
+  between executions unless tables are altered.
+*/
+static BOOL metadata_cacheable(STMT *stmt)
+{
+  return stmt->dbc->optional_metadata
+      && stmt->param_count == 0
+      && !stmt->dbc->ds->allow_multiple_statements
+      && is_select_statement(&stmt->query);
+}
+
+
+static BOOL metadata_cached(STMT *stmt, const char *query,
+                            SQLULEN query_length)
+{
+  return stmt->metadata_cache != NULL
+      && stmt->metadata_cache->schema_version == stmt->dbc->schema_version
+      && stmt->metadata_cache->query_length == query_length
+      && memcmp(stmt->metadata_cache->query, query, query_length) == 0;
+}
+
+
+void metadata_cache_free(STMT *stmt)
+{
+  x_free(stmt->metadata_cache);
+  stmt->metadata_cache= NULL;
+}
+
+
+#if MYSQL_VERSION_ID >= 80003
+static char * copy_field_str(char **to, const char *str, unsigned int length)
+{
+  char *copy= *to;
+
+  if (str == NULL)
+  {
+    return NULL;
+  }
+
+  memcpy(copy, str, length);
+  copy[length]= '\0';
+  *to+= length + 1;
+
+  return copy;
+}
+
+
+/* Saves field definitions of the current result in one memory block */
+static void metadata_cache_save(STMT *stmt, const char *query,
+                                SQLULEN query_length)
+{
+  MYSQL_FIELD     *src= stmt->result->fields;
+  uint            count= stmt->result->field_count, i;
+  size_t          size= sizeof(METADATA_CACHE) + sizeof(MYSQL_FIELD) * count
+                        + query_length + 1;
+  METADATA_CACHE  *cache;
+  char            *to;
+
+  for (i= 0; i < count; ++i)
+  {
+    size+= src[i].name_length + src[i].org_name_length + src[i].table_length
+         + src[i].org_table_length + src[i].db_length + src[i].catalog_length
+         + src[i].def_length + 7;
+  }
+
+  metadata_cache_free(stmt);
+
+  /* Query is simply not cached if we are out of memory */
+  if (!(cache= (METADATA_CACHE *)myodbc_malloc(size, MYF(0))))
+  {
+    return;
+  }
+
+  cache->fields= (MYSQL_FIELD *)(cache + 1);
+  cache->field_count= count;
+  cache->schema_version= stmt->dbc->schema_version;
+  memcpy(cache->fields, src, sizeof(MYSQL_FIELD) * count);
+
+  to= (char *)(cache->fields + count);
+  cache->query= copy_field_str(&to, query, (unsigned int)query_length);
+  cache->query_length= query_length;
+
+  for (i= 0; i < count; ++i)
+  {
+    MYSQL_FIELD *field= cache->fields + i;
+
+    field->name=      copy_field_str(&to, src[i].name, src[i].name_length);
+    field->org_name=  copy_field_str(&to, src[i].org_name, src[i].org_name_length);
+    field->table=     copy_field_str(&to, src[i].table, src[i].table_length);
+    field->org_table= copy_field_str(&to, src[i].org_table, src[i].org_table_length);
+    field->db=        copy_field_str(&to, src[i].db, src[i].db_length);
+    field->catalog=   copy_field_str(&to, src[i].catalog, src[i].catalog_length);
+    field->def=       copy_field_str(&to, src[i].def, src[i].def_length);
+  }
+
+  stmt->metadata_cache= cache;
+}
+#endif
+
+
+/*
+  Sets resultset_metadata of the session before the query is executed over
+  text protocol. Returns non-zero if the server returned an error.
+*/
+int metadata_cache_before_exec(STMT *stmt, const char *query,
+                               SQLULEN query_length)
+{
+  static const char query_none[]= "SET resultset_metadata=NONE";
+  DBC *dbc= stmt->dbc;
+
+  if (!metadata_cacheable(stmt) || !metadata_cached(stmt, query, query_length))
+  {
+    return full_result_metadata(dbc);
+  }
+
+  if (!dbc->metadata_none)
+  {
+    if (mysql_real_query(&dbc->mysql, query_none, sizeof(query_none) - 1))
+    {
+      return 1;
+    }
+    dbc->metadata_none= TRUE;
+  }
+
+  return 0;
+}
+
+
+/*
+  Cached definitions are dropped by the next execution of any statement,
+  after a query that may have changed the schema or the default database.
+  DDL of other connections is not seen, the caller executes the query again
+  with the metadata if the number of columns does not match.
+*/
+void metadata_cache_track(STMT *stmt)
+{
+  switch (stmt->query.query_type)
+  {
+    case myqtSelect:
+    case myqtInsert:
+    case myqtUpdate:
+    case myqtShow:
+      break;
+    default:
+      ++stmt->dbc->schema_version;
+  }
+}
+
+
+/*
+  Gives the result cached field definitions if the server has omitted them,
+  or caches the definitions it has sent. Returns non-zero if the metadata
+  was omitted, but there is nothing suitable in the cache.
+*/
+int metadata_cache_after_exec(STMT *stmt, const char *query,
+                              SQLULEN query_length)
+{
+#if MYSQL_VERSION_ID >= 80003
+  if (mysql_result_metadata(stmt->result) == RESULTSET_METADATA_NONE)
+  {
+    if (!metadata_cached(stmt, query, query_length)
+      || stmt->metadata_cache->field_count != stmt->result->field_count)
+    {
+      metadata_cache_free(stmt);
+      return 1;
+    }
+
+    /* As with myodbc_link_fields(), the result does not own the fields */
+    stmt->result->fields= stmt->metadata_cache->fields;
+    return 0;
+  }
+
+  if (metadata_cacheable(stmt))
+  {
+    metadata_cache_save(stmt, query, query_length);
+  }
+#endif
+
+  return 0;
+}
+
+
+/*
+  SQL_ATTR_MAX_LENGTH: long character and binary columns of a SELECT are
+  truncated on the server with LEFT(), so the data the driver would cut off
+  is not sent at all. Only plain select lists are rewritten - an item that
+  is not recognized is left as it is and truncated on the client as before.
+  Truncated columns lose their base table and column names, so the rewrite
+  is done for forward-only cursors only.
+*/
+void max_length_cache_free(STMT *stmt)
+{
+  x_free(stmt->max_length_cache);
+  stmt->max_length_cache= NULL;
+}
+
+
+/*
+  Returns the position after the character, quoted string or identifier
+  at pos, or NULL if the quote is not closed.
+*/
+static const char *query_skip(CHARSET_INFO *cs, const char *pos,
+                              const char *end)
+{
+  char quote;
+  uint mb_len;
+
+  if (use_mb(cs) && (mb_len= my_ismbchar(cs, pos, end)))
+  {
+    return pos + mb_len;
+  }
+
+  if (*pos != '\'' && *pos != '"' && *pos != '`')
+  {
+    return pos + 1;
+  }
+
+  for (quote= *pos++; pos < end; ++pos)
+  {
+    if (use_mb(cs) && (mb_len= my_ismbchar(cs, pos, end)))
+    {
+      pos+= mb_len - 1;
+    }
+    else if (*pos == '\\' && quote != '`')
+    {
+      ++pos;
+    }
+    else if (*pos == quote)
+    {
+      return pos + 1;
+    }
+  }
+
+  return NULL;
+}
+
+
+static BOOL is_keyword_at(const char *pos, const char *end, const char *word)
+{
+  size_t len= strlen(word);
+
+  return pos + len < end && !myodbc_casecmp(pos, word, (uint)len)
+      && (isspace((uchar)pos[len]) || pos[len] == '(');
+}
+
+
+/*
+  Splits the select list into exactly count top level items. Returns FALSE
+  if the query has comments, escape sequences, a SELECT modifier other
+  than ALL, or a different number of items. DISTINCT has to compare the
+  whole values, it is not rewritten.
+*/
+static BOOL select_items(CHARSET_INFO *cs, const char *query, const char *end,
+                         const char **begin, const char **item_end,
+                         uint count)
+{
+  static const char *modifiers[]= {"DISTINCT", "DISTINCTROW", "HIGH_PRIORITY",
+    "STRAIGHT_JOIN", "SQL_SMALL_RESULT", "SQL_BIG_RESULT", "SQL_BUFFER_RESULT",
+    "SQL_CACHE", "SQL_NO_CACHE", "SQL_CALC_FOUND_ROWS"};
+  const char *pos= query;
+  uint depth= 0, n= 0, i;
+
+  while (pos < end && isspace((uchar)*pos))
+    ++pos;
+
+  if (!is_keyword_at(pos, end, "SELECT"))
+  {
+    return FALSE;
+  }
+
+  for (pos+= 6; pos < end && isspace((uchar)*pos); ++pos);
+
+  if (is_keyword_at(pos, end, "ALL"))
+  {
+    for (pos+= 3; pos < end && isspace((uchar)*pos); ++pos);
+  }
+
+  for (i= 0; i < array_elements(modifiers); ++i)
+  {
+    if (is_keyword_at(pos, end, modifiers[i]))
+    {
+      return FALSE;
+    }
+  }
+
+  for (begin[0]= pos; pos < end; )
+  {
+    if (*pos == '#' || *pos == '{'
+      || (pos + 1 < end && *pos == '-' && pos[1] == '-')
+      || (pos + 1 < end && *pos == '/' && pos[1] == '*'))
+    {
+      return FALSE;
+    }
+
+    if (*pos == '(')
+    {
+      ++depth;
+    }
+    else if (*pos == ')')
+    {
+      if (depth-- == 0)
+      {
+        return FALSE;
+      }
+    }
+    else if (depth == 0 && *pos == ',')
+    {
+      if (n + 1 == count)
+      {
+        return FALSE;
+      }
+      item_end[n++]= pos;
+      begin[n]= pos + 1;
+    }
+    else if (depth == 0 && pos > begin[0] && isspace((uchar)pos[-1])
+      && is_keyword_at(pos, end, "FROM"))
+    {
+      break;
+    }
+
+    if (!(pos= query_skip(cs, pos, end)))
+    {
+      return FALSE;
+    }
+  }
+
+  if (depth > 0 || n + 1 != count)
+  {
+    return FALSE;
+  }
+  item_end[n]= pos;
+
+  for (n= 0; n < count; ++n)
+  {
+    while (begin[n] < item_end[n] && isspace((uchar)*begin[n]))
+      ++begin[n];
+    while (item_end[n] > begin[n] && isspace((uchar)item_end[n][-1]))
+      --item_end[n];
+
+    if (begin[n] == item_end[n])
+    {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+
+/*
+  Finds where the expression of a select list item ends, before its alias.
+  Returns NULL if the item is a wildcard or may have an alias without AS.
+*/
+static const char *item_expression_end(CHARSET_INFO *cs, const char *begin,
+                                       const char *end)
+{
+  const char *pos= begin, *as= NULL;
+  BOOL spaces= FALSE;
+  uint depth= 0;
+
+  if (end[-1] == '*')
+  {
+    return NULL;
+  }
+
+  while (pos < end)
+  {
+    if (*pos == '(')
+    {
+      ++depth;
+    }
+    else if (*pos == ')')
+    {
+      --depth;
+    }
+    else if (depth == 0 && isspace((uchar)*pos))
+    {
+      spaces= TRUE;
+      if (is_keyword_at(pos + 1, end, "AS"))
+      {
+        as= pos;
+      }
+    }
+
+    if (!(pos= query_skip(cs, pos, end)))
+    {
+      return NULL;
+    }
+  }
+
+  if (as != NULL)
+  {
+    return as;
+  }
+
+  return spaces ? NULL : end;
+}
+
+
+static BOOL is_name_char(uchar c)
+{
+  return isalnum(c) || c == '_' || c == '$' || c >= 0x80;
+}
+
+
+/*
+  TRUE if the name appears in the query from pos on, as a word or quoted.
+  ORDER BY, GROUP BY and HAVING would see the truncated value under the
+  alias, so such an item is not rewritten. Unclosed quotes count as a use.
+*/
+static BOOL name_used_after(CHARSET_INFO *cs, const char *pos,
+                            const char *end, const char *name)
+{
+  size_t len= strlen(name);
+  const char *next;
+
+  while (pos < end)
+  {
+    if (*pos == '`' || *pos == '"' || *pos == '\'')
+    {
+      if (!(next= query_skip(cs, pos, end)))
+      {
+        return TRUE;
+      }
+      if ((size_t)(next - pos) == len + 2
+        && !myodbc_casecmp(pos + 1, name, (uint)len))
+      {
+        return TRUE;
+      }
+    }
+    else if (is_name_char((uchar)*pos))
+    {
+      for (next= pos; next < end && is_name_char((uchar)*next); ++next);
+
+      if ((size_t)(next - pos) == len && !myodbc_casecmp(pos, name, (uint)len))
+      {
+        return TRUE;
+      }
+    }
+    else
+    {
+      next= pos + 1;
+    }
+    pos= next;
+  }
+
+  return FALSE;
+}
+
+
+/*
+  TRUE if ORDER BY or GROUP BY from pos on refers to the select list item
+  by its number. A number counts if it is a whole item of the list, e.g.
+  "ORDER BY 2 DESC", but not in "ORDER BY 2 + x".
+*/
+static BOOL position_used_after(CHARSET_INFO *cs, const char *pos,
+                                const char *end, uint number)
+{
+  const char *next, *word= NULL;
+  size_t word_len= 0;
+  BOOL in_list= FALSE, item_start= FALSE;
+  char buff[16];
+  size_t len= sprintf(buff, "%u", number);
+
+  while (pos < end)
+  {
+    if (isspace((uchar)*pos))
+    {
+      ++pos;
+      continue;
+    }
+
+    if (is_name_char((uchar)*pos))
+    {
+      for (next= pos; next < end && is_name_char((uchar)*next); ++next);
+
+      if (item_start && (size_t)(next - pos) == len && !memcmp(pos, buff, len))
+      {
+        const char *after= next;
+
+        while (after < end && isspace((uchar)*after))
+          ++after;
+
+        if (after == end || strchr(",;)", *after)
+          || is_name_char((uchar)*after))
+        {
+          return TRUE;
+        }
+      }
+
+      if (next - pos == 2 && !myodbc_casecmp(pos, "BY", 2) && word
+        && word_len == 5 && (!myodbc_casecmp(word, "ORDER", 5)
+                             || !myodbc_casecmp(word, "GROUP", 5)))
+      {
+        in_list= item_start= TRUE;
+      }
+      else
+      {
+        if ((next - pos == 5 && !myodbc_casecmp(pos, "LIMIT", 5))
+          || (next - pos == 6 && !myodbc_casecmp(pos, "HAVING", 6)))
+        {
+          in_list= FALSE;
+        }
+        item_start= FALSE;
+      }
+
+      word= pos;
+      word_len= next - pos;
+    }
+    else if (*pos == '`' || *pos == '"' || *pos == '\'')
+    {
+      /* Unclosed quotes count as a use */
+      if (!(next= query_skip(cs, pos, end)))
+      {
+        return TRUE;
+      }
+      item_start= FALSE;
+      word= NULL;
+    }
+    else
+    {
+      next= pos + 1;
+      item_start= in_list && *pos == ',';
+      word= NULL;
+    }
+    pos= next;
+  }
+
+  return FALSE;
+}
+
+
+static BOOL is_long_field(MYSQL_FIELD *field, SQLULEN max_length)
+{
+  /* The column keeps its name as an alias, it is not quoted with escapes */
+  if (strchr(field->name, '`'))
+  {
+    return FALSE;
+  }
+
+  switch (field->type)
+  {
+  case MYSQL_TYPE_TINY_BLOB:
+  case MYSQL_TYPE_MEDIUM_BLOB:
+  case MYSQL_TYPE_LONG_BLOB:
+  case MYSQL_TYPE_BLOB:
+  case MYSQL_TYPE_VAR_STRING:
+  case MYSQL_TYPE_VARCHAR:
+  case MYSQL_TYPE_STRING:
+#if MYSQL_VERSION_ID >= 50708
+  case MYSQL_TYPE_JSON:
+#endif
+    return field->length > max_length;
+
+  default:
+    return FALSE;
+  }
+}
+
+
+/*
+  Returns where the expression of the item to truncate ends, or NULL if
+  the item is left as it is. number is the position of the item in the
+  select list, counting from 1.
+*/
+static const char *item_truncated_end(CHARSET_INFO *cs, MYSQL_FIELD *field,
+                                      SQLULEN max_length, uint number,
+                                      const char *begin, const char *item_end,
+                                      const char *rest, const char *end)
+{
+  if (!is_long_field(field, max_length)
+    || name_used_after(cs, rest, end, field->name)
+    || position_used_after(cs, rest, end, number))
+  {
+    return NULL;
+  }
+
+  return item_expression_end(cs, begin, item_end);
+}
+
+
+/*
+  Builds the rewrite of the query for the current SQL_ATTR_MAX_LENGTH. The
+  types of the columns are found by a query returning no rows.
+*/
+static void max_length_rewrite(STMT *stmt, const char *query,
+                               SQLULEN query_length)
+{
+  static const char probe_end[]= ") AS myodbc_max_length LIMIT 0";
+  CHARSET_INFO      *cs= stmt->dbc->cxn_charset_info;
+  const char        *end= query + query_length, **begin= NULL, **item_end;
+  SQLULEN           max_length= stmt->stmt_options.max_length;
+  DYNAMIC_STRING    probe, rewritten;
+  MYSQL_RES         *result= NULL;
+  MAX_LENGTH_CACHE  *cache;
+  uint              count= 0, i;
+  char              buff[32];
+  BOOL              truncated= FALSE;
+
+  max_length_cache_free(stmt);
+
+  if (init_dynamic_string(&probe, "SELECT * FROM (", query_length + 64, 256))
+  {
+    return;
+  }
+
+  if (init_dynamic_string(&rewritten, "", query_length + 64, 256))
+  {
+    dynstr_free(&probe);
+    return;
+  }
+
+  if (!dynstr_append_mem(&probe, query, (ulong)query_length)
+    && !dynstr_append_mem(&probe, probe_end, sizeof(probe_end) - 1)
+    && !full_result_metadata(stmt->dbc)
+    && !mysql_real_query(&stmt->dbc->mysql, probe.str, probe.length)
+    && (result= mysql_store_result(&stmt->dbc->mysql)) != NULL)
+  {
+    count= result->field_count;
+    begin= (const char **)myodbc_malloc(sizeof(char *) * count * 2, MYF(0));
+  }
+
+  if (begin != NULL
+    && select_items(cs, query, end, begin, begin + count, count))
+  {
+    item_end= begin + count;
+    dynstr_append_mem(&rewritten, query, (ulong)(begin[0] - query));
+    sprintf(buff, ", %lu) AS ", (unsigned long)max_length);
+
+    for (i= 0; i < count; ++i)
+    {
+      const char *expr_end= item_truncated_end(cs, result->fields + i,
+                                               max_length, i + 1, begin[i],
+                                               item_end[i],
+                                               item_end[count - 1], end);
+
+      if (i > 0)
+      {
+        dynstr_append_mem(&rewritten, item_end[i - 1],
+                          (ulong)(begin[i] - item_end[i - 1]));
+      }
+
+      if (expr_end != NULL)
+      {
+        dynstr_append_mem(&rewritten, "LEFT(", 5);
+        dynstr_append_mem(&rewritten, begin[i], (ulong)(expr_end - begin[i]));
+        dynstr_append(&rewritten, buff);
+        dynstr_append_quoted_name(&rewritten, result->fields[i].name);
+        truncated= TRUE;
+      }
+      else
+      {
+        dynstr_append_mem(&rewritten, begin[i], (ulong)(item_end[i] - begin[i]));
+      }
+    }
+
+    dynstr_append_mem(&rewritten, item_end[count - 1],
+                      (ulong)(end - item_end[count - 1]));
+  }
+
+  if (!truncated)
+  {
+    count= 0;
+    rewritten.length= 0;
+  }
+
+  /* The query is executed as is, if we are out of memory */
+  if ((cache= (MAX_LENGTH_CACHE *)myodbc_malloc(sizeof(MAX_LENGTH_CACHE)
+                                   + sizeof(MAX_LENGTH_FIELD) * count
+                                   + query_length + rewritten.length + 2,
+                                   MYF(0))))
+  {
+    cache->fields= (MAX_LENGTH_FIELD *)(cache + 1);
+    cache->field_count= count;
+    cache->max_length= max_length;
+    cache->query= (char *)(cache->fields + count);
+    cache->query_length= query_length;
+    memcpy(cache->query, query, query_length);
+    cache->query[query_length]= '\0';
+    cache->rewritten= NULL;
+    cache->rewritten_length= 0;
+
+    if (truncated)
+    {
+      cache->rewritten= cache->query + query_length + 1;
+      cache->rewritten_length= rewritten.length;
+      memcpy(cache->rewritten, rewritten.str, rewritten.length + 1);
+    }
+
+    for (i= 0; i < count; ++i)
+    {
+      MYSQL_FIELD *field= result->fields + i;
+
+      cache->fields[i].truncated= item_truncated_end(cs, field, max_length,
+                                      i + 1, begin[i], begin[count + i],
+                                      begin[2 * count - 1], end) != NULL;
+      cache->fields[i].type= field->type;
+      cache->fields[i].length= field->length;
+      cache->fields[i].flags= field->flags;
+      cache->fields[i].decimals= field->decimals;
+      cache->fields[i].charsetnr= field->charsetnr;
+    }
+
+    stmt->max_length_cache= cache;
+  }
+
+  x_free(begin);
+  mysql_free_result(result);
+  dynstr_free(&probe);
+  dynstr_free(&rewritten);
+}
+
+
+/*
+  Returns the query to execute instead of the given one, with long columns
+  truncated to SQL_ATTR_MAX_LENGTH on the server, or the query itself. The
+  rewrite is kept, so repeated executions do not need extra round trips.
+*/
+char *max_length_query(STMT *stmt, char *query, SQLULEN *query_length)
+{
+  MAX_LENGTH_CACHE *cache;
+
+  if (stmt->stmt_options.max_length == 0
+    || stmt->stmt_options.cursor_type != SQL_CURSOR_FORWARD_ONLY
+    || stmt->dbc->ds->allow_multiple_statements
+    || !is_select_statement(&stmt->query))
+  {
+    return query;
+  }
+
+  cache= stmt->max_length_cache;
+  if (cache == NULL || cache->max_length != stmt->stmt_options.max_length
+    || cache->query_length != *query_length
+    || memcmp(cache->query, query, *query_length))
+  {
+    max_length_rewrite(stmt, query, *query_length);
+    cache= stmt->max_length_cache;
+  }
+
+  if (cache == NULL || cache->rewritten == NULL)
+  {
+    return query;
+  }
+
+  *query_length= cache->rewritten_length;
+  return cache->rewritten;
+}
+
+
+/*
+  Gives the truncated columns of the result the types they have without
+  truncation, if the result is of the rewritten query.
+*/
+void max_length_fix_fields(STMT *stmt, const char *query)
+{
+  MAX_LENGTH_CACHE *cache= stmt->max_length_cache;
+  uint i;
+
+  if (cache == NULL || cache->rewritten != query || stmt->result == NULL
+    || stmt->result->field_count != cache->field_count)
+  {
+    return;
+  }
+
+  for (i= 0; i < cache->field_count; ++i)
+  {
+    MYSQL_FIELD *field= stmt->result->fields + i;
+
+    if (cache->fields[i].truncated)
+    {
+      field->type=      cache->fields[i].type;
+      field->length=    cache->fields[i].length;
+      field->flags=     cache->fields[i].flags;
+      field->decimals=  cache->fields[i].decimals;
+      field->charsetnr= cache->fields[i].charsetnr;
+    }
+  }
+}
+
+
 /* For text protocol this get result itself as well. Besides for text protocol
    we need to use/store each resultset of multiple resultsets */
 MYSQL_RES * get_result_metadata(STMT *stmt, BOOL force_use)
 {
+  read_ahead_stop(stmt);
   free_internal_result_buffers(stmt);
   /* just a precaution, mysql_free_result checks for NULL anywat */
   mysql_free_result(stmt->result);
@@ -156,56 +944,377 @@ unsigned int field_count(STMT *stmt)
   }
   else
   {
-    return stmt->result && stmt->result->field_count > 0 ?
-      stmt->result->field_count :
-      mysql_field_count(&stmt->dbc->mysql);
+    return stmt->result && stmt->result->field_count > 0 ?
+      stmt->result->field_count :
+      mysql_field_count(&stmt->dbc->mysql);
+  }
+}
+
+
+my_ulonglong affected_rows(STMT *stmt)
+{
+  if (ssps_used(stmt))
+  {
+    return mysql_stmt_affected_rows(stmt->ssps);
+  }
+  else
+  {
+    /* In some cases in c/odbc it cannot be used instead of mysql_num_rows */
+    return mysql_affected_rows(&stmt->dbc->mysql);
+  }
+}
+
+my_ulonglong update_affected_rows(STMT *stmt)
+{
+  my_ulonglong last_affected;
+
+  last_affected= affected_rows(stmt);
+
+  stmt->affected_rows+= last_affected;
+
+  return last_affected;
+}
+
+
+my_ulonglong num_rows(STMT *stmt)
+{
+  my_ulonglong offset= scroller_exists(stmt) && stmt->scroller.next_offset > 0 ? 
+    stmt->scroller.next_offset - stmt->scroller.row_count : 0;
+
+  if (ssps_used(stmt))
+  {
+    return  offset + mysql_stmt_num_rows(stmt->ssps);
+  }
+  else
+  {
+    return offset + mysql_num_rows(stmt->result);
+  }
+}
+
+
+/*
+  READ_AHEAD: a forward-only result read with mysql_use_result is read from
+  the network by a separate thread into a ring of rows, while the
+  application converts the rows read earlier. The application keeps the
+  row it fetched last until the next fetch, the thread can be ahead by the
+  rest of the ring. Other statements of the connection get "commands out
+  of sync" until the result is read to the end, as without READ_AHEAD.
+  The thread reads each row holding the connection lock, so that they do
+  not use the connection handle at the same time.
+*/
+
+
+/* Frees the rows read in advance and the READ_AHEAD itself */
+static void read_ahead_free(READ_AHEAD *ra)
+{
+  uint i;
+
+  for (i= 0; i < ra->size; ++i)
+  {
+    x_free(ra->ring[i].values);
+    x_free(ra->ring[i].data);
+  }
+
+  myodbc_cond_destroy(&ra->cond);
+  myodbc_mutex_destroy(&ra->lock);
+  x_free(ra);
+}
+
+
+/* Copies the row, so that the client library can read the next one */
+static my_bool read_ahead_copy(READ_AHEAD_ROW *to, MYSQL_ROW row,
+                               unsigned long *lengths, uint field_count)
+{
+  size_t size= field_count;
+  char *pos;
+  uint i;
+
+  for (i= 0; i < field_count; ++i)
+  {
+    size+= lengths[i];
+  }
+
+  if (to->values == NULL)
+  {
+    to->values= (MYSQL_ROW)myodbc_malloc(field_count * (sizeof(char *) +
+                                         sizeof(unsigned long)), MYF(0));
+    if (to->values == NULL)
+    {
+      return TRUE;
+    }
+    to->lengths= (unsigned long *)(to->values + field_count);
+  }
+
+  if (size > to->data_size)
+  {
+    char *data= (char *)myodbc_realloc(to->data, size, MYF(MY_ALLOW_ZERO_PTR));
+    if (data == NULL)
+    {
+      return TRUE;
+    }
+    to->data= data;
+    to->data_size= size;
+  }
+
+  for (i= 0, pos= to->data; i < field_count; ++i)
+  {
+    to->lengths[i]= lengths[i];
+
+    if (row[i] == NULL)
+    {
+      to->values[i]= NULL;
+      continue;
+    }
+
+    memcpy(pos, row[i], lengths[i]);
+    pos[lengths[i]]= '\0';
+    to->values[i]= pos;
+    pos+= lengths[i] + 1;
+  }
+
+  return FALSE;
+}
+
+
+static void *read_ahead_thread(void *arg)
+{
+  READ_AHEAD *ra= (READ_AHEAD *)arg;
+  DBC *dbc= ra->stmt->dbc;
+  MYSQL_RES *result= ra->stmt->result;
+  READ_AHEAD_ROW *slot;
+  MYSQL_ROW row;
+  my_bool error, orphaned;
+
+  mysql_thread_init();
+
+  for (;;)
+  {
+    myodbc_mutex_lock(&ra->lock);
+    while (!ra->stop && ra->count == ra->size)
+    {
+      myodbc_cond_wait(&ra->cond, &ra->lock);
+    }
+    if (ra->stop)
+    {
+      myodbc_mutex_unlock(&ra->lock);
+      break;
+    }
+    /* The application does not touch the slot until count grows */
+    slot= &ra->ring[ra->read_pos];
+    ra->locking= TRUE;
+    myodbc_mutex_unlock(&ra->lock);
+
+    /*
+      read_ahead_stop() can be called with the connection lock held. It
+      does not wait for the thread then, the thread finds out about the
+      stop once it gets the lock.
+    */
+    myodbc_mutex_lock(&dbc->lock);
+
+    myodbc_mutex_lock(&ra->lock);
+    ra->locking= FALSE;
+    if (ra->stop)
+    {
+      myodbc_mutex_unlock(&ra->lock);
+      myodbc_mutex_unlock(&dbc->lock);
+      break;
+    }
+    myodbc_mutex_unlock(&ra->lock);
+
+    row= mysql_fetch_row(result);
+    error= row == NULL || read_ahead_copy(slot, row, mysql_fetch_lengths(result),
+                                          result->field_count);
+    myodbc_mutex_unlock(&dbc->lock);
+
+    myodbc_mutex_lock(&ra->lock);
+    if (error)
+    {
+      ra->eof= TRUE;
+      ra->oom= row != NULL;
+      myodbc_cond_signal(&ra->cond);
+      myodbc_mutex_unlock(&ra->lock);
+      break;
+    }
+    ra->read_pos= (ra->read_pos + 1) % ra->size;
+    ++ra->count;
+    myodbc_cond_signal(&ra->cond);
+    myodbc_mutex_unlock(&ra->lock);
+  }
+
+  mysql_thread_end();
+
+  myodbc_mutex_lock(&ra->lock);
+  ra->running= FALSE;
+  orphaned= ra->orphaned;
+  myodbc_cond_broadcast(&ra->cond);
+  myodbc_mutex_unlock(&ra->lock);
+
+  /* Nobody waits for the thread, it cleans up after itself */
+  if (orphaned)
+  {
+    read_ahead_free(ra);
+  }
+
+  return NULL;
+}
+
+
+/**
+  Starts reading the forward-only result in advance, if READ_AHEAD is set.
+  If the thread can't be started the result is read as usual.
+*/
+void read_ahead_start(STMT *stmt)
+{
+  READ_AHEAD *ra;
+  my_thread_handle thread;
+  my_thread_attr_t attr;
+  int failed;
+  uint size= stmt->dbc->ds->read_ahead;
+
+  if (size == 0 || stmt->result == NULL || ssps_used(stmt)
+    || !if_forward_cache(stmt) || stmt->read_ahead != NULL)
+  {
+    return;
+  }
+
+  size= myodbc_max(size, READ_AHEAD_MIN_ROWS);
+
+  if (!(ra= (READ_AHEAD *)myodbc_malloc(sizeof(READ_AHEAD) +
+                                        sizeof(READ_AHEAD_ROW) * size,
+                                        MYF(MY_ZEROFILL))))
+  {
+    return;
+  }
+
+  ra->stmt= stmt;
+  ra->ring= (READ_AHEAD_ROW *)(ra + 1);
+  ra->size= size;
+  ra->running= TRUE;
+  myodbc_mutex_init(&ra->lock, NULL);
+  myodbc_cond_init(&ra->cond);
+
+  /* read_ahead_stop() waits for the thread on the condition, not by joining */
+  my_thread_attr_init(&attr);
+  my_thread_attr_setdetachstate(&attr, MY_THREAD_CREATE_DETACHED);
+  failed= my_thread_create(&thread, &attr, read_ahead_thread, ra);
+  my_thread_attr_destroy(&attr);
+
+  if (failed)
+  {
+    read_ahead_free(ra);
+    return;
+  }
+
+  stmt->read_ahead= ra;
+}
+
+
+/**
+  Stops the reading thread and frees the rows read in advance. The rest of
+  the result is left to mysql_free_result().
+*/
+void read_ahead_stop(STMT *stmt)
+{
+  READ_AHEAD *ra= stmt->read_ahead;
+
+  if (ra == NULL)
+  {
+    return;
   }
-}
 
+  stmt->read_ahead= NULL;
 
-my_ulonglong affected_rows(STMT *stmt)
-{
-  if (ssps_used(stmt))
+  myodbc_mutex_lock(&ra->lock);
+  ra->stop= TRUE;
+  myodbc_cond_broadcast(&ra->cond);
+
+  /*
+    The caller may hold the connection lock the thread is waiting for. The
+    thread won't touch the result anymore, so it is left to free the rows.
+  */
+  if (ra->locking)
   {
-    return mysql_stmt_affected_rows(stmt->ssps);
+    ra->orphaned= TRUE;
+    myodbc_mutex_unlock(&ra->lock);
+    return;
   }
-  else
+
+  while (ra->running)
   {
-    /* In some cases in c/odbc it cannot be used instead of mysql_num_rows */
-    return mysql_affected_rows(&stmt->dbc->mysql);
+    myodbc_cond_wait(&ra->cond, &ra->lock);
   }
+  myodbc_mutex_unlock(&ra->lock);
+
+  read_ahead_free(ra);
 }
 
-my_ulonglong update_affected_rows(STMT *stmt)
+
+/**
+  Checks whether the rows ran out because the reading thread could not copy
+  a row. The statement gets HY001 then rather than the end of the result.
+*/
+my_bool read_ahead_failed(STMT *stmt)
 {
-  my_ulonglong last_affected;
+  READ_AHEAD *ra= stmt->read_ahead;
+  my_bool failed;
 
-  last_affected= affected_rows(stmt);
+  if (ra == NULL)
+  {
+    return FALSE;
+  }
 
-  stmt->affected_rows+= last_affected;
+  myodbc_mutex_lock(&ra->lock);
+  failed= ra->oom && ra->count == 0;
+  myodbc_mutex_unlock(&ra->lock);
 
-  return last_affected;
+  if (failed)
+  {
+    set_error(stmt, MYERR_S1001, NULL, 4001);
+  }
+
+  return failed;
 }
 
 
-my_ulonglong num_rows(STMT *stmt)
+static MYSQL_ROW read_ahead_fetch(READ_AHEAD *ra)
 {
-  my_ulonglong offset= scroller_exists(stmt) && stmt->scroller.next_offset > 0 ? 
-    stmt->scroller.next_offset - stmt->scroller.row_count : 0;
+  MYSQL_ROW values= NULL;
 
-  if (ssps_used(stmt))
+  myodbc_mutex_lock(&ra->lock);
+
+  /* The row fetched before is not needed anymore */
+  if (ra->holding)
   {
-    return  offset + mysql_stmt_num_rows(stmt->ssps);
+    ra->holding= FALSE;
+    ra->take_pos= (ra->take_pos + 1) % ra->size;
+    --ra->count;
+    myodbc_cond_signal(&ra->cond);
   }
-  else
+
+  while (ra->count == 0 && !ra->eof)
   {
-    return offset + mysql_num_rows(stmt->result);
+    myodbc_cond_wait(&ra->cond, &ra->lock);
+  }
+
+  if (ra->count > 0)
+  {
+    ra->holding= TRUE;
+    values= ra->ring[ra->take_pos].values;
   }
+
+  myodbc_mutex_unlock(&ra->lock);
+
+  return values;
 }
 
 
 MYSQL_ROW fetch_row(STMT *stmt)
 {
+  if (stmt->read_ahead)
+  {
+    return read_ahead_fetch(stmt->read_ahead);
+  }
+
   if (ssps_used(stmt))
   {
     int error;
@@ -233,6 +1342,11 @@ MYSQL_ROW fetch_row(STMT *stmt)
 
 unsigned long* fetch_lengths(STMT *stmt)
 {
+  if (stmt->read_ahead)
+  {
+    return stmt->read_ahead->ring[stmt->read_ahead->take_pos].lengths;
+  }
+
   if (ssps_used(stmt))
   {
     return stmt->result_bind[0].length;
@@ -365,6 +1479,50 @@ BOOL is_null(STMT *stmt, ulong column_number, char *value)
   }
 }
 
+/* Prepares already parsed stmt->query on the server */
+SQLRETURN prepare_on_server(STMT *stmt)
+{
+  MYLOG_QUERY(stmt, "Using prepared statement");
+  ssps_init(stmt);
+
+  /* If the query is in the form of "WHERE CURRENT OF" - we do not need to prepare
+     it at the moment */
+  if (!get_cursor_name(&stmt->query))
+  {
+    if (full_result_metadata(stmt->dbc) ||
+        mysql_stmt_prepare(stmt->ssps, GET_QUERY(&stmt->query),
+                           (unsigned long)GET_QUERY_LENGTH(&stmt->query)))
+    {
+      MYLOG_QUERY(stmt, mysql_error(&stmt->dbc->mysql));
+
+      set_stmt_error(stmt,"HY000",mysql_error(&stmt->dbc->mysql),
+                     mysql_errno(&stmt->dbc->mysql));
+      translate_error(stmt->error.sqlstate,MYERR_S1000,
+                      mysql_errno(&stmt->dbc->mysql));
+
+      return SQL_ERROR;
+    }
+
+    stmt->param_count= mysql_stmt_param_count(stmt->ssps);
+
+    free_internal_result_buffers(stmt);
+    /* make sure we free the result from the previous time */
+    mysql_free_result(stmt->result);
+
+    /* Getting result metadata */
+    if ((stmt->result= mysql_stmt_result_metadata(stmt->ssps)))
+    {
+      /*stmt->state= ST_SS_PREPARED;*/
+      fix_result_types(stmt);
+     /*Should we reset stmt->result?*/
+    }
+  /*assert(stmt->param_count==PARAM_COUNT(&stmt->query));*/
+  }
+
+  return SQL_SUCCESS;
+}
+
+
 /* Prepares statement depending on connection option either on a client or
    on a server. Returns SQLRETURN result code since preparing on client or
    server can produce errors, memory allocation to name one.  */
@@ -388,44 +1546,21 @@ SQLRETURN prepare(STMT *stmt, char * query, SQLINTEGER query_length)
 
   ssps_close(stmt);
   stmt->param_count= PARAM_COUNT(&stmt->query);
+  stmt->ssps_policy= SSPS_POLICY_FIXED;
+  stmt->exec_count= 0;
   /* Trusting our parsing we are not using prepared statments unsless there are
      actually parameter markers in it */
   if (!stmt->dbc->ds->no_ssps && PARAM_COUNT(&stmt->query) && !IS_BATCH(&stmt->query)
     && preparable_on_server(&stmt->query, stmt->dbc->mysql.server_version))
   {
-    MYLOG_QUERY(stmt, "Using prepared statement");
-    ssps_init(stmt);
-
-    /* If the query is in the form of "WHERE CURRENT OF" - we do not need to prepare
-       it at the moment */
-    if (!get_cursor_name(&stmt->query))
+    /* Leaving it to the execution to decide, if the query worth preparing */
+    if (stmt->dbc->ds->adaptive_ssps && !get_cursor_name(&stmt->query))
     {
-      if (mysql_stmt_prepare(stmt->ssps, query, query_length))
-      {
-        MYLOG_QUERY(stmt, mysql_error(&stmt->dbc->mysql));
-
-        set_stmt_error(stmt,"HY000",mysql_error(&stmt->dbc->mysql),
-                       mysql_errno(&stmt->dbc->mysql));
-        translate_error(stmt->error.sqlstate,MYERR_S1000,
-                        mysql_errno(&stmt->dbc->mysql));
-
-        return SQL_ERROR;
-      }
-
-      stmt->param_count= mysql_stmt_param_count(stmt->ssps);
-
-      free_internal_result_buffers(stmt);
-      /* make sure we free the result from the previous time */
-      mysql_free_result(stmt->result);
-
-      /* Getting result metadata */
-      if ((stmt->result= mysql_stmt_result_metadata(stmt->ssps)))
-      {
-        /*stmt->state= ST_SS_PREPARED;*/
-        fix_result_types(stmt);
-       /*Should we reset stmt->result?*/
-      }
-    /*assert(stmt->param_count==PARAM_COUNT(&stmt->query));*/
+      stmt->ssps_policy= SSPS_POLICY_UNDECIDED;
+    }
+    else if (!SQL_SUCCEEDED(prepare_on_server(stmt)))
+    {
+      return SQL_ERROR;
     }
   }
 
@@ -518,8 +1653,15 @@ SQLRETURN send_long_data (STMT *stmt, unsigned int param_num, DESCREC * aprec, c
 void scroller_reset(STMT *stmt)
 {
   x_free(stmt->scroller.query);
+  x_free(stmt->scroller.key_name);
+  x_free(stmt->scroller.key_query);
+  x_free(stmt->scroller.key_value);
   stmt->scroller.next_offset= 0;
   stmt->scroller.query= stmt->scroller.offset_pos= NULL;
+  stmt->scroller.order_pos= stmt->scroller.where_pos= NULL;
+  stmt->scroller.key_name= stmt->scroller.key_query= NULL;
+  stmt->scroller.key_table= stmt->scroller.key_value= NULL;
+  stmt->scroller.key_dups= 0;
 }
 
 /* @param[in]     selected  - prefetch value in datatsource selected by user
@@ -563,6 +1705,411 @@ BOOL scroller_exists(STMT * stmt)
   return stmt->scroller.offset_pos != NULL;
 }
 
+
+/* Number of case-insensitive occurrences of word between begin and end */
+static unsigned int count_keyword(const char *begin, const char *end,
+                                  const char *word)
+{
+  size_t len= strlen(word);
+  unsigned int count= 0;
+
+  for (; begin + len <= end; ++begin)
+  {
+    if (!myodbc_casecmp(begin, word, (uint)len))
+    {
+      ++count;
+    }
+  }
+
+  return count;
+}
+
+
+/*
+  Checks if the scroller's query is ordered by a single column, so that
+  chunks may continue from the last key seen instead of an offset. A query
+  with subqueries, unions or grouping could change meaning with an added
+  condition - it is always scrolled by offsets.
+
+  @param[in] limit_pos  where the LIMIT clause begins in scroller's query
+*/
+static void scroller_find_key(STMT *stmt, char *limit_pos)
+{
+  CHARSET_INFO *cs= stmt->dbc->ansi_charset_info;
+  char *query= stmt->scroller.query;
+  const char *pos, *token, *name, *name_end, *table= NULL, *table_end= NULL;
+  char *order, *where, *to;
+  size_t size;
+  my_bool desc= FALSE;
+
+  if (count_keyword(query, limit_pos, "SELECT") != 1
+    || count_keyword(query, limit_pos, "WHERE") > 1
+    || count_keyword(query, limit_pos, "ORDER") != 1
+    || find_first_token(cs, query, limit_pos, "UNION")
+    || find_first_token(cs, query, limit_pos, "GROUP")
+    || find_first_token(cs, query, limit_pos, "HAVING")
+    || !(order= (char *)find_token(cs, query, limit_pos, "ORDER"))
+    || !isspace((uchar)order[5]))
+  {
+    return;
+  }
+
+  pos= order + 5;
+  token= mystr_get_next_token(cs, &pos, limit_pos);
+  if (pos - token != 2 || myodbc_casecmp(token, "BY", 2))
+  {
+    return;
+  }
+
+  /* Only a plain, maybe qualified, column name is usable as a key */
+  name= mystr_get_next_token(cs, &pos, limit_pos);
+  name_end= pos;
+  if (name == limit_pos)
+  {
+    return;
+  }
+
+  for (token= name; token < name_end; ++token)
+  {
+    if (!isalnum((uchar)*token) && !strchr("_$`.", *token))
+    {
+      return;
+    }
+    if (*token == '.')
+    {
+      /* The qualifier is the table, the database before it is not needed */
+      table= table_end ? table_end + 1 : name;
+      table_end= token;
+    }
+  }
+  if (table_end)
+  {
+    name= table_end + 1;
+  }
+
+  token= mystr_get_next_token(cs, &pos, limit_pos);
+  if (token != limit_pos)
+  {
+    if (pos - token == 4 && !myodbc_casecmp(token, "DESC", 4))
+    {
+      desc= TRUE;
+    }
+    else if (pos - token != 3 || myodbc_casecmp(token, "ASC", 3))
+    {
+      return;
+    }
+
+    if (mystr_get_next_token(cs, &pos, limit_pos) != limit_pos)
+    {
+      return;
+    }
+  }
+
+  if ((where= (char *)find_token(cs, query, order, "WHERE")) != NULL
+    && !isspace((uchar)where[5]) && where[5] != '(')
+  {
+    return;
+  }
+
+  /* The name and the qualifier, each with its terminator */
+  size= name_end - name + 2;
+  if (table_end)
+  {
+    size+= table_end - table;
+  }
+
+  if (!(stmt->scroller.key_name= (char *)myodbc_malloc(size, MYF(0))))
+  {
+    return;
+  }
+
+  for (to= stmt->scroller.key_name; name < name_end; ++name)
+  {
+    if (*name != '`')
+    {
+      *to++= *name;
+    }
+  }
+  *to++= '\0';
+
+  /* The table qualifier follows the name in the same buffer */
+  stmt->scroller.key_table= NULL;
+  if (table_end)
+  {
+    stmt->scroller.key_table= to;
+    for (; table < table_end; ++table)
+    {
+      if (*table != '`')
+      {
+        *to++= *table;
+      }
+    }
+    *to= '\0';
+  }
+
+  stmt->scroller.order_pos= order;
+  stmt->scroller.where_pos= where ? where + 5 : NULL;
+  stmt->scroller.key_desc= desc;
+  stmt->scroller.key_column= -1;
+}
+
+
+/*
+  Checks whether the result field is the ORDER BY column. A qualified
+  column is matched by its table and original name, otherwise the name in
+  the result is what ORDER BY refers to.
+*/
+static BOOL scroller_is_key_field(STMT *stmt, MYSQL_FIELD *field)
+{
+  const char *table= stmt->scroller.key_table;
+
+  if (table == NULL)
+  {
+    return !myodbc_strcasecmp(field->name, stmt->scroller.key_name);
+  }
+
+  return field->org_name && !myodbc_strcasecmp(field->org_name,
+                                               stmt->scroller.key_name)
+    && ((field->table && !myodbc_strcasecmp(field->table, table))
+      || (field->org_table && !myodbc_strcasecmp(field->org_table, table)));
+}
+
+
+/*
+  Finds the ORDER BY column in the first chunk's result. The key must be a
+  unique not null column that compares on the server the way it is sorted,
+  and has exact text representation. If several columns of the result may
+  be the one the query is ordered by, the key is not used.
+*/
+static int scroller_key_column(STMT *stmt)
+{
+  MYSQL_RES *result= stmt->result;
+  unsigned int i;
+  int key= -2;
+
+  for (i= 0; i < result->field_count; ++i)
+  {
+    MYSQL_FIELD *field= result->fields + i;
+
+    if (!scroller_is_key_field(stmt, field))
+    {
+      continue;
+    }
+
+    if (key != -2)
+    {
+      return -2;
+    }
+
+    if (!field->org_name || !*field->org_name
+      || !(field->flags & NOT_NULL_FLAG)
+      || !(field->flags & (PRI_KEY_FLAG | UNIQUE_KEY_FLAG)))
+    {
+      return -2;
+    }
+
+    switch (field->type)
+    {
+      case MYSQL_TYPE_TINY:
+      case MYSQL_TYPE_SHORT:
+      case MYSQL_TYPE_INT24:
+      case MYSQL_TYPE_LONG:
+      case MYSQL_TYPE_LONGLONG:
+      case MYSQL_TYPE_DECIMAL:
+      case MYSQL_TYPE_NEWDECIMAL:
+      case MYSQL_TYPE_YEAR:
+      case MYSQL_TYPE_DATE:
+      case MYSQL_TYPE_TIME:
+      case MYSQL_TYPE_DATETIME:
+      case MYSQL_TYPE_TIMESTAMP:
+        break;
+
+      case MYSQL_TYPE_STRING:
+      case MYSQL_TYPE_VAR_STRING:
+      case MYSQL_TYPE_VARCHAR:
+        if (field->charsetnr == BINARY_CHARSET_NUMBER)
+        {
+          return -2;
+        }
+        break;
+
+      default:
+        return -2;
+    }
+
+    key= (int)i;
+  }
+
+  return key;
+}
+
+
+/*
+  Builds the query for the next chunk from the last key of the current one:
+  "... WHERE (<condition>) AND key >= <last> ORDER BY key LIMIT <seen>,<count>"
+  Skipping the rows already seen with the last key keeps the result right
+  even if the key turns out to be not unique, e.g. part of a composite
+  primary key.
+
+  @return TRUE if scroller.key_query has been built for the next chunk,
+          FALSE if the offset query has to be used.
+*/
+static BOOL scroller_key_query(STMT *stmt, unsigned long long count)
+{
+  MY_LIMIT_SCROLLER *scroller= &stmt->scroller;
+  MYSQL_RES *result= stmt->result;
+  MYSQL_FIELD *field;
+  MYSQL_ROW row;
+  unsigned long *lengths;
+  char *last= NULL, *tail, *limit_pos;
+  unsigned long last_len= 0;
+  my_ulonglong rows, run= 0;
+  DYNAMIC_STRING query;
+  char buff[7/*" LIMIT "*/ + 2 * MAX64_BUFF_SIZE + 1];
+  int col;
+
+  /* Streamed results can't be read again for the last key */
+  if (scroller->order_pos == NULL || scroller->key_column == -2
+    || result == NULL || result->data == NULL)
+  {
+    return FALSE;
+  }
+
+  if (scroller->key_column == -1)
+  {
+    scroller->key_column= scroller_key_column(stmt);
+  }
+
+  col= scroller->key_column;
+  rows= mysql_num_rows(result);
+
+  /* The next chunk has to follow the current one right away */
+  if (col < 0 || rows == 0
+    || scroller->result_offset + rows != scroller->chunk_offset)
+  {
+    goto no_key;
+  }
+
+  mysql_data_seek(result, 0);
+  while ((row= mysql_fetch_row(result)) != NULL)
+  {
+    lengths= mysql_fetch_lengths(result);
+
+    if (row[col] == NULL)
+    {
+      goto no_key;
+    }
+
+    if (last && lengths[col] == last_len && !memcmp(last, row[col], last_len))
+    {
+      ++run;
+    }
+    else
+    {
+      run= 1;
+    }
+
+    last= row[col];
+    last_len= lengths[col];
+  }
+
+  /* Rows with this key in earlier chunks are known only if the previous
+     chunk has been followed by the key as well */
+  if (run == rows)
+  {
+    if (scroller->key_value == NULL || scroller->key_value_len != last_len
+      || memcmp(scroller->key_value, last, last_len))
+    {
+      goto no_key;
+    }
+    run+= scroller->key_dups;
+  }
+
+  x_free(scroller->key_value);
+  if (!(scroller->key_value= (char *)myodbc_malloc(last_len + 1, MYF(0))))
+  {
+    goto no_key;
+  }
+  memcpy(scroller->key_value, last, last_len);
+  scroller->key_value_len= last_len;
+  scroller->key_dups= run;
+
+  if (init_dynamic_string(&query, "", (size_t)scroller->query_len +
+                          2 * last_len + 2 * NAME_LEN + 32, 1024))
+  {
+    return FALSE;
+  }
+
+  field= result->fields + col;
+  limit_pos= scroller->offset_pos - 7;
+  tail= scroller->offset_pos + MAX64_BUFF_SIZE + MAX32_BUFF_SIZE - 1;
+
+  if (scroller->where_pos)
+  {
+    dynstr_append_mem(&query, scroller->query,
+                      scroller->where_pos - scroller->query);
+    dynstr_append_mem(&query, " (", 2);
+    dynstr_append_mem(&query, scroller->where_pos,
+                      scroller->order_pos - scroller->where_pos);
+    dynstr_append_mem(&query, ") AND ", 6);
+  }
+  else
+  {
+    dynstr_append_mem(&query, scroller->query,
+                      scroller->order_pos - scroller->query);
+    dynstr_append_mem(&query, " WHERE ", 7);
+  }
+
+  if (field->table && *field->table)
+  {
+    dynstr_append_quoted_name(&query, field->table);
+    dynstr_append_mem(&query, ".", 1);
+  }
+  dynstr_append_quoted_name(&query, field->org_name);
+  dynstr_append_mem(&query, scroller->key_desc ? " <= " : " >= ", 4);
+
+  if (IS_NUM(field->type))
+  {
+    dynstr_append_mem(&query, last, last_len);
+  }
+  else
+  {
+    char *to= (char *)myodbc_malloc(2 * last_len + 1, MYF(0));
+
+    if (to == NULL)
+    {
+      dynstr_free(&query);
+      return FALSE;
+    }
+
+    dynstr_append_mem(&query, "'", 1);
+    dynstr_append_mem(&query, to, mysql_real_escape_string(&stmt->dbc->mysql,
+                                                           to, last, last_len));
+    dynstr_append_mem(&query, "'", 1);
+    x_free(to);
+  }
+
+  dynstr_append_mem(&query, " ", 1);
+  dynstr_append_mem(&query, scroller->order_pos,
+                    limit_pos - scroller->order_pos);
+  myodbc_snprintf(buff, sizeof(buff), " LIMIT %llu,%llu",
+                  (unsigned long long)run, count);
+  dynstr_append(&query, buff);
+  dynstr_append_mem(&query, tail,
+                    scroller->query + scroller->query_len - tail);
+
+  x_free(scroller->key_query);
+  scroller->key_query= query.str;
+  scroller->key_query_len= query.length;
+
+  return TRUE;
+
+no_key:
+  x_free(scroller->key_value);
+  scroller->key_value= NULL;
+  return FALSE;
+}
+
 /* Initialization of a scroller */
 void scroller_create(STMT * stmt, char *query, SQLULEN query_len)
 {
@@ -613,12 +2160,21 @@ void scroller_create(STMT * stmt, char *query, SQLULEN query_len)
   memcpy(stmt->scroller.offset_pos + MAX64_BUFF_SIZE + MAX32_BUFF_SIZE - 1, limit.end,
           query + query_len - limit.end);
   *(stmt->scroller.query + stmt->scroller.query_len)= '\0';
+
+  stmt->scroller.result_offset= stmt->scroller.next_offset;
+
+  if (stmt->dbc->ds->prefetch_keyset)
+  {
+    scroller_find_key(stmt, limit.begin);
+  }
 }
 
 
 /* Returns next offset/maxrow for current fetch*/
 unsigned long long scroller_move(STMT * stmt)
 {
+  stmt->scroller.chunk_offset= stmt->scroller.next_offset;
+
   myodbc_snprintf(stmt->scroller.offset_pos, MAX64_BUFF_SIZE, "%*llu", MAX64_BUFF_SIZE - 1,
     stmt->scroller.next_offset);
   stmt->scroller.offset_pos[MAX64_BUFF_SIZE - 1]=',';
@@ -631,20 +2187,25 @@ unsigned long long scroller_move(STMT * stmt)
 
 SQLRETURN scroller_prefetch(STMT * stmt)
 {
+  unsigned long long count= stmt->scroller.row_count;
+  char *query= stmt->scroller.query;
+  unsigned long long query_len= stmt->scroller.query_len;
+
   if (stmt->scroller.total_rows > 0
       && stmt->scroller.next_offset >= (stmt->scroller.total_rows + stmt->scroller.start_offset))
   {
     /* (stmt->scroller.next_offset - stmt->scroller.row_count) - current offset,
        0 minimum. scroller initialization makes impossible row_count to be > 
        stmt's max_rows */
-     long long count= stmt->scroller.total_rows -
+     long long count_left= stmt->scroller.total_rows -
       (stmt->scroller.next_offset - stmt->scroller.row_count - stmt->scroller.start_offset);
 
-    if (count > 0)
+    if (count_left > 0)
     {
       myodbc_snprintf(stmt->scroller.offset_pos + MAX64_BUFF_SIZE, MAX32_BUFF_SIZE,
-              "%*u", MAX32_BUFF_SIZE - 1, (unsigned long)count);
+              "%*u", MAX32_BUFF_SIZE - 1, (unsigned long)count_left);
       stmt->scroller.offset_pos[MAX64_BUFF_SIZE + MAX32_BUFF_SIZE - 1] = ' ';
+      count= (unsigned long long)count_left;
     }
     else
     {
@@ -652,18 +2213,24 @@ SQLRETURN scroller_prefetch(STMT * stmt)
     }
   }
 
-  MYLOG_QUERY(stmt, stmt->scroller.query);
+  if (scroller_key_query(stmt, count))
+  {
+    query= stmt->scroller.key_query;
+    query_len= stmt->scroller.key_query_len;
+  }
+
+  MYLOG_QUERY(stmt, query);
 
   myodbc_mutex_lock(&stmt->dbc->lock);
 
-  if (exec_stmt_query(stmt, stmt->scroller.query,
-                        (unsigned long)stmt->scroller.query_len, FALSE))
+  if (exec_stmt_query(stmt, query, (unsigned long)query_len, FALSE))
   {
     myodbc_mutex_unlock(&stmt->dbc->lock);
     return SQL_ERROR;
   }
 
   get_result_metadata(stmt, FALSE);
+  stmt->scroller.result_offset= stmt->scroller.chunk_offset;
 
   /* I think there is no need to do fix_result_types here */
   myodbc_mutex_unlock(&stmt->dbc->lock);
@@ -55,6 +55,9 @@
 #define MYLOG_DBC_QUERY(A,B) {if((A)->ds->save_queries) \
                query_print((A)->query_log,(char*) B);}
 
+#define FLIGHT_RECORD(D,H,T,C,V) {if ((D)->flight) \
+               flight_record((D),(H),(T),(C),(V));}
+
 /* A few character sets we care about. */
 #define ASCII_CHARSET_NUMBER  11
 #define BINARY_CHARSET_NUMBER 63
@@ -139,9 +142,12 @@ SQLRETURN         insert_params         (STMT *stmt, SQLULEN row, char **finalqu
                                         SQLULEN *length);
 SQLRETURN odbc_stmt(DBC *dbc, const char *query, SQLULEN query_length,
                     my_bool reqLock);
+int       full_result_metadata(DBC *dbc);
 void      myodbc_link_fields (STMT *stmt,MYSQL_FIELD *fields,uint field_count);
 void      fix_row_lengths   (STMT *stmt, const long* fix_rules, uint row, uint field_count);
 void      fix_result_types  (STMT *stmt);
+void      fill_ird_rec      (STMT *stmt, DESCREC *irrec);
+void      fill_ird_recs     (STMT *stmt);
 char *    fix_str           (char *to,const char *from,int length);
 char *    dupp_str          (char *from,int length);
 SQLRETURN my_pos_delete (STMT *stmt,STMT *stmtParam,
@@ -324,6 +330,49 @@ void free_internal_result_buffers(STMT *stmt);
 void query_print          (FILE *log_file,char *query);
 FILE *init_query_log      (void);
 void end_query_log        (FILE *query_log);
+void flight_record        (DBC *dbc, void *handle, uint type, int code,
+                           ulonglong value);
+void flight_error         (DBC *dbc, void *handle, const char *sqlstate,
+                           int native_error);
+void flight_mutex_lock    (DBC *dbc, void *handle);
+char *flight_dump         (DBC *dbc);
+void slow_query_record    (STMT *stmt, const char *query, SQLULEN query_length,
+                           ulonglong elapsed);
+void slow_query_end       (DBC *dbc);
+void worker_pool_init     (void);
+void worker_pool_end      (void);
+void worker_pool_attach   (void);
+void worker_pool_detach   (void);
+uint worker_pool_start    (uint threads);
+void worker_pool_run      (WORKER_TASK *tasks, uint count);
+void admission_init       (void);
+void admission_end        (void);
+ADMISSION *admission_get  (const char *host, uint port, uint limit);
+my_bool admission_enter   (ADMISSION *adm, uint timeout_ms);
+void admission_leave      (ADMISSION *adm);
+char *admission_dump      (DBC *dbc);
+ulonglong myodbc_micro_time(void);
+
+/* kernels.c */
+void myodbc_kernels_init  (void);
+
+/* pooling.c */
+void pool_track_session   (STMT *stmt, const char *query, SQLULEN query_length);
+#ifdef MYODBC_DRIVER_AWARE_POOLING
+void pool_init            (void);
+void pool_end             (void);
+SQLRETURN my_SQLAllocDbcInfoToken(SQLHENV henv, SQLHANDLE *ptoken);
+SQLRETURN my_SQLFreeDbcInfoToken (SQLHANDLE htoken);
+SQLRETURN MySQLSetDriverConnectInfo(SQLHDBC_INFO_TOKEN htoken,
+                                    SQLWCHAR *conn_str, SQLSMALLINT len);
+SQLRETURN MySQLSetConnectInfo(SQLHDBC_INFO_TOKEN htoken,
+                              SQLWCHAR *dsn, SQLSMALLINT dsn_len,
+                              SQLWCHAR *uid, SQLSMALLINT uid_len,
+                              SQLWCHAR *pwd, SQLSMALLINT pwd_len);
+SQLRETURN MySQLSetConnectAttrForDbcInfo(SQLHDBC_INFO_TOKEN htoken,
+                                        SQLINTEGER attribute, SQLPOINTER value,
+                                        SQLINTEGER len);
+#endif
 
 LIST *list_delete_forward (LIST *elem);
 
@@ -378,10 +427,17 @@ int           reset_connection        (DBC *dbc);
 /* Actions taken when connection is taken from the pool */
 int           wakeup_connection       (DBC *dbc);
 #define WAKEUP_CONN_IF_NEEDED(dbc) if (dbc->need_to_wakeup && wakeup_connection(dbc)) return SQL_ERROR
+/* Establishes the physical connection deferred by LAZY_CONNECT */
+#define CONNECT_IF_NEEDED(dbc) if (dbc->need_to_connect && !SQL_SUCCEEDED(myodbc_connect_deferred(dbc))) return SQL_ERROR
 
 /*results.c*/
 long long     binary2numeric        (long long *dst, char *src, uint srcLen);
 void          fill_ird_data_lengths (DESC *ird, ulong *lengths, uint fields);
+SQLRETURN     fill_fetch_buffers    (STMT *stmt, MYSQL_ROW values,
+                                     ulong *lengths, uint rownum);
+SQLUSMALLINT  sqlreturn2row_status  (SQLRETURN res);
+SQLRETURN     stmt_export           (STMT *stmt, SQLCHAR *path,
+                                     SQLINTEGER path_len);
 
 /* Functions to work with prepared and regular statements  */
 
@@ -410,6 +466,19 @@ MYSQL_ROW_OFFSET  row_seek            (STMT *stmt, MYSQL_ROW_OFFSET offset);
 void              data_seek           (STMT *stmt, my_ulonglong offset);
 MYSQL_ROW_OFFSET  row_tell            (STMT *stmt);
 int               next_result         (STMT *stmt);
+int               metadata_cache_before_exec(STMT *stmt, const char *query,
+                                             SQLULEN query_length);
+int               metadata_cache_after_exec (STMT *stmt, const char *query,
+                                             SQLULEN query_length);
+void              metadata_cache_free (STMT *stmt);
+void              metadata_cache_track(STMT *stmt);
+char *            max_length_query    (STMT *stmt, char *query,
+                                       SQLULEN *query_length);
+void              max_length_fix_fields(STMT *stmt, const char *query);
+void              max_length_cache_free(STMT *stmt);
+void              read_ahead_start    (STMT *stmt);
+void              read_ahead_stop     (STMT *stmt);
+my_bool           read_ahead_failed   (STMT *stmt);
 SQLRETURN         send_long_data      (STMT *stmt, unsigned int param_num, DESCREC * aprec,
                                       const char *chunk, unsigned long length);
 
@@ -423,6 +492,7 @@ long double   get_double  (STMT *stmt, ulong column_number, char *value,
                           ulong length);
 BOOL          is_null     (STMT *stmt, ulong column_number, char *value);
 SQLRETURN     prepare     (STMT *stmt, char * query, SQLINTEGER query_length);
+SQLRETURN     prepare_on_server(STMT *stmt);
 
 /* scroller-related functions */
 void          scroller_reset      (STMT *stmt);
@@ -455,9 +525,18 @@ char *      ssps_get_string       (STMT *stmt, ulong column_number, char *value,
 SQLRETURN   ssps_send_long_data   (STMT *stmt, unsigned int param_num, const char *chunk,
                                   unsigned long length);
 MYSQL_BIND * get_param_bind       (STMT *stmt, unsigned int param_number, int reset);
+ulonglong   ssps_param_bind_signature(STMT *stmt);
+void        ssps_adapt_before_exec(STMT *stmt, BOOL is_select);
+void        ssps_adapt_after_exec (STMT *stmt);
 
 /* connect.c */
 void free_connection_stmts(DBC *dbc);
+SQLRETURN myodbc_connect_deferred(DBC *dbc);
+SQLRETURN myodbc_do_connect(DBC *dbc, DataSource *ds);
+SQLRETURN myodbc_set_initial_character_set(DBC *dbc, const char *charset);
+SQLRETURN myodbc_init_session(DBC *dbc, DataSource *ds);
+void      myodbc_set_connect_options(DBC *dbc, MYSQL *mysql, DataSource *ds);
+my_bool   myodbc_side_connect(DBC *dbc, MYSQL *mysql);
 
 #ifdef __WIN__
 #define cmp_database(A,B) myodbc_strcasecmp((const char *)(A),(const char *)(B))
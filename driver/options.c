@@ -344,6 +344,8 @@ MySQLSetConnectAttr(SQLHDBC hdbc, SQLINTEGER Attribute,
         }
         x_free(dbc->database);
         dbc->database= myodbc_strdup(db,MYF(MY_WME));
+        /* Unqualified names may refer to other tables now */
+        ++dbc->schema_version;
         myodbc_mutex_unlock(&dbc->lock);
       }
       break;
@@ -447,10 +449,11 @@ MySQLSetConnectAttr(SQLHDBC hdbc, SQLINTEGER Attribute,
  @param[in]  attrib
  @param[out] char_attr
  @param[out] num_attr
+ @param[out] free_char_attr  Set if char_attr is allocated for the caller
 */
 SQLRETURN SQL_API
 MySQLGetConnectAttr(SQLHDBC hdbc, SQLINTEGER attrib, SQLCHAR **char_attr,
-                    SQLPOINTER num_attr)
+                    SQLPOINTER num_attr, my_bool *free_char_attr)
 {
   DBC *dbc= (DBC *)hdbc;
   SQLRETURN result= SQL_SUCCESS;
@@ -463,6 +466,12 @@ MySQLGetConnectAttr(SQLHDBC hdbc, SQLINTEGER attrib, SQLCHAR **char_attr,
     WAKEUP_CONN_IF_NEEDED(dbc);
   }
 
+  /* These are answered from the session, so the deferred connect happens now */
+  if (attrib == SQL_ATTR_AUTOCOMMIT || attrib == SQL_ATTR_PACKET_SIZE)
+  {
+    CONNECT_IF_NEEDED(dbc);
+  }
+
   switch (attrib)
   {
   case SQL_ATTR_ACCESS_MODE:
@@ -482,7 +491,9 @@ MySQLGetConnectAttr(SQLHDBC hdbc, SQLINTEGER attrib, SQLCHAR **char_attr,
 
   case SQL_ATTR_CONNECTION_DEAD:
     /* If waking up fails - we return "connection is dead", no matter what really the reason is */
-    if (dbc->need_to_wakeup != 0 && wakeup_connection(dbc)
+    if (dbc->need_to_connect)
+      *((SQLUINTEGER *)num_attr)= SQL_CD_FALSE;
+    else if (dbc->need_to_wakeup != 0 && wakeup_connection(dbc)
       || dbc->need_to_wakeup == 0 && mysql_ping(&dbc->mysql) &&
         (mysql_errno(&dbc->mysql) == CR_SERVER_LOST ||
          mysql_errno(&dbc->mysql) == CR_SERVER_GONE_ERROR))
@@ -502,7 +513,7 @@ MySQLGetConnectAttr(SQLHDBC hdbc, SQLINTEGER attrib, SQLCHAR **char_attr,
       return set_handle_error(SQL_HANDLE_DBC, hdbc, MYERR_S1000,
                               "Unable to get current catalog", 0);
     }
-    else if (is_connected(dbc))
+    else if (is_connected(dbc) || dbc->need_to_connect)
     {
       *char_attr= (SQLCHAR *)(dbc->database ? dbc->database : "null");
     }
@@ -579,6 +590,28 @@ MySQLGetConnectAttr(SQLHDBC hdbc, SQLINTEGER attrib, SQLCHAR **char_attr,
     *((SQLINTEGER *)num_attr)= dbc->txn_isolation;
     break;
 
+  case SQL_ATTR_MYODBC_FLIGHT_RECORDER:
+    if (!dbc->flight)
+    {
+      return set_handle_error(SQL_HANDLE_DBC, hdbc, MYERR_S1C00,
+                              "FLIGHT_RECORDER option is not enabled", 0);
+    }
+    /* Other threads may dump at the same time, each gets its own copy */
+    if (!(*char_attr= (SQLCHAR *)flight_dump(dbc)))
+    {
+      return set_handle_error(SQL_HANDLE_DBC, hdbc, MYERR_S1001, NULL, 4001);
+    }
+    *free_char_attr= TRUE;
+    break;
+
+  case SQL_ATTR_MYODBC_ADMISSION:
+    if (!(*char_attr= (SQLCHAR *)admission_dump(dbc)))
+    {
+      return set_handle_error(SQL_HANDLE_DBC, hdbc, MYERR_S1C00,
+                              "MAX_QUERIES option is not enabled", 0);
+    }
+    break;
+
   default:
     return set_handle_error(SQL_HANDLE_DBC, hdbc, MYERR_S1092, NULL, 0);
   }
@@ -594,7 +627,7 @@ MySQLGetConnectAttr(SQLHDBC hdbc, SQLINTEGER attrib, SQLCHAR **char_attr,
 
 SQLRETURN SQL_API
 MySQLSetStmtAttr(SQLHSTMT hstmt, SQLINTEGER Attribute, SQLPOINTER ValuePtr,
-                 SQLINTEGER StringLengthPtr __attribute__((unused)))
+                 SQLINTEGER StringLengthPtr)
 {
     STMT *stmt= (STMT *)hstmt;
     SQLRETURN result= SQL_SUCCESS;
@@ -770,6 +803,9 @@ MySQLSetStmtAttr(SQLHSTMT hstmt, SQLINTEGER Attribute, SQLPOINTER ValuePtr,
             options->simulateCursor= (SQLUINTEGER)(SQLULEN)ValuePtr;
             break;
 
+        case SQL_ATTR_MYODBC_EXPORT:
+            return stmt_export(stmt, (SQLCHAR *)ValuePtr, StringLengthPtr);
+
             /*
               3.x driver doesn't support any statement attributes
               at connection level, but to make sure all 2.x apps
@@ -538,6 +538,57 @@ BOOL stmt_returns_result(const MY_PARSED_QUERY *query)
 }
 
 
+/**
+  Detects the constant queries that connection pools and frameworks send
+  to validate connections. Only the exact forms are recognized, the select
+  list may be followed by spaces and a semicolon.
+*/
+LOCAL_PROBE_ENUM local_probe_type(MY_PARSED_QUERY *query)
+{
+  static const struct
+  {
+    const char *      text;
+    size_t            length;
+    LOCAL_PROBE_ENUM  probe;
+  } probes[]= {{"1", 1, myprobeOne},
+               {"@@version", 9, myprobeVersion},
+               {"VERSION()", 9, myprobeVersion}};
+  const char *pos, *end;
+  uint i, tokens= TOKEN_COUNT(query);
+
+  /* "SELECT 1 ;" - the separator after a space is a token of its own */
+  while (tokens > 2 && *get_token(query, tokens - 1) == ';')
+  {
+    --tokens;
+  }
+
+  if (query->query_type != myqtSelect || tokens != 2
+    || PARAM_COUNT(query) != 0 || query->is_batch != NULL)
+  {
+    return myprobeNone;
+  }
+
+  pos= get_token(query, 1);
+  end= GET_QUERY_END(query);
+
+  while (end > pos && (isspace((unsigned char)end[-1]) || end[-1] == ';'))
+  {
+    --end;
+  }
+
+  for (i= 0; i < array_elements(probes); ++i)
+  {
+    if ((size_t)(end - pos) == probes[i].length
+      && myodbc_casecmp(pos, probes[i].text, probes[i].length) == 0)
+    {
+      return probes[i].probe;
+    }
+  }
+
+  return myprobeNone;
+}
+
+
 /* TRUE if end has been reached */
 BOOL skip_spaces(MY_PARSER *parser)
 {
@@ -782,7 +833,11 @@ BOOL tokenize(MY_PARSER *parser)
       /* is_query_separator moves position to the 1st char of the next query */
       if (is_query_separator(parser))
       {
-        skip_spaces(parser);
+        /* Something after the separator is the 2nd query of a batch */
+        if (!skip_spaces(parser) && parser->query->is_batch == NULL)
+        {
+          parser->query->is_batch= parser->pos;
+        }
 
         if (add_token(parser))
         {
@@ -55,6 +55,14 @@ typedef enum myodbcQueryType
                      care about for that or other reason */
 } QUERY_TYPE_ENUM;
 
+/* Validation queries the driver can answer without the server */
+typedef enum myodbcLocalProbe
+{
+  myprobeNone= 0,
+  myprobeOne,       /* SELECT 1 */
+  myprobeVersion    /* SELECT @@version, SELECT VERSION() */
+} LOCAL_PROBE_ENUM;
+
 typedef struct qt_resolving
 {
   const MY_STRING *           keyword;
@@ -216,6 +224,7 @@ BOOL        is_create_function      (const SQLCHAR * query);
 BOOL        is_use_db               (const SQLCHAR * query);
 BOOL        is_call_procedure       (const MY_PARSED_QUERY *query);
 BOOL        stmt_returns_result     (const MY_PARSED_QUERY *query);
+LOCAL_PROBE_ENUM local_probe_type   (MY_PARSED_QUERY *query);
 
 BOOL        remove_braces           (MY_PARSER *query);
 
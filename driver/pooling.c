@@ -0,0 +1,618 @@
+/*
+  Copyright (c) 2000, 2014, Oracle and/or its affiliates. All rights reserved.
+
+  The MySQL Connector/ODBC is licensed under the terms of the GPLv2
+  <http://www.gnu.org/licenses/old-licenses/gpl-2.0.html>, like most
+  MySQL Connectors. There are special exceptions to the terms and
+  conditions of the GPLv2 as it is applied to this software, see the
+  FLOSS License Exception
+  <http://www.mysql.com/about/legal/licensing/foss-exception.html>.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published
+  by the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+  for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/**
+  @file  pooling.c
+  @brief ODBC 3.81 driver-aware connection pooling.
+
+  The driver manager describes a connection request with a DBC info token.
+  Connections whose data source differs only in the catalog and character
+  set share a pool, and the driver rates how well each pooled connection
+  matches the request. The session of a reused connection is reset only if
+  the statements executed on it may have left some state behind.
+*/
+
+#include "driver.h"
+
+
+/*
+  Marks the session of the connection as changed by the query, unless the
+  query is a single SELECT that can not leave anything behind - a user
+  variable, a named lock or an open transaction. The statements of a batch
+  after the first one are not parsed, so any batch counts as a change.
+*/
+void pool_track_session(STMT *stmt, const char *query, SQLULEN query_length)
+{
+  DBC *dbc= stmt->dbc;
+  const char *end= query + query_length;
+
+  if (dbc->session_dirty)
+  {
+    return;
+  }
+
+  if (!is_select_statement(&stmt->query) || IS_BATCH(&stmt->query)
+    || (dbc->ds->allow_multiple_statements && memchr(query, ';', query_length))
+    || memchr(query, '@', query_length)
+    || (dbc->mysql.server_status & SERVER_STATUS_IN_TRANS))
+  {
+    dbc->session_dirty= TRUE;
+    return;
+  }
+
+  for (; query + 8 <= end; ++query)
+  {
+    if (!myodbc_casecmp(query, "GET_LOCK", 8))
+    {
+      dbc->session_dirty= TRUE;
+      return;
+    }
+  }
+}
+
+
+#ifdef MYODBC_DRIVER_AWARE_POOLING
+
+/*
+  Pool ids handed out to the driver manager. An id is the address of the
+  entry, the entry is kept until the driver manager cleans the pool up.
+*/
+typedef struct pool_entry
+{
+  struct pool_entry *next;
+  SQLWCHAR          *key;
+} POOL_ENTRY;
+
+static myodbc_mutex_t pool_lock;
+static POOL_ENTRY     *pool_list;
+
+
+void pool_init(void)
+{
+  myodbc_mutex_init(&pool_lock, NULL);
+}
+
+
+void pool_end(void)
+{
+  POOL_ENTRY *entry;
+
+  while ((entry= pool_list))
+  {
+    pool_list= entry->next;
+    x_free(entry->key);
+    x_free(entry);
+  }
+
+  myodbc_mutex_destroy(&pool_lock);
+}
+
+
+/*
+  Returns the options of the data source that can not be changed on an
+  open connection. Data sources with the same key can share connections.
+*/
+static SQLWCHAR *pool_key(DataSource *ds)
+{
+  SQLWCHAR *name= ds->name, *description= ds->description,
+           *database= ds->database, *charset= ds->charset;
+  SQLWCHAR *key;
+  size_t   len;
+
+  ds->name= ds->description= ds->database= ds->charset= NULL;
+
+  len= ds_to_kvpair_len(ds) + 1;
+  key= (SQLWCHAR *)myodbc_malloc(len * sizeof(SQLWCHAR), MYF(0));
+  if (key && ds_to_kvpair(ds, key, len, ';') == -1)
+  {
+    x_free(key);
+    key= NULL;
+  }
+
+  ds->name= name;
+  ds->description= description;
+  ds->database= database;
+  ds->charset= charset;
+
+  return key;
+}
+
+
+static BOOL same_key(const SQLWCHAR *a, const SQLWCHAR *b)
+{
+  size_t len= sqlwcharlen(a);
+
+  return len == sqlwcharlen(b) && !memcmp(a, b, len * sizeof(SQLWCHAR));
+}
+
+
+static BOOL same_attr(SQLWCHAR *a, SQLWCHAR *b)
+{
+  if (!a || !*a || !b || !*b)
+  {
+    return (!a || !*a) && (!b || !*b);
+  }
+
+  return !sqlwcharcasecmp(a, b);
+}
+
+
+static BOOL same_pool(DataSource *a, DataSource *b)
+{
+  SQLWCHAR *key_a= pool_key(a), *key_b= pool_key(b);
+  BOOL     same= key_a && key_b && same_key(key_a, key_b);
+
+  x_free(key_a);
+  x_free(key_b);
+
+  return same;
+}
+
+
+SQLRETURN my_SQLAllocDbcInfoToken(SQLHENV henv, SQLHANDLE *ptoken)
+{
+  DBC_INFO_TOKEN *token;
+
+  if (!(token= (DBC_INFO_TOKEN *)myodbc_malloc(sizeof(DBC_INFO_TOKEN),
+                                               MYF(MY_ZEROFILL))))
+  {
+    *ptoken= SQL_NULL_HANDLE;
+    return set_env_error((ENV *)henv, MYERR_S1001, NULL, 0);
+  }
+
+  token->env= (ENV *)henv;
+  *ptoken= (SQLHANDLE)token;
+
+  return SQL_SUCCESS;
+}
+
+
+SQLRETURN my_SQLFreeDbcInfoToken(SQLHANDLE htoken)
+{
+  DBC_INFO_TOKEN *token= (DBC_INFO_TOKEN *)htoken;
+
+  if (token->ds)
+  {
+    ds_delete(token->ds);
+  }
+  x_free(token->conn_str);
+  x_free(token->catalog);
+  x_free(token->catalog8);
+  x_free(token);
+
+  return SQL_SUCCESS;
+}
+
+
+/* The data source of the request is replaced, attributes are kept */
+static void token_reset_ds(DBC_INFO_TOKEN *token)
+{
+  if (token->ds)
+  {
+    ds_delete(token->ds);
+  }
+  x_free(token->conn_str);
+  token->conn_str= NULL;
+  token->ds= ds_new();
+}
+
+
+SQLRETURN MySQLSetDriverConnectInfo(SQLHDBC_INFO_TOKEN htoken,
+                                    SQLWCHAR *conn_str, SQLSMALLINT len)
+{
+  DBC_INFO_TOKEN *token= (DBC_INFO_TOKEN *)htoken;
+
+  CHECK_HANDLE(htoken);
+
+  token_reset_ds(token);
+  if (!token->ds ||
+      !(token->conn_str= sqlwchardup(conn_str, len == SQL_NTS ?
+                                     sqlwcharlen(conn_str) : len)))
+  {
+    return SQL_ERROR;
+  }
+
+  if (ds_from_kvpair(token->ds, token->conn_str, (SQLWCHAR)';'))
+  {
+    return SQL_ERROR;
+  }
+
+#ifndef NO_DRIVERMANAGER
+  /* Options of the connection string override the ones of the DSN */
+  if (token->ds->name)
+  {
+    ds_lookup(token->ds);
+    ds_from_kvpair(token->ds, token->conn_str, (SQLWCHAR)';');
+  }
+#endif
+
+  return SQL_SUCCESS;
+}
+
+
+SQLRETURN MySQLSetConnectInfo(SQLHDBC_INFO_TOKEN htoken,
+                              SQLWCHAR *dsn, SQLSMALLINT dsn_len,
+                              SQLWCHAR *uid, SQLSMALLINT uid_len,
+                              SQLWCHAR *pwd, SQLSMALLINT pwd_len)
+{
+  DBC_INFO_TOKEN *token= (DBC_INFO_TOKEN *)htoken;
+
+  CHECK_HANDLE(htoken);
+
+#ifdef NO_DRIVERMANAGER
+  return SQL_ERROR;
+#else
+  token_reset_ds(token);
+  if (!token->ds || !dsn || !dsn[0])
+  {
+    return SQL_ERROR;
+  }
+
+  ds_set_strnattr(&token->ds->name, dsn, dsn_len);
+  ds_set_strnattr(&token->ds->uid, uid, uid_len);
+  ds_set_strnattr(&token->ds->pwd, pwd, pwd_len);
+  ds_lookup(token->ds);
+
+  return SQL_SUCCESS;
+#endif
+}
+
+
+/*
+  Keeps the connection attributes of the request that decide whether a
+  pooled connection matches. Others are set by the driver manager on the
+  connection it gets.
+*/
+SQLRETURN MySQLSetConnectAttrForDbcInfo(SQLHDBC_INFO_TOKEN htoken,
+                                        SQLINTEGER attribute, SQLPOINTER value,
+                                        SQLINTEGER len)
+{
+  DBC_INFO_TOKEN *token= (DBC_INFO_TOKEN *)htoken;
+
+  CHECK_HANDLE(htoken);
+
+  switch (attribute)
+  {
+  case SQL_ATTR_AUTOCOMMIT:
+    token->autocommit= (SQLUINTEGER)(SQLULEN)value;
+    token->autocommit_set= TRUE;
+    break;
+
+  case SQL_ATTR_TXN_ISOLATION:
+    token->txn_isolation= (SQLINTEGER)(SQLLEN)value;
+    break;
+
+  case SQL_ATTR_CURRENT_CATALOG:
+    x_free(token->catalog);
+    token->catalog= sqlwchardup((SQLWCHAR *)value, len == SQL_NTS ?
+                                sqlwcharlen((SQLWCHAR *)value) :
+                                len / sizeof(SQLWCHAR));
+    if (!token->catalog)
+    {
+      return SQL_ERROR;
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  return SQL_SUCCESS;
+}
+
+
+SQLRETURN SQL_API SQLGetPoolID(SQLHDBC_INFO_TOKEN htoken, POOLID *pool_id)
+{
+  DBC_INFO_TOKEN *token= (DBC_INFO_TOKEN *)htoken;
+  POOL_ENTRY     *entry;
+  SQLWCHAR       *key;
+
+  CHECK_HANDLE(htoken);
+
+  if (!token->ds || !(key= pool_key(token->ds)))
+  {
+    return SQL_ERROR;
+  }
+
+  myodbc_mutex_lock(&pool_lock);
+  for (entry= pool_list; entry; entry= entry->next)
+  {
+    if (same_key(entry->key, key))
+    {
+      break;
+    }
+  }
+
+  if (entry)
+  {
+    x_free(key);
+  }
+  else if ((entry= (POOL_ENTRY *)myodbc_malloc(sizeof(POOL_ENTRY), MYF(0))))
+  {
+    entry->key= key;
+    entry->next= pool_list;
+    pool_list= entry;
+  }
+  else
+  {
+    x_free(key);
+  }
+  myodbc_mutex_unlock(&pool_lock);
+
+  if (!entry)
+  {
+    return SQL_ERROR;
+  }
+
+  *pool_id= (POOLID)entry;
+  return SQL_SUCCESS;
+}
+
+
+SQLRETURN SQL_API SQLCleanupConnectionPoolID(SQLHENV henv, POOLID pool_id)
+{
+  POOL_ENTRY **prev, *entry;
+
+  CHECK_HANDLE(henv);
+
+  myodbc_mutex_lock(&pool_lock);
+  for (prev= &pool_list; (entry= *prev); prev= &entry->next)
+  {
+    if ((POOLID)entry == pool_id)
+    {
+      *prev= entry->next;
+      x_free(entry->key);
+      x_free(entry);
+      break;
+    }
+  }
+  myodbc_mutex_unlock(&pool_lock);
+
+  return SQL_SUCCESS;
+}
+
+
+/* The catalog of the request, in UTF-8, or NULL if none is given */
+static const char *token_catalog(DBC_INFO_TOKEN *token)
+{
+  if (token->catalog && token->catalog[0])
+  {
+    return ds_get_utf8attr(token->catalog, &token->catalog8);
+  }
+
+  if (token->ds->database && token->ds->database[0])
+  {
+    return ds_get_utf8attr(token->ds->database, &token->ds->database8);
+  }
+
+  return NULL;
+}
+
+
+/*
+  Rates how well the pooled connection matches the request: 100 - it can be
+  used as it is, 0 - it can not be used. Each thing to be done before the
+  connection is given to the application lowers the rating.
+*/
+SQLRETURN SQL_API SQLRateConnection(SQLHDBC_INFO_TOKEN htoken, SQLHDBC hdbc,
+                                    BOOL enlist __attribute__((unused)),
+                                    TRANSID trans_id __attribute__((unused)),
+                                    SQLConnPoolRating *rating)
+{
+  DBC_INFO_TOKEN *token= (DBC_INFO_TOKEN *)htoken;
+  DBC            *dbc= (DBC *)hdbc;
+  const char     *catalog;
+  int            score= 100;
+
+  CHECK_HANDLE(htoken);
+  CHECK_HANDLE(hdbc);
+
+  *rating= 0;
+
+  if (!token->ds || !dbc->ds || !same_pool(token->ds, dbc->ds)
+    || dbc->unicode != token->unicode)
+  {
+    return SQL_SUCCESS;
+  }
+
+  if (!same_attr(token->ds->charset, dbc->ds->charset))
+  {
+    /* Without a charset given the default one of the new connection is used */
+    if (!token->ds->charset || !token->ds->charset[0])
+    {
+      return SQL_SUCCESS;
+    }
+    score-= 10;
+  }
+
+  if (dbc->session_dirty)
+  {
+    score-= 40;
+  }
+
+  catalog= token_catalog(token);
+  if (catalog && (!dbc->database || cmp_database(catalog, dbc->database)))
+  {
+    score-= 10;
+  }
+
+  if (token->autocommit_set && is_connected(dbc) && trans_supported(dbc)
+    && (token->autocommit == SQL_AUTOCOMMIT_ON) != (autocommit_on(dbc) != 0))
+  {
+    score-= 5;
+  }
+
+  if (token->txn_isolation && token->txn_isolation != dbc->txn_isolation)
+  {
+    score-= 5;
+  }
+
+  *rating= (SQLConnPoolRating)myodbc_max(score, 1);
+  return SQL_SUCCESS;
+}
+
+
+/*
+  Makes the pooled connection match the request. The session is reset only
+  if it has been changed, otherwise only the differences are applied.
+*/
+static SQLRETURN pool_reuse(DBC *dbc, DBC_INFO_TOKEN *token)
+{
+  DataSource *ds= token->ds;
+  const char *catalog= token_catalog(token);
+  BOOL       charset_changed= !same_attr(ds->charset, dbc->ds->charset);
+  SQLRETURN  rc= SQL_SUCCESS;
+
+  /* The rest of the options are the same, as the connection is in the pool */
+  ds_delete(dbc->ds);
+  dbc->ds= ds;
+  token->ds= NULL;
+
+  ds_get_utf8attr(ds->name, &ds->name8);
+  ds_get_utf8attr(ds->server, &ds->server8);
+  ds_get_utf8attr(ds->uid, &ds->uid8);
+  ds_get_utf8attr(ds->pwd, &ds->pwd8);
+  ds_get_utf8attr(ds->socket, &ds->socket8);
+
+  if (dbc->need_to_connect)
+  {
+    /* The deferred connection picks the request's catalog up on connect */
+    dbc->need_to_wakeup= 0;
+  }
+  else if (dbc->session_dirty)
+  {
+    dbc->need_to_wakeup= 1;
+    if (wakeup_connection(dbc))
+    {
+      return set_dbc_error(dbc, "08S01", mysql_error(&dbc->mysql),
+                           mysql_errno(&dbc->mysql));
+    }
+    /* Session is back to defaults of the server */
+    dbc->txn_isolation= 0;
+    dbc->sql_select_limit= (SQLULEN)-1;
+    charset_changed= TRUE;
+  }
+  else
+  {
+    dbc->need_to_wakeup= 0;
+  }
+
+  if (charset_changed && !dbc->need_to_connect)
+  {
+    rc= myodbc_set_initial_character_set(dbc, ds_get_utf8attr(ds->charset,
+                                                              &ds->charset8));
+    if (!SQL_SUCCEEDED(rc))
+    {
+      return rc;
+    }
+  }
+
+  if (catalog && (!dbc->database || cmp_database(catalog, dbc->database)))
+  {
+    rc= MySQLSetConnectAttr(dbc, SQL_ATTR_CURRENT_CATALOG, (SQLPOINTER)catalog,
+                            SQL_NTS);
+  }
+
+  return rc;
+}
+
+
+SQLRETURN SQL_API SQLPoolConnect(SQLHDBC hdbc, SQLHDBC_INFO_TOKEN htoken,
+                                 SQLWCHAR *out, SQLSMALLINT out_max,
+                                 SQLSMALLINT *out_len)
+{
+  DBC_INFO_TOKEN *token= (DBC_INFO_TOKEN *)htoken;
+  DBC            *dbc= (DBC *)hdbc;
+  SQLRETURN      rc;
+
+  CHECK_HANDLE(hdbc);
+  CHECK_HANDLE(htoken);
+
+  CLEAR_DBC_ERROR(dbc);
+
+  if (!token->ds)
+  {
+    return set_dbc_error(dbc, "HY000", "Invalid connection parameters", 0);
+  }
+
+  if (dbc->ds)
+  {
+    rc= pool_reuse(dbc, token);
+  }
+  else
+  {
+    DataSource *ds= token->ds;
+
+    dbc->unicode= token->unicode;
+    if (token->catalog && token->catalog[0])
+    {
+      ds_set_strattr(&ds->database, token->catalog);
+    }
+
+    rc= myodbc_do_connect(dbc, ds);
+    if (dbc->ds == ds)
+    {
+      token->ds= NULL;
+    }
+  }
+
+  if (SQL_SUCCEEDED(rc) && token->autocommit_set)
+  {
+    rc= MySQLSetConnectAttr(dbc, SQL_ATTR_AUTOCOMMIT,
+                            (SQLPOINTER)(SQLULEN)token->autocommit, 0);
+  }
+
+  if (SQL_SUCCEEDED(rc) && token->txn_isolation &&
+      token->txn_isolation != dbc->txn_isolation)
+  {
+    rc= MySQLSetConnectAttr(dbc, SQL_ATTR_TXN_ISOLATION,
+                            (SQLPOINTER)(SQLLEN)token->txn_isolation, 0);
+  }
+
+  if (SQL_SUCCEEDED(rc) && out && out_max > 0)
+  {
+    size_t len= token->conn_str ? sqlwcharlen(token->conn_str) : 0;
+
+    if (len >= (size_t)out_max)
+    {
+      len= out_max - 1;
+      set_dbc_error(dbc, "01004", "String data, right truncated.", 0);
+      rc= SQL_SUCCESS_WITH_INFO;
+    }
+
+    if (len)
+    {
+      memcpy(out, token->conn_str, len * sizeof(SQLWCHAR));
+    }
+    out[len]= 0;
+    if (out_len)
+    {
+      *out_len= (SQLSMALLINT)len;
+    }
+  }
+
+  return rc;
+}
+
+#endif /* MYODBC_DRIVER_AWARE_POOLING */
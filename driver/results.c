@@ -362,26 +362,190 @@ sql_get_bookmark_data(STMT *stmt, SQLSMALLINT fCType, uint column_number,
 }
 
 
-/**
-  Retrieve the data from a field as a specified ODBC C type.
+/*
+  Whether the column can be converted to the C type depends only on them,
+  so the check is done once per result for the type the application uses
+  for the column. Later rows go straight to the conversion.
+*/
+static SQLSMALLINT *verified_ctype_alloc(STMT *stmt)
+{
+  uint columns= stmt->result->field_count;
 
-  TODO arrec->indicator_ptr could be different than pcbValue
-  ideally, two separate pointers would be passed here
+  if (stmt->verified_ctype == NULL && columns > 0)
+  {
+    /* 0 is not a valid C type, thus zero-filled array means "nothing verified" */
+    stmt->verified_ctype= (SQLSMALLINT *)alloc_root(&stmt->alloc_root,
+                                                    sizeof(SQLSMALLINT) * columns);
+    if (stmt->verified_ctype != NULL)
+    {
+      memset(stmt->verified_ctype, 0, sizeof(SQLSMALLINT) * columns);
+    }
+  }
 
-  @param[in]  stmt        Handle of statement
-  @param[in]  fCType      ODBC C type to return data as
-  @param[in]  field       Field describing the type of the data
-  @param[out] rgbValue    Pointer to buffer for returning data
-  @param[in]  cbValueMax  Length of buffer
-  @param[out] pcbValue    Bytes used in the buffer, or SQL_NULL_DATA
-  @param[out] value       The field data to be converted and returned
-  @param[in]  length      Length of value
-  @param[in]  arrec       ARD record for this column (can be NULL)
+  return stmt->verified_ctype;
+}
+
+
+static my_bool conversion_supported(STMT *stmt, MYSQL_FIELD *field,
+                                    uint column_number, SQLSMALLINT fCType)
+{
+  uint columns= stmt->result->field_count;
+
+  if (stmt->verified_ctype != NULL && column_number < columns
+    && stmt->verified_ctype[column_number] == fCType)
+  {
+    return TRUE;
+  }
+
+  if (!odbc_supported_conversion(get_sql_data_type(stmt, field, 0), fCType)
+   && !driver_supported_conversion(field,fCType))
+  {
+    return FALSE;
+  }
+
+  if (verified_ctype_alloc(stmt) != NULL && column_number < columns)
+  {
+    stmt->verified_ctype[column_number]= fCType;
+  }
+
+  return TRUE;
+}
+
+
+/*
+  SQLGetData switches LC_NUMERIC to "C" for the conversion and then back to
+  default_locale. If both are "C" already, there is nothing to switch.
 */
-SQLRETURN SQL_API
-sql_get_data(STMT *stmt, SQLSMALLINT fCType, uint column_number,
-             SQLPOINTER rgbValue, SQLLEN cbValueMax, SQLLEN *pcbValue,
-             char *value, ulong length, DESCREC *arrec)
+static BOOL locale_switch_needed(STMT *stmt)
+{
+  const char *current;
+
+  if (stmt->dbc->ds->dont_use_set_locale)
+  {
+    return FALSE;
+  }
+
+  current= setlocale(LC_NUMERIC, NULL);
+
+  return current == NULL || strcmp(current, "C") || strcmp(default_locale, "C");
+}
+
+
+/* Target types, whose conversion results CONVERSION_MEMO can keep */
+static BOOL conv_memo_supported(STMT *stmt, SQLSMALLINT fCType,
+                                uint column_number)
+{
+  switch (fCType)
+  {
+  case SQL_C_TIMESTAMP:
+  case SQL_C_TYPE_TIMESTAMP:
+    /* TIME is converted to timestamp with the current date */
+    return mysql_fetch_field_direct(stmt->result, column_number)->type
+           != MYSQL_TYPE_TIME;
+  case SQL_C_WCHAR:
+  case SQL_C_BIT:
+  case SQL_C_TINYINT:
+  case SQL_C_STINYINT:
+  case SQL_C_UTINYINT:
+  case SQL_C_SHORT:
+  case SQL_C_SSHORT:
+  case SQL_C_USHORT:
+  case SQL_C_LONG:
+  case SQL_C_SLONG:
+  case SQL_C_ULONG:
+  case SQL_C_FLOAT:
+  case SQL_C_DOUBLE:
+  case SQL_C_SBIGINT:
+  case SQL_C_UBIGINT:
+  case SQL_C_NUMERIC:
+  case SQL_C_DATE:
+  case SQL_C_TYPE_DATE:
+  case SQL_C_TIME:
+  case SQL_C_TYPE_TIME:
+    return TRUE;
+  default:
+    return FALSE;
+  }
+}
+
+
+/*
+  Returns the CONVERSION_MEMO slot for the value of the column, or NULL if the
+  value is not to be memoized. Only text protocol values are memoized, binary
+  protocol ones are cheap to convert anyway.
+*/
+static CONV_MEMO_SLOT * conv_memo_slot(STMT *stmt, SQLSMALLINT fCType,
+                                       uint column_number, char *value,
+                                       ulong length, DESCREC *arrec)
+{
+  CONV_MEMO *memo;
+  SQLSMALLINT precision= 38, scale= 0;
+  ulong hash= 2166136261UL, i;
+
+  if (!stmt->dbc->ds->conversion_memo || ssps_used(stmt) || value == NULL
+    || length == 0 || length > CONV_MEMO_MAX_SRC
+    || stmt->getdata.source != NULL || stmt->stmt_options.max_length
+    || column_number >= field_count(stmt)
+    || !conv_memo_supported(stmt, fCType, column_number))
+  {
+    return NULL;
+  }
+
+  if (stmt->conv_memo == NULL)
+  {
+    size_t size= sizeof(CONV_MEMO) * field_count(stmt);
+
+    if (!(stmt->conv_memo= (CONV_MEMO *)alloc_root(&stmt->alloc_root, size)))
+    {
+      return NULL;
+    }
+    memset(stmt->conv_memo, 0, size);
+  }
+
+  memo= &stmt->conv_memo[column_number];
+
+  if (memo->disabled)
+  {
+    return NULL;
+  }
+
+  if (fCType == SQL_C_NUMERIC && arrec)
+  {
+    precision= arrec->precision;
+    scale= arrec->scale;
+  }
+
+  if (memo->c_type != fCType || memo->precision != precision
+    || memo->scale != scale)
+  {
+    memset(memo->slot, 0, sizeof(memo->slot));
+    memo->c_type= fCType;
+    memo->precision= precision;
+    memo->scale= scale;
+  }
+
+  if (++memo->lookups == CONV_MEMO_PROBE
+    && memo->hits < CONV_MEMO_PROBE / 4)
+  {
+    MYLOG_QUERY(stmt, "Conversion memo is switched off for the column");
+    memo->disabled= TRUE;
+    return NULL;
+  }
+
+  for (i= 0; i < length; ++i)
+  {
+    hash= (hash ^ (uchar)value[i]) * 16777619UL;
+  }
+
+  return &memo->slot[hash % CONV_MEMO_SLOTS];
+}
+
+
+/* Does the actual conversion for sql_get_data() */
+static SQLRETURN
+get_data_converted(STMT *stmt, SQLSMALLINT fCType, uint column_number,
+                   SQLPOINTER rgbValue, SQLLEN cbValueMax, SQLLEN *pcbValue,
+                   char *value, ulong length, DESCREC *arrec)
 {
   MYSQL_FIELD *field= mysql_fetch_field_direct(stmt->result, column_number);
   SQLLEN    tmp;
@@ -441,8 +605,7 @@ sql_get_data(STMT *stmt, SQLSMALLINT fCType, uint column_number,
   }
   else
   {
-    if (!odbc_supported_conversion(get_sql_data_type(stmt, field, 0), fCType)
-     && !driver_supported_conversion(field,fCType))
+    if (!conversion_supported(stmt, field, column_number, fCType))
     {
       /*The state 07009 was incorrect
       (http://msdn.microsoft.com/en-us/library/ms715441%28v=VS.85%29.aspx)
@@ -915,6 +1078,93 @@ sql_get_data(STMT *stmt, SQLSMALLINT fCType, uint column_number,
 }
 
 
+/**
+  Retrieve the data from a field as a specified ODBC C type.
+
+  TODO arrec->indicator_ptr could be different than pcbValue
+  ideally, two separate pointers would be passed here
+
+  @param[in]  stmt        Handle of statement
+  @param[in]  fCType      ODBC C type to return data as
+  @param[in]  field       Field describing the type of the data
+  @param[out] rgbValue    Pointer to buffer for returning data
+  @param[in]  cbValueMax  Length of buffer
+  @param[out] pcbValue    Bytes used in the buffer, or SQL_NULL_DATA
+  @param[out] value       The field data to be converted and returned
+  @param[in]  length      Length of value
+  @param[in]  arrec       ARD record for this column (can be NULL)
+*/
+SQLRETURN SQL_API
+sql_get_data(STMT *stmt, SQLSMALLINT fCType, uint column_number,
+             SQLPOINTER rgbValue, SQLLEN cbValueMax, SQLLEN *pcbValue,
+             char *value, ulong length, DESCREC *arrec)
+{
+  CONV_MEMO_SLOT *slot= NULL;
+  SQLLEN ind;
+  SQLRETURN rc;
+
+  if (rgbValue != NULL)
+  {
+    slot= conv_memo_slot(stmt, fCType, column_number, value, length, arrec);
+  }
+
+  if (slot == NULL)
+  {
+    return get_data_converted(stmt, fCType, column_number, rgbValue,
+                              cbValueMax, pcbValue, value, length, arrec);
+  }
+
+  /* Buffer length matters only for strings */
+  if (slot->src_len == length && !memcmp(slot->src, value, length)
+    && (fCType != SQL_C_WCHAR || (SQLLEN)slot->dst_len <= cbValueMax))
+  {
+    ++stmt->conv_memo[column_number].hits;
+
+    memcpy(rgbValue, slot->dst, slot->dst_len);
+    if (pcbValue)
+    {
+      *pcbValue= slot->dst_ind;
+    }
+
+    if (fCType == SQL_C_WCHAR)
+    {
+      /* Leaving it as copy_wchar_result() does after complete read */
+      stmt->getdata.source= value + length;
+      stmt->getdata.dst_bytes= stmt->getdata.dst_offset= (ulong)slot->dst_ind;
+    }
+
+    return SQL_SUCCESS;
+  }
+
+  /* The value is not NULL, so indicator is not required by the caller */
+  rc= get_data_converted(stmt, fCType, column_number, rgbValue, cbValueMax,
+                         &ind, value, length, arrec);
+  if (pcbValue)
+  {
+    *pcbValue= ind;
+  }
+
+  if (rc == SQL_SUCCESS && ind >= 0)
+  {
+    /* Wide strings are memoized only if read completely */
+    ulong dst_len= fCType == SQL_C_WCHAR ? (ulong)ind + sizeof(SQLWCHAR) :
+                                           bind_length(fCType, 0);
+
+    if (dst_len <= CONV_MEMO_MAX_DST
+      && (fCType != SQL_C_WCHAR || (SQLLEN)dst_len <= cbValueMax))
+    {
+      memcpy(slot->src, value, length);
+      slot->src_len= length;
+      memcpy(slot->dst, rgbValue, dst_len);
+      slot->dst_len= dst_len;
+      slot->dst_ind= ind;
+    }
+  }
+
+  return rc;
+}
+
+
 /*
   @type    : myodbc3 internal
   @purpose : execute the query if it is only prepared. This is needed
@@ -1075,6 +1325,7 @@ MySQLDescribeCol(SQLHSTMT hstmt, SQLUSMALLINT column,
   {
     return SQL_ERROR; // The error info is already set inside desc_get_rec()
   }
+  fill_ird_rec(stmt, irrec);
 
   if (type)
     *type= irrec->concise_type;
@@ -1178,6 +1429,7 @@ MySQLColAttribute(SQLHSTMT hstmt, SQLUSMALLINT column,
   {
     return SQL_ERROR; // The error info is already set inside desc_get_rec()
   }
+  fill_ird_rec(stmt, irrec);
 
   /*
      Map to descriptor fields. This approach is only valid
@@ -1430,6 +1682,7 @@ SQLRETURN SQL_API SQLGetData(SQLHSTMT      StatementHandle,
       which will become -1 when decremented later. 
     */
     SQLSMALLINT sColNum= ColumnNumber; 
+    BOOL switch_locale;
 
     CHECK_HANDLE(stmt);
 
@@ -1490,7 +1743,7 @@ SQLRETURN SQL_API SQLGetData(SQLHSTMT      StatementHandle,
 
     assert(irrec);
 
-    if (!stmt->dbc->ds->dont_use_set_locale)
+    if ((switch_locale= locale_switch_needed(stmt)))
       setlocale(LC_NUMERIC, "C");
 
 
@@ -1520,7 +1773,7 @@ SQLRETURN SQL_API SQLGetData(SQLHSTMT      StatementHandle,
                           arrec);
     }
 
-    if (!stmt->dbc->ds->dont_use_set_locale)
+    if (switch_locale)
         setlocale(LC_NUMERIC,default_locale);
 
     return result;
@@ -1780,10 +2033,12 @@ fill_fetch_bookmark_buffers(STMT *stmt, ulong value, uint rownum)
 
   @param[in]  stmt        Handle of statement
   @param[in]  values      Row buffers from libmysql
+  @param[in]  lengths     Lengths of the values, or NULL to take them from
+                          the IRD
   @param[in]  rownum      Row number of current fetch block
 */
-static SQLRETURN
-fill_fetch_buffers(STMT *stmt, MYSQL_ROW values, uint rownum)
+SQLRETURN
+fill_fetch_buffers(STMT *stmt, MYSQL_ROW values, ulong *lengths, uint rownum)
 {
   SQLRETURN res= SQL_SUCCESS, tmp_res;
   int i;
@@ -1812,7 +2067,7 @@ fill_fetch_buffers(STMT *stmt, MYSQL_ROW values, uint rownum)
       }
 
       /* catalog functions with "fake" results won't have lengths */
-      length= irrec->row.datalen;
+      length= lengths ? lengths[i] : irrec->row.datalen;
 
       if (!length && *values)
       {
@@ -2091,7 +2346,7 @@ SQLRETURN SQL_API myodbc_single_fetch( SQLHSTMT             hstmt,
                               stmt->result->field_count);
     }
 
-    row_res= fill_fetch_buffers(stmt, values, cur_row);
+    row_res= fill_fetch_buffers(stmt, values, NULL, cur_row);
 
     /* For SQL_SUCCESS we need all rows to be SQL_SUCCESS */
     if (res != row_res)
@@ -2169,7 +2424,7 @@ exitSQLSingleFetch:
     if (SQL_SUCCEEDED(res)
       && stmt->rows_found_in_set < stmt->ard->array_size)
     {
-      if (disconnected)
+      if (disconnected || read_ahead_failed(stmt))
       {
         return SQL_ERROR;
       }
@@ -2184,6 +2439,207 @@ exitSQLSingleFetch:
 }
 
 
+/*
+  FETCH_THREADS: the conversions of the bound columns are verified before
+  the tasks are run. The tasks share the array and only read it then.
+*/
+static my_bool verified_ctype_fill(STMT *stmt)
+{
+  uint i;
+  DESCREC *arrec;
+  MYSQL_FIELD *field;
+  SQLSMALLINT fCType;
+
+  if (verified_ctype_alloc(stmt) == NULL)
+  {
+    return FALSE;
+  }
+
+  for (i= 0; i < (uint)myodbc_min(stmt->ird->count, stmt->ard->count); ++i)
+  {
+    arrec= desc_get_rec(stmt->ard, i, FALSE);
+
+    if (arrec == NULL || !ARD_IS_BOUND(arrec))
+    {
+      continue;
+    }
+
+    field= mysql_fetch_field_direct(stmt->result, i);
+    fCType= arrec->concise_type == SQL_C_DEFAULT ? unireg_to_c_datatype(field)
+                                                 : arrec->concise_type;
+
+    /* Sets the element if the conversion is supported */
+    conversion_supported(stmt, field, i, fCType);
+  }
+
+  return TRUE;
+}
+
+
+/* FETCH_THREADS: rows of the rowset filled by one task */
+typedef struct rowset_range
+{
+  STMT          stmt;     /* copy of the statement for its own diagnostics
+                             and SQLGetData position */
+  MYSQL_ROW     *rows;
+  ulong         *lengths; /* field_count lengths per row */
+  SQLRETURN     *row_res;
+  uint          first, count;
+} ROWSET_RANGE;
+
+
+static void fill_rowset_range(void *arg)
+{
+  ROWSET_RANGE *range= (ROWSET_RANGE *)arg;
+  uint field_count= range->stmt.result->field_count, i;
+
+  for (i= range->first; i < range->first + range->count; ++i)
+  {
+    range->row_res[i]= fill_fetch_buffers(&range->stmt, range->rows[i],
+                                          range->lengths + i * field_count, i);
+  }
+}
+
+
+/**
+  FETCH_THREADS: fills the rowset on the worker pool. The rows have to be
+  in memory already. They are collected by the calling thread and then
+  converted in ranges in parallel. Diagnostics of the ranges are taken in
+  the row order, so the statement ends up with the same diagnostic as if
+  the rows were filled one by one.
+
+  @param[in]  stmt           The statement
+  @param[in]  cur_row        First row of the rowset
+  @param[in]  rows_to_fetch  Number of rows wanted
+  @param[out] rows_fetched   Number of rows filled
+  @param[out] save_position  Position of the first row in the result
+
+  @return Results of the rows to be freed by the caller, or NULL if the
+          rowset has to be filled row by row
+*/
+static SQLRETURN *
+fill_rowset_parallel(STMT *stmt, long cur_row, SQLULEN rows_to_fetch,
+                     SQLULEN *rows_fetched, MYSQL_ROW_OFFSET *save_position)
+{
+  uint field_count= stmt->result->field_count, threads, ranges, per_range, i;
+  SQLRETURN *row_res;
+  MYSQL_ROW *rows, values;
+  ulong *lengths;
+  ROWSET_RANGE *range;
+  WORKER_TASK *tasks;
+
+  if (stmt->dbc->ds->fetch_threads == 0
+    || rows_to_fetch < PARALLEL_FETCH_MIN_ROWS
+    || ssps_used(stmt) || stmt->fix_fields || scroller_exists(stmt)
+    || stmt->out_params_state != OPS_UNKNOWN
+    || stmt->stmt_options.bookmarks == SQL_UB_VARIABLE
+    || (if_forward_cache(stmt) && !stmt->result_array)
+    || stmt->dbc->ds->conversion_memo || field_count == 0
+    || !verified_ctype_fill(stmt)
+    || (threads= worker_pool_start(stmt->dbc->ds->fetch_threads)) == 0)
+  {
+    return NULL;
+  }
+
+  ranges= threads + 1;
+  per_range= (uint)((rows_to_fetch + ranges - 1) / ranges);
+
+  if (!(row_res= (SQLRETURN *)myodbc_malloc(rows_to_fetch * sizeof(SQLRETURN),
+                                            MYF(0))))
+  {
+    return NULL;
+  }
+
+  if (!(range= (ROWSET_RANGE *)myodbc_malloc(ranges * (sizeof(ROWSET_RANGE)
+                          + sizeof(WORKER_TASK)) + rows_to_fetch *
+                          (sizeof(MYSQL_ROW) + sizeof(ulong) * field_count),
+                          MYF(0))))
+  {
+    x_free(row_res);
+    return NULL;
+  }
+
+  tasks=   (WORKER_TASK *)(range + ranges);
+  rows=    (MYSQL_ROW *)(tasks + ranges);
+  lengths= (ulong *)(rows + rows_to_fetch);
+
+  /* Fetching from the result is not thread safe, it is done here */
+  for (i= 0; i < rows_to_fetch; ++i)
+  {
+    if (stmt->result_array)
+    {
+      values= stmt->result_array + (cur_row + i) * field_count;
+
+      if (stmt->lengths)
+      {
+        memcpy(lengths + i * field_count,
+               stmt->lengths + (cur_row + i) * field_count,
+               sizeof(ulong) * field_count);
+      }
+      else
+      {
+        memset(lengths + i * field_count, 0, sizeof(ulong) * field_count);
+      }
+    }
+    else
+    {
+      if (i == 0)
+      {
+        *save_position= row_tell(stmt);
+      }
+      if (!(values= fetch_row(stmt)))
+      {
+        break;
+      }
+      memcpy(lengths + i * field_count, fetch_lengths(stmt),
+             sizeof(ulong) * field_count);
+    }
+    rows[i]= values;
+  }
+  *rows_fetched= i;
+
+  if (i == 0)
+  {
+    x_free(range);
+    return row_res;
+  }
+
+  for (ranges= 0; ranges * per_range < *rows_fetched; ++ranges)
+  {
+    range[ranges].stmt=    *stmt;
+    range[ranges].rows=    rows;
+    range[ranges].lengths= lengths;
+    range[ranges].row_res= row_res;
+    range[ranges].first=   ranges * per_range;
+    range[ranges].count=   (uint)myodbc_min(per_range,
+                                            *rows_fetched - ranges * per_range);
+    range[ranges].stmt.error.sqlstate[0]= '\0';
+
+    tasks[ranges].func= fill_rowset_range;
+    tasks[ranges].arg=  &range[ranges];
+  }
+
+  worker_pool_run(tasks, ranges);
+
+  for (i= 0; i < ranges; ++i)
+  {
+    if (range[i].stmt.error.sqlstate[0])
+    {
+      stmt->error= range[i].stmt.error;
+    }
+  }
+
+  /* Leaving the statement as filling row by row would */
+  stmt->current_values= rows[stmt->result_array ? 0 : *rows_fetched - 1];
+  fill_ird_data_lengths(stmt->ird, lengths + (*rows_fetched - 1) * field_count,
+                        field_count);
+  reset_getdata_position(stmt);
+
+  x_free(range);
+  return row_res;
+}
+
+
 /*
   @type    : myodbc3 internal
   @purpose : fetches the specified rowset of data from the result set and
@@ -2207,6 +2663,7 @@ SQLRETURN SQL_API my_SQLExtendedFetch( SQLHSTMT             hstmt,
     MYSQL_ROW         values= 0;
     MYSQL_ROW_OFFSET  save_position= 0;
     SQLULEN           dummy_pcrow;
+    SQLRETURN         *row_results;
     BOOL              disconnected= FALSE;
     long              brow= 0;
 
@@ -2389,95 +2846,106 @@ SQLRETURN SQL_API my_SQLExtendedFetch( SQLHSTMT             hstmt,
     }
 
     res= SQL_SUCCESS;
+    row_results= fill_rowset_parallel(stmt, cur_row, rows_to_fetch,
+                                      &rows_to_fetch, &save_position);
+
     for (i= 0 ; i < rows_to_fetch ; ++i)
     {
-      if ( stmt->result_array )
+      if (row_results != NULL)
       {
-        values= stmt->result_array + cur_row*stmt->result->field_count;
-        if ( i == 0 )
-        {
-          stmt->current_values= values;
-        }
+        /* Filled already by fill_rowset_parallel() */
+        row_res= row_results[i];
       }
       else
       {
-        /* This code will ensure that values is always set */
-        if ( i == 0 )
+        if ( stmt->result_array )
         {
-            save_position= row_tell(stmt);
+          values= stmt->result_array + cur_row*stmt->result->field_count;
+          if ( i == 0 )
+          {
+            stmt->current_values= values;
+          }
         }
-        /* - Actual fetching happens here - */
-        if ( stmt->out_params_state == OPS_UNKNOWN
-          && !(values= fetch_row(stmt)) )
+        else
         {
-          if (scroller_exists(stmt))
+          /* This code will ensure that values is always set */
+          if ( i == 0 )
+          {
+              save_position= row_tell(stmt);
+          }
+          /* - Actual fetching happens here - */
+          if ( stmt->out_params_state == OPS_UNKNOWN
+            && !(values= fetch_row(stmt)) )
           {
-            scroller_move(stmt);
+            if (scroller_exists(stmt))
+            {
+              scroller_move(stmt);
 
-            row_res= scroller_prefetch(stmt);
+              row_res= scroller_prefetch(stmt);
 
-            if (row_res != SQL_SUCCESS)
-            {
-              break;
-            }
+              if (row_res != SQL_SUCCESS)
+              {
+                break;
+              }
 
-            if ( !(values= fetch_row(stmt)) )
+              if ( !(values= fetch_row(stmt)) )
+              {
+                break;
+              }
+
+              /* Not sure that is right, but see it better than nothing */
+              save_position= row_tell(stmt);
+            }
+            else
             {
               break;
             }
+          }
 
-            /* Not sure that is right, but see it better than nothing */
-            save_position= row_tell(stmt);
+          if (stmt->out_params_state != OPS_UNKNOWN)
+          {
+            values= stmt->array;
           }
-          else
+
+          if ( stmt->fix_fields )
           {
-            break;
+              values= (*stmt->fix_fields)(stmt,values);
           }
-        }
 
-        if (stmt->out_params_state != OPS_UNKNOWN)
-        {
-          values= stmt->array;
+          stmt->current_values= values;
         }
 
-        if ( stmt->fix_fields )
+        if (!stmt->fix_fields)
         {
-            values= (*stmt->fix_fields)(stmt,values);
+          /* lengths contains lengths for all rows. Alternate use could be
+             filling ird buffers in the (fix_fields) function. In this case
+             lengths could contain just one array with rules for lengths
+             calculating(it can work out in many cases like in catalog functions
+             there some fields from results of auxiliary query are simply mixed
+             somehow and constant fields added ).
+             Another approach could be using of "array" and "order" arrays
+             and special fix_fields callback, that will fix array and set
+             lengths in ird*/
+          if (stmt->lengths)
+          {
+            fill_ird_data_lengths(stmt->ird, stmt->lengths + cur_row*stmt->result->field_count,
+                                  stmt->result->field_count);
+          }
+          else
+          {
+            fill_ird_data_lengths(stmt->ird, fetch_lengths(stmt),
+                                  stmt->result->field_count);
+          }
         }
 
-        stmt->current_values= values;
-      }
-
-      if (!stmt->fix_fields)
-      {
-        /* lengths contains lengths for all rows. Alternate use could be
-           filling ird buffers in the (fix_fields) function. In this case
-           lengths could contain just one array with rules for lengths
-           calculating(it can work out in many cases like in catalog functions
-           there some fields from results of auxiliary query are simply mixed
-           somehow and constant fields added ).
-           Another approach could be using of "array" and "order" arrays
-           and special fix_fields callback, that will fix array and set
-           lengths in ird*/
-        if (stmt->lengths)
-        {
-          fill_ird_data_lengths(stmt->ird, stmt->lengths + cur_row*stmt->result->field_count,
-                                stmt->result->field_count);
-        }
-        else
+        if (fFetchType == SQL_FETCH_BOOKMARK && 
+             stmt->stmt_options.bookmarks == SQL_UB_VARIABLE)
         {
-          fill_ird_data_lengths(stmt->ird, fetch_lengths(stmt),
-                                stmt->result->field_count);
-        }
+          row_book= fill_fetch_bookmark_buffers(stmt, irow + i + 1, i);
+        }  
+        row_res= fill_fetch_buffers(stmt, values, NULL, i);
       }
 
-      if (fFetchType == SQL_FETCH_BOOKMARK && 
-           stmt->stmt_options.bookmarks == SQL_UB_VARIABLE)
-      {
-        row_book= fill_fetch_bookmark_buffers(stmt, irow + i + 1, i);
-      }  
-      row_res= fill_fetch_buffers(stmt, values, i);
-
       /* For SQL_SUCCESS we need all rows to be SQL_SUCCESS */
       if (res != row_res || res != row_book)
       {
@@ -2516,9 +2984,13 @@ SQLRETURN SQL_API my_SQLExtendedFetch( SQLHSTMT             hstmt,
       ++cur_row;
     }   /* fetching cycle end*/
 
+    x_free(row_results);
+
     stmt->rows_found_in_set= i;
     *pcrow= i;
 
+    FLIGHT_RECORD(stmt->dbc, stmt, FE_FETCH, res, i);
+
     disconnected= is_connection_lost(mysql_errno(&stmt->dbc->mysql))
       && handle_connection_error(stmt);
 
@@ -2559,7 +3031,7 @@ SQLRETURN SQL_API my_SQLExtendedFetch( SQLHSTMT             hstmt,
     if (SQL_SUCCEEDED(res)
       && stmt->rows_found_in_set < stmt->ard->array_size)
     {
-      if (disconnected)
+      if (disconnected || read_ahead_failed(stmt))
       {
         return SQL_ERROR;
       }
@@ -2662,3 +3134,305 @@ SQLRETURN SQL_API SQLFetch(SQLHSTMT StatementHandle)
                                stmt->ird->rows_processed_ptr, stmt->ird->array_status_ptr,
                                0);
 }
+
+
+/*
+  SQL_ATTR_MYODBC_EXPORT: the rest of the current result set is written to
+  a file as CSV (RFC 4180) with a header line of column names. A path
+  starting with '|' is run as a command, which gets the CSV on its standard
+  input. Text is written in the connection character set, binary values as
+  hex and NULL as an empty field, unlike the empty string, which is quoted.
+  The cursor is closed after the export.
+*/
+#define EXPORT_BUFFER_SIZE  (1024 * 1024)
+#define EXPORT_HEX_CHUNK    4096
+
+#ifdef _WIN32
+# define popen  _popen
+# define pclose _pclose
+#endif
+
+static my_bool export_is_binary(MYSQL_FIELD *field)
+{
+  if (field->charsetnr != BINARY_CHARSET_NUMBER)
+  {
+    return FALSE;
+  }
+
+  switch (field->type)
+  {
+    case MYSQL_TYPE_BIT:
+    case MYSQL_TYPE_VARCHAR:
+    case MYSQL_TYPE_VAR_STRING:
+    case MYSQL_TYPE_STRING:
+    case MYSQL_TYPE_TINY_BLOB:
+    case MYSQL_TYPE_MEDIUM_BLOB:
+    case MYSQL_TYPE_LONG_BLOB:
+    case MYSQL_TYPE_BLOB:
+    case MYSQL_TYPE_GEOMETRY:
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+
+static void export_text(FILE *out, const char *value, ulong length)
+{
+  const char *end= value + length, *quote;
+  size_t plain= myodbc_kernels.plain_span(value, length);
+  my_bool needs_quotes= length == 0;
+
+  /* The plain span stops at more than the CSV special characters */
+  if (plain < length)
+  {
+    const char *pos;
+
+    for (pos= value + plain; pos < end && !needs_quotes; ++pos)
+    {
+      needs_quotes= *pos == ',' || *pos == '"' || *pos == '\r' || *pos == '\n';
+    }
+  }
+  else if (length)
+  {
+    needs_quotes= memchr(value, ',', length) != NULL;
+  }
+
+  if (!needs_quotes)
+  {
+    fwrite(value, 1, length, out);
+    return;
+  }
+
+  putc('"', out);
+  while ((quote= memchr(value, '"', end - value)))
+  {
+    fwrite(value, 1, quote - value + 1, out);
+    putc('"', out);
+    value= quote + 1;
+  }
+  fwrite(value, 1, end - value, out);
+  putc('"', out);
+}
+
+
+static void export_binary(FILE *out, const char *value, ulong length)
+{
+  char hex[EXPORT_HEX_CHUNK * 2];
+
+  while (length)
+  {
+    ulong chunk= myodbc_min(length, EXPORT_HEX_CHUNK);
+
+    fwrite(hex, 1, myodbc_kernels.hex_encode(hex, value, chunk) - hex, out);
+    value+= chunk;
+    length-= chunk;
+  }
+}
+
+
+/**
+  Writes the rest of the current result set to a file or a command.
+
+  @param[in] stmt      Statement with the result set
+  @param[in] path      File name, or '|' and a command
+  @param[in] path_len  Length of the path, or SQL_NTS
+
+  @return Standard ODBC result code
+*/
+SQLRETURN stmt_export(STMT *stmt, SQLCHAR *path, SQLINTEGER path_len)
+{
+  SQLRETURN rc= SQL_SUCCESS;
+  MYSQL_ROW values;
+  MYSQL_FIELD *fields;
+  unsigned long *lengths;
+  my_ulonglong row, row_count;
+  my_bool to_pipe;
+  char *name, buffer[64];
+  uint i, columns;
+  int failed;
+  FILE *out;
+
+  if (!path)
+  {
+    return set_error(stmt, MYERR_S1009, NULL, 0);
+  }
+
+  if (!stmt->result)
+  {
+    return set_error(stmt, MYERR_24000, "No result set to export", 0);
+  }
+
+  if (path_len == SQL_NTS)
+  {
+    path_len= (SQLINTEGER)strlen((char *)path);
+  }
+
+  if (!(name= myodbc_malloc(path_len + 1, MYF(0))))
+  {
+    return set_error(stmt, MYERR_S1001, NULL, 4001);
+  }
+  memcpy(name, path, path_len);
+  name[path_len]= '\0';
+
+  if ((to_pipe= name[0] == '|'))
+  {
+    out= popen(name + 1, "w");
+  }
+  else
+  {
+    out= fopen(name, "wb");
+  }
+
+  if (!out)
+  {
+    x_free(name);
+    return set_stmt_error(stmt, "HY000", "Could not open the export target",
+                          errno);
+  }
+
+  setvbuf(out, NULL, _IOFBF, EXPORT_BUFFER_SIZE);
+
+  /*
+    The connection lock is not held, as in my_SQLExtendedFetch(). The
+    prefetch of the next chunk and the READ_AHEAD thread take it.
+  */
+  fields= stmt->result->fields;
+  columns= stmt->result->field_count;
+
+  for (i= 0; i < columns; ++i)
+  {
+    if (i)
+    {
+      putc(',', out);
+    }
+    export_text(out, fields[i].name, (ulong)strlen(fields[i].name));
+  }
+  fputs("\r\n", out);
+
+  if (!stmt->dbc->ds->dont_use_set_locale)
+  {
+    setlocale(LC_NUMERIC, "C");
+  }
+
+  /*
+    Catalog results and other fake result sets have their rows in
+    result_array, there is nothing to fetch from the client library.
+  */
+  row= stmt->current_row < 0 ? 0 :
+       (my_ulonglong)(stmt->current_row + stmt->rows_found_in_set);
+  row_count= stmt->result_array ? num_rows(stmt) : 0;
+
+  for (;;)
+  {
+    if (stmt->result_array)
+    {
+      if (row >= row_count)
+      {
+        break;
+      }
+      values= stmt->result_array + row * columns;
+      lengths= stmt->lengths ? stmt->lengths + row * columns : NULL;
+      ++row;
+    }
+    else
+    {
+      if (!(values= fetch_row(stmt)))
+      {
+        if (!scroller_exists(stmt))
+        {
+          break;
+        }
+
+        scroller_move(stmt);
+        if (scroller_prefetch(stmt) != SQL_SUCCESS ||
+            !(values= fetch_row(stmt)))
+        {
+          break;
+        }
+      }
+
+      lengths= fetch_lengths(stmt);
+    }
+
+    if (stmt->fix_fields && !stmt->result_array)
+    {
+      values= (*stmt->fix_fields)(stmt, values);
+      /* Catalog results are rearranged, their lengths are not */
+      if (!ssps_used(stmt))
+      {
+        lengths= NULL;
+      }
+    }
+
+    for (i= 0; i < columns; ++i)
+    {
+      char *value= values[i];
+      ulong length;
+
+      if (i)
+      {
+        putc(',', out);
+      }
+
+      if (ssps_used(stmt))
+      {
+        if (is_null(stmt, i, value))
+        {
+          continue;
+        }
+        length= lengths[i];
+        value= get_string(stmt, i, value, &length, buffer);
+      }
+      else if (!value)
+      {
+        continue;
+      }
+      else
+      {
+        length= lengths ? lengths[i] : (ulong)strlen(value);
+      }
+
+      if (export_is_binary(&fields[i]) && length)
+      {
+        export_binary(out, value, length);
+      }
+      else
+      {
+        export_text(out, value, length);
+      }
+    }
+
+    fputs("\r\n", out);
+  }
+
+  if (!stmt->dbc->ds->dont_use_set_locale)
+  {
+    setlocale(LC_NUMERIC, default_locale);
+  }
+
+  if (!stmt->result_array && mysql_errno(&stmt->dbc->mysql))
+  {
+    rc= set_error(stmt, MYERR_S1000, mysql_error(&stmt->dbc->mysql),
+                  mysql_errno(&stmt->dbc->mysql));
+  }
+
+  failed= ferror(out);
+  failed|= to_pipe ? pclose(out) : fclose(out);
+
+  if (failed && SQL_SUCCEEDED(rc))
+  {
+    rc= set_stmt_error(stmt, "HY000", "Could not write the export target",
+                       errno);
+  }
+
+  x_free(name);
+
+  /* The rows are gone, the cursor is closed like by SQLCloseCursor() */
+  if (SQL_SUCCEEDED(rc))
+  {
+    my_SQLFreeStmt((SQLHSTMT)stmt, SQL_CLOSE);
+  }
+
+  return rc;
+}
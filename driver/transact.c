@@ -44,7 +44,8 @@ static SQLRETURN my_transact(SQLHDBC hdbc, SQLSMALLINT CompletionType)
   const char *query;
   uint	length;
 
-  if (dbc && dbc->ds && !dbc->ds->disable_transactions)
+  /* Nothing could have been done in a transaction on a deferred connection */
+  if (dbc && dbc->ds && !dbc->ds->disable_transactions && !dbc->need_to_connect)
   {
     switch(CompletionType) {
     case SQL_COMMIT:
@@ -70,6 +71,7 @@ static SQLRETURN my_transact(SQLHDBC hdbc, SQLSMALLINT CompletionType)
 
     myodbc_mutex_lock(&dbc->lock);
     if (check_if_server_is_alive(dbc) ||
+        full_result_metadata(dbc) ||
 	mysql_real_query(&dbc->mysql,query,length))
     {
       result= set_conn_error(hdbc,MYERR_S1000,
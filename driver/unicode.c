@@ -447,6 +447,7 @@ SQLGetConnectAttrWImpl(SQLHDBC hdbc, SQLINTEGER attribute, SQLPOINTER value,
 {
   DBC *dbc= (DBC *)hdbc;
   SQLCHAR *char_value= NULL;
+  my_bool free_char_value= FALSE;
 
   SQLRETURN rc= 0;
   
@@ -455,7 +456,8 @@ SQLGetConnectAttrWImpl(SQLHDBC hdbc, SQLINTEGER attribute, SQLPOINTER value,
     the valid output buffer to prevent crashes
   */
   if (value)
-    rc= MySQLGetConnectAttr(hdbc, attribute, &char_value, value);
+    rc= MySQLGetConnectAttr(hdbc, attribute, &char_value, value,
+                            &free_char_value);
 
   if (char_value)
   {
@@ -501,6 +503,9 @@ SQLGetConnectAttrWImpl(SQLHDBC hdbc, SQLINTEGER attribute, SQLPOINTER value,
     }
 
     x_free(wvalue);
+
+    if (free_char_value)
+      x_free(char_value);
   }
 
   return rc;
@@ -996,6 +1001,45 @@ SQLSetConnectAttrW(SQLHDBC hdbc, SQLINTEGER attribute,
 }
 
 
+#ifdef MYODBC_DRIVER_AWARE_POOLING
+SQLRETURN SQL_API
+SQLSetConnectAttrForDbcInfoW(SQLHDBC_INFO_TOKEN token, SQLINTEGER attribute,
+                             SQLPOINTER value, SQLINTEGER value_len)
+{
+  CHECK_HANDLE(token);
+
+  return MySQLSetConnectAttrForDbcInfo(token, attribute, value, value_len);
+}
+
+
+SQLRETURN SQL_API
+SQLSetConnectInfoW(SQLHDBC_INFO_TOKEN token,
+                   SQLWCHAR *dsn, SQLSMALLINT dsn_len,
+                   SQLWCHAR *user, SQLSMALLINT user_len,
+                   SQLWCHAR *auth, SQLSMALLINT auth_len)
+{
+  CHECK_HANDLE(token);
+
+  ((DBC_INFO_TOKEN *)token)->unicode= TRUE;
+
+  return MySQLSetConnectInfo(token, dsn, dsn_len, user, user_len,
+                             auth, auth_len);
+}
+
+
+SQLRETURN SQL_API
+SQLSetDriverConnectInfoW(SQLHDBC_INFO_TOKEN token, SQLWCHAR *in,
+                         SQLSMALLINT in_len)
+{
+  CHECK_HANDLE(token);
+
+  ((DBC_INFO_TOKEN *)token)->unicode= TRUE;
+
+  return MySQLSetDriverConnectInfo(token, in, in_len);
+}
+#endif
+
+
 SQLRETURN SQL_API
 SQLSetConnectAttrWImpl(SQLHDBC hdbc, SQLINTEGER attribute,
                        SQLPOINTER value, SQLINTEGER value_len)
@@ -1088,7 +1132,26 @@ SQLSetStmtAttrW(SQLHSTMT hstmt, SQLINTEGER attribute,
 {
   CHECK_HANDLE(hstmt);
 
-  /* Nothing special to do, since we don't have any string stmt attribs */
+  /* The export path is the only string stmt attribute */
+  if (attribute == SQL_ATTR_MYODBC_EXPORT && value)
+  {
+    SQLRETURN rc;
+#ifdef _WIN32
+    SQLINTEGER len= value_len == SQL_NTS ? SQL_NTS :
+                                           value_len / sizeof(SQLWCHAR);
+#else
+    SQLINTEGER len= value_len;
+#endif
+    uint errors= 0;
+    SQLCHAR *path= sqlwchar_as_sqlchar(default_charset_info, value, &len,
+                                       &errors);
+
+    rc= MySQLSetStmtAttr(hstmt, attribute, path, len);
+    x_free(path);
+
+    return rc;
+  }
+
   return MySQLSetStmtAttr(hstmt, attribute, value, value_len);
 }
 
@@ -30,6 +30,9 @@
 #include "driver.h"
 #include "errmsg.h"
 #include <ctype.h>
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
 
 
 #define DATETIME_DIGITS 14
@@ -89,6 +92,7 @@ SQLRETURN odbc_stmt(DBC *dbc, const char *query,
   }
 
   if ( check_if_server_is_alive(dbc) ||
+       full_result_metadata(dbc) ||
        mysql_real_query(&dbc->mysql, query, query_length) )
   {
     result= set_conn_error(dbc,MYERR_S1000,mysql_error(&dbc->mysql),
@@ -103,6 +107,34 @@ SQLRETURN odbc_stmt(DBC *dbc, const char *query,
 }
 
 
+/**
+  OPTIONAL_METADATA: switch the session back to sending result set metadata.
+  Only re-executions of statements with cached field definitions run with
+  resultset_metadata=NONE, everything else needs the metadata.
+
+  @param[in] dbc  The database connection
+
+  @return 0 on success, non-zero if the server returned an error
+*/
+int full_result_metadata(DBC *dbc)
+{
+  static const char query[]= "SET resultset_metadata=FULL";
+
+  if (!dbc->metadata_none)
+  {
+    return 0;
+  }
+
+  if (mysql_real_query(&dbc->mysql, query, sizeof(query) - 1))
+  {
+    return 1;
+  }
+
+  dbc->metadata_none= FALSE;
+  return 0;
+}
+
+
 /**
   Link a list of fields to the current statement result.
 
@@ -161,6 +193,11 @@ void fix_row_lengths(STMT *stmt, const long* fix_rules, uint row, uint field_cou
 /**
   Figure out the ODBC result types for each column in the result set.
 
+  Only the MYSQL_FIELD of each IRD record is attached here, which is all
+  the fetch path needs. The remaining attributes are derived on first
+  access by fill_ird_rec(), so that wide results that are only fetched
+  don't pay for describing every column.
+
   @param[in] stmt The statement with result types to be fixed.
 */
 void fix_result_types(STMT *stmt)
@@ -168,8 +205,6 @@ void fix_result_types(STMT *stmt)
   uint i;
   MYSQL_RES *result= stmt->result;
   DESCREC *irrec;
-  MYSQL_FIELD *field;
-  int capint32= stmt->dbc->ds->limit_column_size ? 1 : 0;
 
   stmt->state= ST_EXECUTED;  /* Mark set found */
 
@@ -177,176 +212,208 @@ void fix_result_types(STMT *stmt)
   for (i= 0; i < field_count(stmt); ++i)
   {
     irrec= desc_get_rec(stmt->ird, i, TRUE);
-    /* TODO function for this */
-    field= result->fields + i;
-
-    irrec->row.field= field;
-    irrec->type= get_sql_data_type(stmt, field, NULL);
-    irrec->concise_type= get_sql_data_type(stmt, field,
-                                           (char *)irrec->row.type_name);
-    switch (irrec->concise_type)
-    {
-    case SQL_DATE:
-    case SQL_TYPE_DATE:
-    case SQL_TIME:
-    case SQL_TYPE_TIME:
-    case SQL_TIMESTAMP:
-    case SQL_TYPE_TIMESTAMP:
-      irrec->type= SQL_DATETIME;
-      break;
-    default:
-      irrec->type= irrec->concise_type;
-      break;
-    }
-    irrec->datetime_interval_code=
-      get_dticode_from_concise_type(irrec->concise_type);
-    irrec->type_name= (SQLCHAR *) irrec->row.type_name;
-    irrec->length= get_column_size(stmt, field);
-    /* prevent overflowing of result when ADO multiplies the length
-       by sizeof(SQLWCHAR) */
-    if (capint32 && irrec->length == INT_MAX32 &&
-        irrec->concise_type == SQL_WLONGVARCHAR)
-      irrec->length /= sizeof(SQL_WCHAR);
-    irrec->octet_length= get_transfer_octet_length(stmt, field);
-    irrec->display_size= get_display_size(stmt, field);
-    /* According ODBC specs(http://msdn.microsoft.com/en-us/library/ms713558%28v=VS.85%29.aspx) 
-      "SQL_DESC_OCTET_LENGTH ... For variable-length character or binary types,
-      this is the maximum length in bytes. This value does not include the null
-      terminator" Thus there is no need to add 1 to octet_length for char types */
-    irrec->precision= 0;
-    /* Set precision for all non-char/blob types */
-    switch (irrec->type)
-    {
-    case SQL_BINARY:
-    case SQL_BIT:
-    case SQL_CHAR:
-    case SQL_WCHAR:
-    case SQL_VARBINARY:
-    case SQL_VARCHAR:
-    case SQL_WVARCHAR:
-    case SQL_LONGVARBINARY:
-    case SQL_LONGVARCHAR:
-    case SQL_WLONGVARCHAR:
-      break;
-    default:
-      irrec->precision= (SQLSMALLINT) irrec->length;
-      break;
-    }
-    irrec->scale= myodbc_max(0, get_decimal_digits(stmt, field));
-    if ((field->flags & NOT_NULL_FLAG) &&
-        !(field->type == MYSQL_TYPE_TIMESTAMP) &&
-        !(field->flags & AUTO_INCREMENT_FLAG))
-      irrec->nullable= SQL_NO_NULLS;
-    else
-      irrec->nullable= SQL_NULLABLE;
-    irrec->table_name= (SQLCHAR *)field->table;
-    irrec->name= (SQLCHAR *)field->name;
-    irrec->label= (SQLCHAR *)field->name;
-    if (field->flags & AUTO_INCREMENT_FLAG)
-      irrec->auto_unique_value= SQL_TRUE;
-    else
-      irrec->auto_unique_value= SQL_FALSE;
-    /* We need support from server, when aliasing is there */
-    irrec->base_column_name= (SQLCHAR *)field->org_name;
-    irrec->base_table_name= (SQLCHAR *)field->org_table;
-    if (field->flags & BINARY_FLAG) /* TODO this doesn't cut it anymore */
-      irrec->case_sensitive= SQL_TRUE;
-    else
-      irrec->case_sensitive= SQL_FALSE;
+    irrec->row.field= result->fields + i;
+    irrec->row.pending= TRUE;
+  }
 
-    if (field->db && *field->db)
-    {
-        irrec->catalog_name= (SQLCHAR *)field->db;
-    }
-    else
-    {
-      irrec->catalog_name= (SQLCHAR *)(stmt->dbc->database ? stmt->dbc->database : "");
-    }
+  stmt->ird->count= result->field_count;
+}
 
-    irrec->fixed_prec_scale= SQL_FALSE;
-    switch (field->type)
-    {
-    case MYSQL_TYPE_LONG_BLOB:
-    case MYSQL_TYPE_TINY_BLOB:
-    case MYSQL_TYPE_MEDIUM_BLOB:
-    case MYSQL_TYPE_BLOB:
-    case MYSQL_TYPE_VAR_STRING:
-    case MYSQL_TYPE_STRING:
-      if (field->charsetnr == BINARY_CHARSET_NUMBER)
-      {
-        irrec->literal_prefix= (SQLCHAR *) "0x";
-        irrec->literal_suffix= (SQLCHAR *) "";
-        break;
-      }
-      /* FALLTHROUGH */
 
-    case MYSQL_TYPE_DATE:
-    case MYSQL_TYPE_DATETIME:
-    case MYSQL_TYPE_NEWDATE:
-    case MYSQL_TYPE_TIMESTAMP:
-    case MYSQL_TYPE_TIME:
-    case MYSQL_TYPE_YEAR:
-      irrec->literal_prefix= (SQLCHAR *) "'";
-      irrec->literal_suffix= (SQLCHAR *) "'";
-      break;
+/**
+  Compute the attributes of an IRD record from its MYSQL_FIELD, if that
+  hasn't been done since fix_result_types() attached the field.
 
-    default:
-      irrec->literal_prefix= (SQLCHAR *) "";
+  @param[in] stmt  The statement owning the IRD
+  @param[in] irrec The IRD record to fill
+*/
+void fill_ird_rec(STMT *stmt, DESCREC *irrec)
+{
+  MYSQL_FIELD *field= irrec->row.field;
+  int capint32= stmt->dbc->ds->limit_column_size ? 1 : 0;
+
+  if (!irrec->row.pending || !field)
+    return;
+
+  irrec->row.pending= FALSE;
+
+  irrec->type= get_sql_data_type(stmt, field, NULL);
+  irrec->concise_type= get_sql_data_type(stmt, field,
+                                         (char *)irrec->row.type_name);
+  switch (irrec->concise_type)
+  {
+  case SQL_DATE:
+  case SQL_TYPE_DATE:
+  case SQL_TIME:
+  case SQL_TYPE_TIME:
+  case SQL_TIMESTAMP:
+  case SQL_TYPE_TIMESTAMP:
+    irrec->type= SQL_DATETIME;
+    break;
+  default:
+    irrec->type= irrec->concise_type;
+    break;
+  }
+  irrec->datetime_interval_code=
+    get_dticode_from_concise_type(irrec->concise_type);
+  irrec->type_name= (SQLCHAR *) irrec->row.type_name;
+  irrec->length= get_column_size(stmt, field);
+  /* prevent overflowing of result when ADO multiplies the length
+     by sizeof(SQLWCHAR) */
+  if (capint32 && irrec->length == INT_MAX32 &&
+      irrec->concise_type == SQL_WLONGVARCHAR)
+    irrec->length /= sizeof(SQL_WCHAR);
+  irrec->octet_length= get_transfer_octet_length(stmt, field);
+  irrec->display_size= get_display_size(stmt, field);
+  /* According ODBC specs(http://msdn.microsoft.com/en-us/library/ms713558%28v=VS.85%29.aspx) 
+    "SQL_DESC_OCTET_LENGTH ... For variable-length character or binary types,
+    this is the maximum length in bytes. This value does not include the null
+    terminator" Thus there is no need to add 1 to octet_length for char types */
+  irrec->precision= 0;
+  /* Set precision for all non-char/blob types */
+  switch (irrec->type)
+  {
+  case SQL_BINARY:
+  case SQL_BIT:
+  case SQL_CHAR:
+  case SQL_WCHAR:
+  case SQL_VARBINARY:
+  case SQL_VARCHAR:
+  case SQL_WVARCHAR:
+  case SQL_LONGVARBINARY:
+  case SQL_LONGVARCHAR:
+  case SQL_WLONGVARCHAR:
+    break;
+  default:
+    irrec->precision= (SQLSMALLINT) irrec->length;
+    break;
+  }
+  irrec->scale= myodbc_max(0, get_decimal_digits(stmt, field));
+  if ((field->flags & NOT_NULL_FLAG) &&
+      !(field->type == MYSQL_TYPE_TIMESTAMP) &&
+      !(field->flags & AUTO_INCREMENT_FLAG))
+    irrec->nullable= SQL_NO_NULLS;
+  else
+    irrec->nullable= SQL_NULLABLE;
+  irrec->table_name= (SQLCHAR *)field->table;
+  irrec->name= (SQLCHAR *)field->name;
+  irrec->label= (SQLCHAR *)field->name;
+  if (field->flags & AUTO_INCREMENT_FLAG)
+    irrec->auto_unique_value= SQL_TRUE;
+  else
+    irrec->auto_unique_value= SQL_FALSE;
+  /* We need support from server, when aliasing is there */
+  irrec->base_column_name= (SQLCHAR *)field->org_name;
+  irrec->base_table_name= (SQLCHAR *)field->org_table;
+  if (field->flags & BINARY_FLAG) /* TODO this doesn't cut it anymore */
+    irrec->case_sensitive= SQL_TRUE;
+  else
+    irrec->case_sensitive= SQL_FALSE;
+
+  if (field->db && *field->db)
+  {
+      irrec->catalog_name= (SQLCHAR *)field->db;
+  }
+  else
+  {
+    irrec->catalog_name= (SQLCHAR *)(stmt->dbc->database ? stmt->dbc->database : "");
+  }
+
+  irrec->fixed_prec_scale= SQL_FALSE;
+  switch (field->type)
+  {
+  case MYSQL_TYPE_LONG_BLOB:
+  case MYSQL_TYPE_TINY_BLOB:
+  case MYSQL_TYPE_MEDIUM_BLOB:
+  case MYSQL_TYPE_BLOB:
+  case MYSQL_TYPE_VAR_STRING:
+  case MYSQL_TYPE_STRING:
+    if (field->charsetnr == BINARY_CHARSET_NUMBER)
+    {
+      irrec->literal_prefix= (SQLCHAR *) "0x";
       irrec->literal_suffix= (SQLCHAR *) "";
-    }
-    switch (field->type) {
-    case MYSQL_TYPE_SHORT:
-    case MYSQL_TYPE_LONG:
-    case MYSQL_TYPE_LONGLONG:
-    case MYSQL_TYPE_INT24:
-    case MYSQL_TYPE_TINY:
-    case MYSQL_TYPE_DECIMAL:
-      irrec->num_prec_radix= 10;
       break;
+    }
+    /* FALLTHROUGH */
 
-    /* overwrite irrec->precision set above */
-    case MYSQL_TYPE_FLOAT:
-      irrec->num_prec_radix= 2;
-      irrec->precision= 23;
-      break;
+  case MYSQL_TYPE_DATE:
+  case MYSQL_TYPE_DATETIME:
+  case MYSQL_TYPE_NEWDATE:
+  case MYSQL_TYPE_TIMESTAMP:
+  case MYSQL_TYPE_TIME:
+  case MYSQL_TYPE_YEAR:
+    irrec->literal_prefix= (SQLCHAR *) "'";
+    irrec->literal_suffix= (SQLCHAR *) "'";
+    break;
 
-    case MYSQL_TYPE_DOUBLE:
-      irrec->num_prec_radix= 2;
-      irrec->precision= 53;
-      break;
+  default:
+    irrec->literal_prefix= (SQLCHAR *) "";
+    irrec->literal_suffix= (SQLCHAR *) "";
+  }
+  switch (field->type) {
+  case MYSQL_TYPE_SHORT:
+  case MYSQL_TYPE_LONG:
+  case MYSQL_TYPE_LONGLONG:
+  case MYSQL_TYPE_INT24:
+  case MYSQL_TYPE_TINY:
+  case MYSQL_TYPE_DECIMAL:
+    irrec->num_prec_radix= 10;
+    break;
+
+  /* overwrite irrec->precision set above */
+  case MYSQL_TYPE_FLOAT:
+    irrec->num_prec_radix= 2;
+    irrec->precision= 23;
+    break;
+
+  case MYSQL_TYPE_DOUBLE:
+    irrec->num_prec_radix= 2;
+    irrec->precision= 53;
+    break;
 
+  default:
+    irrec->num_prec_radix= 0;
+    break;
+  }
+  irrec->schema_name= (SQLCHAR *) "";
+  /*
+    We limit BLOB/TEXT types to SQL_PRED_CHAR due an oversight in ADO
+    causing problems with updatable cursors.
+  */
+  switch (irrec->concise_type)
+  {
+    case SQL_LONGVARBINARY:
+    case SQL_LONGVARCHAR:
+    case SQL_WLONGVARCHAR:
+      irrec->searchable= SQL_PRED_CHAR;
+      break;
     default:
-      irrec->num_prec_radix= 0;
+      irrec->searchable= SQL_SEARCHABLE;
       break;
-    }
-    irrec->schema_name= (SQLCHAR *) "";
-    /*
-      We limit BLOB/TEXT types to SQL_PRED_CHAR due an oversight in ADO
-      causing problems with updatable cursors.
-    */
-    switch (irrec->concise_type)
-    {
-      case SQL_LONGVARBINARY:
-      case SQL_LONGVARCHAR:
-      case SQL_WLONGVARCHAR:
-        irrec->searchable= SQL_PRED_CHAR;
-        break;
-      default:
-        irrec->searchable= SQL_SEARCHABLE;
-        break;
-    }
-    irrec->unnamed= SQL_NAMED;
-    if (field->flags & UNSIGNED_FLAG)
-      irrec->is_unsigned= SQL_TRUE;
-    else
-      irrec->is_unsigned= SQL_FALSE;
-    if (field->table && *field->table)
-      irrec->updatable= SQL_ATTR_READWRITE_UNKNOWN;
-    else
-      irrec->updatable= SQL_ATTR_READONLY;
   }
+  irrec->unnamed= SQL_NAMED;
+  if (field->flags & UNSIGNED_FLAG)
+    irrec->is_unsigned= SQL_TRUE;
+  else
+    irrec->is_unsigned= SQL_FALSE;
+  if (field->table && *field->table)
+    irrec->updatable= SQL_ATTR_READWRITE_UNKNOWN;
+  else
+    irrec->updatable= SQL_ATTR_READONLY;
+}
 
-  stmt->ird->count= result->field_count;
+
+/**
+  Compute the attributes of all pending IRD records.
+
+  @param[in] stmt  The statement owning the IRD
+*/
+void fill_ird_recs(STMT *stmt)
+{
+  int i;
+
+  for (i= 0; i < stmt->ird->count; ++i)
+    fill_ird_rec(stmt, desc_get_rec(stmt->ird, i, FALSE));
 }
 
 
@@ -494,6 +561,61 @@ copy_binary_result(STMT *stmt,
 }
 
 
+/*
+  Counts the length the source would have converted to to_cs (in bytes), or
+  to SQLWCHAR (in characters) if to_cs is NULL, without converting it. Runs
+  of ASCII are measured by the ascii_span kernel, other characters are only
+  decoded, unless the target is a multibyte character set.
+*/
+static ulong count_converted_bytes(CHARSET_INFO *from_cs, CHARSET_INFO *to_cs,
+                                   const char *src, const char *src_end)
+{
+  ulong count= 0;
+  my_bool ascii= my_charset_is_ascii_based(from_cs) &&
+                 (to_cs == NULL || my_charset_is_ascii_based(to_cs));
+
+  while (src < src_end)
+  {
+    my_wc_t wc;
+    uchar dummy[7]; /* Longer than any single character in our charsets. */
+    int cnvres;
+
+    if (ascii)
+    {
+      size_t span= myodbc_kernels.ascii_span(src, src_end - src);
+
+      src+= span;
+      count+= span;
+
+      if (src == src_end)
+        break;
+    }
+
+    cnvres= from_cs->cset->mb_wc(from_cs, &wc, (uchar *)src, (uchar *)src_end);
+    if (cnvres <= 0)
+    {
+      /* Converted as '?' */
+      cnvres= (cnvres < 0 && cnvres > MY_CS_TOOSMALL) ? abs(cnvres) : 1;
+      wc= '?';
+    }
+    src+= cnvres;
+
+    if (to_cs == NULL)
+      count+= (sizeof(SQLWCHAR) == 2 && wc > 0xFFFF) ? 2 : 1;
+    else if (to_cs->mbmaxlen == 1)
+      ++count;
+    else
+    {
+      int to_cnvres= to_cs->cset->wc_mb(to_cs, wc, dummy,
+                                        dummy + sizeof(dummy));
+      count+= to_cnvres > 0 ? to_cnvres : 1;
+    }
+  }
+
+  return count;
+}
+
+
 /*
   Copy a field to an ANSI result string.
 
@@ -516,7 +638,8 @@ copy_ansi_result(STMT *stmt,
   SQLRETURN rc= SQL_SUCCESS;
   char *src_end;
   SQLCHAR *result_end;
-  ulong used_bytes= 0, used_chars= 0, error_count= 0;
+  ulong used_bytes= 0, error_count= 0;
+  my_bool ascii;
 
   my_bool convert_binary= (field->charsetnr == BINARY_CHARSET_NUMBER ? 1 : 0) &&
                           (field->org_table_length == 0 ? 1 : 0) &&
@@ -563,6 +686,9 @@ copy_ansi_result(STMT *stmt,
     return rc;
   }
 
+  ascii= my_charset_is_ascii_based(from_cs) &&
+         my_charset_is_ascii_based(to_cs);
+
   result_end= result + result_bytes - 1;
   /*
     Handle when result_bytes is 1 -- we have room for the NUL termination,
@@ -582,41 +708,42 @@ copy_ansi_result(STMT *stmt,
 
   /* Initialize the source offset */
   if (!stmt->getdata.source)
+  {
     stmt->getdata.source= src;
+    stmt->getdata.dst_offset= 0;
+  }
   else
+  {
     src= stmt->getdata.source;
 
-  /* If we've already retrieved everything, return SQL_NO_DATA_FOUND */
-  if (stmt->getdata.dst_bytes != (ulong)~0L &&
-      stmt->getdata.dst_offset >= stmt->getdata.dst_bytes)
-    return SQL_NO_DATA_FOUND;
+    /* If we've already retrieved everything, return SQL_NO_DATA_FOUND */
+    if (src >= src_end && !stmt->getdata.latest_bytes)
+      return SQL_NO_DATA_FOUND;
+  }
 
   /*
     If we have leftover bytes from an earlier character conversion,
     copy as much as we can into place.
   */
-  if (stmt->getdata.latest_bytes)
+  if (stmt->getdata.latest_bytes && result)
   {
     int new_bytes= myodbc_min(stmt->getdata.latest_bytes -
                               stmt->getdata.latest_used,
                               result_end - result);
     memcpy(result, stmt->getdata.latest + stmt->getdata.latest_used, new_bytes);
-    if (new_bytes + stmt->getdata.latest_used == stmt->getdata.latest_bytes)
+    stmt->getdata.latest_used+= new_bytes;
+    if (stmt->getdata.latest_used == stmt->getdata.latest_bytes)
       stmt->getdata.latest_bytes= 0;
 
     result+= new_bytes;
-
-    if (result == result_end)
-    {
-      *result= '\0';
-      result= NULL;
-    }
-
     used_bytes+= new_bytes;
-    stmt->getdata.latest_used+= new_bytes;
   }
 
-  while (src < src_end)
+  /*
+    Every character is converted once - right into the result buffer. The
+    position is kept in stmt->getdata, so the next call continues from here.
+  */
+  while (result && result < result_end && src < src_end)
   {
     /* Find the conversion functions. */
     int (*mb_wc)(struct charset_info_st *, my_wc_t *, const uchar *,
@@ -624,10 +751,25 @@ copy_ansi_result(STMT *stmt,
     int (*wc_mb)(struct charset_info_st *, my_wc_t, uchar *s,
                  uchar *e)= to_cs->cset->wc_mb;
     my_wc_t wc;
-    uchar dummy[7]; /* Longer than any single character in our charsets. */
-    int to_cnvres;
+    int cnvres, to_cnvres;
+
+    /* ASCII is the same in both character sets and is copied as is */
+    if (ascii)
+    {
+      size_t span= myodbc_kernels.ascii_span(src,
+                     myodbc_min(src_end - src, result_end - result));
+
+      if (span)
+      {
+        memcpy(result, src, span);
+        result+= span;
+        used_bytes+= span;
+        src+= span;
+        continue;
+      }
+    }
 
-    int cnvres= (*mb_wc)(from_cs, &wc, (uchar *)src, (uchar *)src_end);
+    cnvres= (*mb_wc)(from_cs, &wc, (uchar *)src, (uchar *)src_end);
     if (cnvres == MY_CS_ILSEQ)
     {
       ++error_count;
@@ -646,39 +788,15 @@ copy_ansi_result(STMT *stmt,
                             "from server character set.", 0);
 
 convert_to_out:
-    /*
-     We always convert into a temporary buffer, so we can properly handle
-     characters that are going to get split across requests.
-    */
-    to_cnvres= (*wc_mb)(to_cs, wc, result ? result : dummy,
-                        (result ? result_end : dummy + sizeof(dummy)));
+    to_cnvres= (*wc_mb)(to_cs, wc, result, result_end);
 
     if (to_cnvres > 0)
     {
-      used_chars+= 1;
+      result+= to_cnvres;
       used_bytes+= to_cnvres;
-
-      if (result)
-        result+= to_cnvres;
-
       src+= cnvres;
-
-      if (result && result == result_end)
-      {
-        if (stmt->getdata.dst_bytes != (ulong)~0L)
-        {
-          stmt->getdata.source+= cnvres;
-          break;
-        }
-        *result= '\0';
-        result= NULL;
-      }
-      else if (!result)
-        continue;
-
-      stmt->getdata.source+= cnvres;
     }
-    else if (result && to_cnvres <= MY_CS_TOOSMALL)
+    else if (to_cnvres <= MY_CS_TOOSMALL)
     {
       /*
        If we didn't have enough room for the character, we convert into
@@ -693,16 +811,11 @@ convert_to_out:
                                             result_end - result);
       memcpy(result, stmt->getdata.latest, stmt->getdata.latest_used);
       result+= stmt->getdata.latest_used;
-      *result= '\0';
-      result= NULL;
-
-      used_chars+= 1;
-      used_bytes+= stmt->getdata.latest_bytes;
-
-      src+= stmt->getdata.latest_bytes;
-      stmt->getdata.source+= stmt->getdata.latest_bytes;
+      used_bytes+= stmt->getdata.latest_used;
+      src+= cnvres;
+      break;
     }
-    else if (stmt->getdata.latest_bytes == MY_CS_ILUNI && wc != '?')
+    else if (to_cnvres == MY_CS_ILUNI && wc != '?')
     {
       ++error_count;
       wc= '?';
@@ -714,29 +827,31 @@ convert_to_out:
                             "to result character set.", 0);
   }
 
+  stmt->getdata.source= src;
+
   if (result)
     *result= 0;
 
-  if (result_bytes && stmt->getdata.dst_bytes == (ulong)~0L)
-  {
-    stmt->getdata.dst_bytes= used_bytes;
-    stmt->getdata.dst_offset= 0;
-  }
-
+  /* The total length is counted only once and only if it is asked for */
   if (avail_bytes)
   {
-    if (stmt->getdata.dst_bytes != (ulong)~0L)
-      *avail_bytes= stmt->getdata.dst_bytes - stmt->getdata.dst_offset;
-    else
-      *avail_bytes= used_bytes;
+    if (stmt->getdata.dst_bytes == (ulong)~0L)
+    {
+      stmt->getdata.dst_bytes= stmt->getdata.dst_offset + used_bytes +
+        count_converted_bytes(from_cs, to_cs, src, src_end);
+
+      if (stmt->getdata.latest_bytes)
+        stmt->getdata.dst_bytes+= stmt->getdata.latest_bytes -
+                                  stmt->getdata.latest_used;
+    }
+
+    *avail_bytes= stmt->getdata.dst_bytes - stmt->getdata.dst_offset;
   }
 
-  stmt->getdata.dst_offset+= myodbc_min((ulong)(result_bytes ?
-                                                result_bytes - 1 : 0),
-                                        used_bytes);
+  stmt->getdata.dst_offset+= used_bytes;
 
   /* Did we truncate the data? */
-  if (!result_bytes || stmt->getdata.dst_bytes > stmt->getdata.dst_offset)
+  if (!result_bytes || src < src_end || stmt->getdata.latest_bytes)
   {
     set_stmt_error(stmt, "01004", NULL, 0);
     rc= SQL_SUCCESS_WITH_INFO;
@@ -776,6 +891,7 @@ copy_wchar_result(STMT *stmt,
   char *src_end;
   SQLWCHAR *result_end;
   ulong used_chars= 0, error_count= 0;
+  my_bool ascii;
   CHARSET_INFO *from_cs= get_charset(field->charsetnr ? field->charsetnr :
                                      UTF8_CHARSET_NUMBER,
                                      MYF(0));
@@ -784,6 +900,8 @@ copy_wchar_result(STMT *stmt,
     return set_stmt_error(stmt, "07006", "Source character set not "
     "supported by client", 0);
 
+  ascii= my_charset_is_ascii_based(from_cs);
+
   if (!result_len)
     result= NULL; /* Don't copy anything! */
 
@@ -803,32 +921,30 @@ copy_wchar_result(STMT *stmt,
 
   /* Initialize the source data */
   if (!stmt->getdata.source)
+  {
     stmt->getdata.source= src;
+    stmt->getdata.dst_offset= 0;
+  }
   else
+  {
     src= stmt->getdata.source;
 
-  /* If we've already retrieved everything, return SQL_NO_DATA_FOUND */
-  if (stmt->getdata.dst_bytes != (ulong)~0L &&
-      stmt->getdata.dst_offset >= stmt->getdata.dst_bytes)
-    return SQL_NO_DATA_FOUND;
+    /* If we've already retrieved everything, return SQL_NO_DATA_FOUND */
+    if (src >= src_end && !stmt->getdata.latest_bytes)
+      return SQL_NO_DATA_FOUND;
+  }
 
   /* We may have a leftover char from the last call. */
-  if (stmt->getdata.latest_bytes)
+  if (stmt->getdata.latest_bytes && result)
   {
     memcpy(result, stmt->getdata.latest, sizeof(SQLWCHAR));
     ++result;
-
-    if (result == result_end)
-    {
-      *result= 0;
-      result= NULL;
-    }
-
     used_chars+= 1;
     stmt->getdata.latest_bytes= 0;
   }
 
-  while (src < src_end)
+  /* Every character is converted once - right into the result buffer */
+  while (result && result < result_end && src < src_end)
   {
     /* Find the conversion functions. */
     int (*mb_wc)(struct charset_info_st *, my_wc_t *, const uchar *,
@@ -837,10 +953,25 @@ copy_wchar_result(STMT *stmt,
                  uchar *e)= utf8_charset_info->cset->wc_mb;
     my_wc_t wc;
     uchar u8[5]; /* Max length of utf-8 string we'll see. */
-    SQLWCHAR dummy[2]; /* If SQLWCHAR is UTF-16, we may need two chars. */
-    int to_cnvres;
+    int cnvres, to_cnvres;
+
+    /* ASCII characters are their own code points, they are only widened */
+    if (ascii)
+    {
+      size_t span= myodbc_kernels.ascii_span(src,
+                     myodbc_min(src_end - src, result_end - result));
+
+      if (span)
+      {
+        myodbc_kernels.ascii_to_wchar(result, src, span);
+        result+= span;
+        used_chars+= span;
+        src+= span;
+        continue;
+      }
+    }
 
-    int cnvres= (*mb_wc)(from_cs, &wc, (uchar *)src, (uchar *)src_end);
+    cnvres= (*mb_wc)(from_cs, &wc, (uchar *)src, (uchar *)src_end);
     if (cnvres == MY_CS_ILSEQ)
     {
       ++error_count;
@@ -859,10 +990,6 @@ copy_wchar_result(STMT *stmt,
                             "from server character set.", 0);
 
 convert_to_out:
-    /*
-     We always convert into a temporary buffer, so we can properly handle
-     characters that are going to get split across requests.
-    */
     to_cnvres= (*wc_mb)(utf8_charset_info, wc, u8, u8 + sizeof(u8));
 
     if (to_cnvres > 0)
@@ -873,9 +1000,8 @@ convert_to_out:
 
       if (sizeof(SQLWCHAR) == 4)
       {
-        utf8toutf32(u8, (UTF32 *)(result ? result : dummy));
-        if (result)
-          ++result;
+        utf8toutf32(u8, (UTF32 *)result);
+        ++result;
         used_chars+= 1;
       }
       else
@@ -886,41 +1012,25 @@ convert_to_out:
         utf8toutf32(u8, &u32);
         chars= utf32toutf16(u32, (UTF16 *)out);
 
-        if (result)
-          *result++= out[0];
-
-        used_chars+= chars;
+        *result++= out[0];
+        used_chars+= 1;
 
-        if (chars > 1 && result && result != result_end)
+        if (chars > 1 && result < result_end)
+        {
           *result++= out[1];
-        else if (chars > 1 && result)
+          used_chars+= 1;
+        }
+        else if (chars > 1)
         {
+          /* The low surrogate goes to the next call */
           *((SQLWCHAR *)stmt->getdata.latest)= out[1];
           stmt->getdata.latest_bytes= 2;
           stmt->getdata.latest_used= 0;
-          *result= 0;
-          result= NULL;
-
-          if (stmt->getdata.dst_bytes != (ulong)~0L)
-          {
-            stmt->getdata.source+= cnvres;
-            break;
-          }
+          break;
         }
-        else if (chars > 1)
-          continue;
-      }
-
-      if (result)
-        stmt->getdata.source+= cnvres;
-
-      if (result && result == result_end)
-      {
-        *result= 0;
-        result= NULL;
       }
     }
-    else if (stmt->getdata.latest_bytes == MY_CS_ILUNI && wc != '?')
+    else if (to_cnvres == MY_CS_ILUNI && wc != '?')
     {
       ++error_count;
       wc= '?';
@@ -932,29 +1042,29 @@ convert_to_out:
                             "to result character set.", 0);
   }
 
+  stmt->getdata.source= src;
+
   if (result)
     *result= 0;
 
-  if (result_len && stmt->getdata.dst_bytes == (ulong)~0L)
-  {
-    stmt->getdata.dst_bytes= used_chars * sizeof(SQLWCHAR);
-    stmt->getdata.dst_offset= 0;
-  }
-
+  /* The total length is counted only once and only if it is asked for */
   if (avail_bytes)
   {
-    if (result_len)
-      *avail_bytes= stmt->getdata.dst_bytes - stmt->getdata.dst_offset;
-    else
-      *avail_bytes= used_chars * sizeof(SQLWCHAR);
+    if (stmt->getdata.dst_bytes == (ulong)~0L)
+    {
+      stmt->getdata.dst_bytes= stmt->getdata.dst_offset +
+        (used_chars + (stmt->getdata.latest_bytes ? 1 : 0) +
+         count_converted_bytes(from_cs, NULL, src, src_end)) *
+        sizeof(SQLWCHAR);
+    }
+
+    *avail_bytes= stmt->getdata.dst_bytes - stmt->getdata.dst_offset;
   }
 
-  stmt->getdata.dst_offset+= myodbc_min((ulong)(result_len ?
-                                                result_len - 1 : 0),
-                                        used_chars) * sizeof(SQLWCHAR);
+  stmt->getdata.dst_offset+= used_chars * sizeof(SQLWCHAR);
 
   /* Did we truncate the data? */
-  if (!result_len || stmt->getdata.dst_bytes > stmt->getdata.dst_offset)
+  if (!result_len || src < src_end || stmt->getdata.latest_bytes)
   {
     set_stmt_error(stmt, "01004", NULL, 0);
     rc= SQL_SUCCESS_WITH_INFO;
@@ -987,10 +1097,6 @@ SQLRETURN copy_binhex_result(STMT *stmt,
     ulong length;
     ulong max_length= stmt->stmt_options.max_length;
     ulong *offset= &stmt->getdata.src_offset;
-#if MYSQL_VERSION_ID >= 40100
-    char NEAR _dig_vec[] =
-    "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-#endif
 
     if ( !cbValueMax )
         dst= 0;  /* Don't copy anything! */
@@ -1012,12 +1118,7 @@ SQLRETURN copy_binhex_result(STMT *stmt,
         *pcbValue= src_length*2;
     if ( dst )  /* Bind allows null pointers */
     {
-        ulong i;
-        for ( i= 0 ; i < length ; ++i )
-        {
-            *dst++= _dig_vec[(uchar) *src >> 4];
-            *dst++= _dig_vec[(uchar) *src++ & 15];
-        }
+        dst= myodbc_kernels.hex_encode(dst, src, length);
         *dst= 0;
     }
     if ( (ulong) cbValueMax > length*2 )
@@ -2413,6 +2514,8 @@ int myodbc_casecmp(const char *s, const char *t, uint len)
 void free_internal_result_buffers(STMT *stmt)
 {
   free_root(&stmt->alloc_root, MYF(0));
+  stmt->conv_memo= NULL;
+  stmt->verified_ctype= NULL;
 }
 
 /*
@@ -2493,6 +2596,975 @@ void end_query_log(FILE *query_log)
 }
 
 
+/*
+  FLIGHT_RECORDER: every connection keeps its latest events in a ring of
+  fixed size. Recording an event takes a slot with an atomic increment and
+  does not wait for anybody, so recording is cheap enough to stay on. Each
+  slot has a sequence number, a reader copies the event and checks that
+  the number has not changed meanwhile. The events are dumped as text
+  through SQL_ATTR_MYODBC_FLIGHT_RECORDER, and appended to
+  DRIVER_FLIGHT_LOGFILE when the connection is lost or a timeout happens.
+*/
+
+#ifdef _WIN32
+# define flight_fetch_add(P, V) InterlockedExchangeAdd64((P), (V))
+# define flight_load(P)         InterlockedCompareExchange64((P), 0, 0)
+# define flight_store(P, V)     InterlockedExchange64((P), (V))
+# define flight_cas(P, OLD, NEW) \
+  (InterlockedCompareExchange64((P), (NEW), (OLD)) == (OLD))
+# define flight_fence()         MemoryBarrier()
+#else
+# define flight_fetch_add(P, V) __atomic_fetch_add((P), (V), __ATOMIC_ACQ_REL)
+# define flight_load(P)         __atomic_load_n((P), __ATOMIC_ACQUIRE)
+# define flight_store(P, V)     __atomic_store_n((P), (V), __ATOMIC_RELEASE)
+# define flight_cas(P, OLD, NEW) \
+  __atomic_compare_exchange_n((P), &(OLD), (NEW), 0, __ATOMIC_ACQ_REL, \
+                              __ATOMIC_ACQUIRE)
+# define flight_fence()         __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+ulonglong myodbc_micro_time(void)
+{
+#ifdef _WIN32
+  FILETIME ft;
+  GetSystemTimeAsFileTime(&ft);
+  /* 100ns intervals since 1601 */
+  return ((((ulonglong)ft.dwHighDateTime << 32) | ft.dwLowDateTime) / 10)
+         - 11644473600000000ULL;
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (ulonglong)tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
+
+/*
+  Row by row fetching would flood the ring, so a fetch is added to the
+  latest event if that is a fetch of the same statement. The slot is
+  claimed by turning its sequence number odd, as for a new event.
+
+  @return TRUE if the fetch has been added
+*/
+static my_bool flight_add_fetch(FLIGHT_RECORDER *rec, void *handle, int code,
+                                ulonglong value)
+{
+  longlong number= flight_load(&rec->next) - 1;
+  longlong done= 2 * number + 2;
+  FLIGHT_EVENT *event;
+
+  if (number < 0)
+  {
+    return FALSE;
+  }
+
+  event= &rec->event[number & (FLIGHT_RECORDER_SIZE - 1)];
+
+  if (!flight_cas(&event->seq, done, done - 1))
+  {
+    return FALSE;
+  }
+
+  flight_fence();
+  if (event->type == FE_FETCH && event->handle == handle
+    && event->code == code)
+  {
+    event->value+= value;
+    event->time= myodbc_micro_time();
+    flight_store(&event->seq, done);
+    return TRUE;
+  }
+
+  flight_store(&event->seq, done);
+  return FALSE;
+}
+
+
+void flight_record(DBC *dbc, void *handle, uint type, int code,
+                   ulonglong value)
+{
+  FLIGHT_RECORDER *rec= dbc->flight;
+  FLIGHT_EVENT *event;
+  longlong number;
+
+  if (type == FE_FETCH && flight_add_fetch(rec, handle, code, value))
+  {
+    return;
+  }
+
+  number= flight_fetch_add(&rec->next, 1);
+  event= &rec->event[number & (FLIGHT_RECORDER_SIZE - 1)];
+
+  flight_store(&event->seq, 2 * number + 1);
+  flight_fence();
+  event->time=   myodbc_micro_time();
+  event->handle= handle;
+  event->type=   type;
+  event->code=   code;
+  event->value=  value;
+  flight_store(&event->seq, 2 * number + 2);
+}
+
+
+static const char *flight_event_name(uint type)
+{
+  switch (type)
+  {
+    case FE_CONNECT:      return "connect";
+    case FE_QUERY_START:  return "query_start";
+    case FE_QUERY_END:    return "query_end";
+    case FE_FETCH:        return "fetch";
+    case FE_LOCK_WAIT:    return "lock_wait";
+    case FE_ERROR:        return "error";
+    default:              return "unknown";
+  }
+}
+
+
+/*
+  Formats the recorded events as text, the oldest first. Events that are
+  being written or have been overwritten while copied are left out. The
+  buffer takes FLIGHT_DUMP_SIZE bytes.
+*/
+static void flight_format(FLIGHT_RECORDER *rec, char *to)
+{
+  longlong i, next= flight_load(&rec->next);
+
+  *to= '\0';
+
+  for (i= myodbc_max(0, next - FLIGHT_RECORDER_SIZE); i < next; ++i)
+  {
+    FLIGHT_EVENT *slot= &rec->event[i & (FLIGHT_RECORDER_SIZE - 1)];
+    FLIGHT_EVENT event;
+    longlong seq= flight_load(&slot->seq);
+
+    if (seq != 2 * i + 2)
+    {
+      continue;
+    }
+
+    event= *slot;
+    flight_fence();
+    if (flight_load(&slot->seq) != seq)
+    {
+      continue;
+    }
+
+    if (event.type == FE_ERROR)
+    {
+      char sqlstate[SQL_SQLSTATE_SIZE + 1];
+      memcpy(sqlstate, &event.value, SQL_SQLSTATE_SIZE);
+      sqlstate[SQL_SQLSTATE_SIZE]= '\0';
+
+      to+= sprintf(to, "%llu %p %s %d %s\n", event.time, event.handle,
+                   flight_event_name(event.type), event.code, sqlstate);
+    }
+    else
+    {
+      to+= sprintf(to, "%llu %p %s %d %llu\n", event.time, event.handle,
+                   flight_event_name(event.type), event.code, event.value);
+    }
+  }
+}
+
+
+/**
+  Formats the recorded events as text, the oldest first. One line per event:
+  time in microseconds, handle, event, code and value. SQLSTATE of errors is
+  shown as text.
+
+  @param[in] dbc  The database connection
+
+  @return The text, allocated for the caller to free with x_free(),
+          or NULL if the recorder is off or out of memory
+*/
+char *flight_dump(DBC *dbc)
+{
+  FLIGHT_RECORDER *rec= dbc->flight;
+  char *dump;
+
+  if (rec == NULL || !(dump= myodbc_malloc(FLIGHT_DUMP_SIZE, MYF(0))))
+  {
+    return NULL;
+  }
+
+  flight_format(rec, dump);
+
+  return dump;
+}
+
+
+void flight_error(DBC *dbc, void *handle, const char *sqlstate,
+                  int native_error)
+{
+  ulonglong value= 0;
+  char *dump;
+  FILE *file;
+
+  /* Warnings like truncation can come for every value */
+  if (!strncmp(sqlstate, "01", 2))
+  {
+    return;
+  }
+
+  memcpy(&value, sqlstate, myodbc_min(strlen(sqlstate), SQL_SQLSTATE_SIZE));
+  flight_record(dbc, handle, FE_ERROR, native_error, value);
+
+  /* Lost connection and timeouts are worth keeping the history for */
+  if (strncmp(sqlstate, "08", 2) && strncmp(sqlstate, "HYT", 3))
+  {
+    return;
+  }
+
+  if (!(dump= flight_dump(dbc)))
+  {
+    return;
+  }
+
+  if ((file= fopen(DRIVER_FLIGHT_LOGFILE, "a+")))
+  {
+    fprintf(file, "-- Flight recorder of connection %p, %s %d\n",
+            (void *)dbc, sqlstate, native_error);
+    fputs(dump, file);
+    fclose(file);
+  }
+
+  x_free(dump);
+}
+
+
+/* Locks the connection, recording the time spent waiting for the lock */
+void flight_mutex_lock(DBC *dbc, void *handle)
+{
+  ulonglong start;
+
+  if (dbc->flight == NULL)
+  {
+    myodbc_mutex_lock(&dbc->lock);
+  }
+  else if (myodbc_mutex_trylock(&dbc->lock))
+  {
+    start= myodbc_micro_time();
+    myodbc_mutex_lock(&dbc->lock);
+    flight_record(dbc, handle, FE_LOCK_WAIT, 0, myodbc_micro_time() - start);
+  }
+}
+
+
+/*
+  SLOW_QUERY_MS: SELECTs running longer than the threshold are appended to
+  DRIVER_SLOW_LOGFILE together with their EXPLAIN. EXPLAIN runs on a side
+  connection opened on first use, so the result of the slow query stays
+  untouched. Plans are cached by the normalized query text, and a new
+  EXPLAIN is run not more often than SLOW_QUERY_EXPLAIN_INTERVAL seconds.
+*/
+
+/**
+  Hashes the query with literals, numbers and whitespace differences
+  folded, so that queries differing only by the values share the plan.
+*/
+static ulonglong slow_query_hash(const char *query, SQLULEN query_length)
+{
+  const char *pos= query, *end= query + query_length;
+  ulonglong hash= 14695981039346656037ULL;
+  char c;
+
+  while (pos < end)
+  {
+    c= *pos++;
+
+    if (c == '\'' || c == '"')
+    {
+      char quote= c;
+      /* The literal is skipped with its escapes and doubled quotes */
+      while (pos < end)
+      {
+        if (*pos == '\\' && pos + 1 < end)
+        {
+          pos+= 2;
+        }
+        else if (*pos++ == quote)
+        {
+          if (pos < end && *pos == quote)
+            ++pos;
+          else
+            break;
+        }
+      }
+      c= '?';
+    }
+    else if (isdigit((uchar)c))
+    {
+      while (pos < end && (isdigit((uchar)*pos) || *pos == '.'))
+        ++pos;
+      c= '?';
+    }
+    else if (isspace((uchar)c))
+    {
+      while (pos < end && isspace((uchar)*pos))
+        ++pos;
+      c= ' ';
+    }
+    else if (isalpha((uchar)c) || c == '_')
+    {
+      /* Digits inside of identifiers are not values */
+      hash= (hash ^ (uchar)tolower((uchar)c)) * 1099511628211ULL;
+      while (pos < end && (isalnum((uchar)*pos) || *pos == '_'))
+      {
+        hash= (hash ^ (uchar)tolower((uchar)*pos++)) * 1099511628211ULL;
+      }
+      continue;
+    }
+
+    hash= (hash ^ (uchar)c) * 1099511628211ULL;
+  }
+
+  return hash ? hash : 1;
+}
+
+
+/**
+  Runs EXPLAIN for the query on the side connection and formats the result,
+  one row per line with tab separated values.
+
+  @return The plan allocated with myodbc_malloc, or NULL
+*/
+static char *slow_query_explain(DBC *dbc, const char *query,
+                                SQLULEN query_length)
+{
+  MYSQL_RES *result;
+  MYSQL_ROW row;
+  char *plan, *to, *end;
+  unsigned int i, field_count;
+  char *explain, *database;
+  my_bool failed;
+
+  if (!dbc->explain_mysql)
+  {
+    if (!(dbc->explain_mysql= mysql_init(NULL)))
+    {
+      return NULL;
+    }
+
+    /* SSL and authentication as configured for the connection */
+    if (!myodbc_side_connect(dbc, dbc->explain_mysql))
+    {
+      mysql_close(dbc->explain_mysql);
+      dbc->explain_mysql= NULL;
+      return NULL;
+    }
+  }
+
+  /* The catalog can be changed by another thread */
+  myodbc_mutex_lock(&dbc->lock);
+  database= dbc->database ? myodbc_strdup(dbc->database, MYF(0)) : NULL;
+  myodbc_mutex_unlock(&dbc->lock);
+
+  failed= database && mysql_select_db(dbc->explain_mysql, database);
+  x_free(database);
+
+  if (failed)
+  {
+    return NULL;
+  }
+
+  if (!(explain= myodbc_malloc(query_length + 9, MYF(0))))
+  {
+    return NULL;
+  }
+
+  memcpy(explain, "EXPLAIN ", 8);
+  memcpy(explain + 8, query, query_length);
+  explain[query_length + 8]= '\0';
+
+  if (mysql_real_query(dbc->explain_mysql, explain, query_length + 8) ||
+      !(result= mysql_store_result(dbc->explain_mysql)))
+  {
+    x_free(explain);
+    return NULL;
+  }
+  x_free(explain);
+
+  if (!(plan= myodbc_malloc(SLOW_QUERY_PLAN_LEN, MYF(0))))
+  {
+    mysql_free_result(result);
+    return NULL;
+  }
+
+  to= plan;
+  end= plan + SLOW_QUERY_PLAN_LEN - 1;
+  field_count= mysql_num_fields(result);
+
+  while ((row= mysql_fetch_row(result)) && to < end)
+  {
+    for (i= 0; i < field_count && to < end; ++i)
+    {
+      to+= myodbc_snprintf(to, end - to, "%s%s", i ? "\t" : "",
+                           row[i] ? row[i] : "NULL");
+    }
+    if (to < end)
+    {
+      *to++= '\n';
+    }
+  }
+  *to= '\0';
+
+  mysql_free_result(result);
+  return plan;
+}
+
+
+/**
+  Appends the slow query to DRIVER_SLOW_LOGFILE with its plan.
+
+  @param[in] stmt          The statement which executed the query
+  @param[in] query         The query as sent to the server
+  @param[in] query_length  Length of the query
+  @param[in] elapsed       Execution time in microseconds
+
+  Called after the connection lock is released, the plans and the EXPLAIN
+  connection are guarded by explain_lock.
+*/
+void slow_query_record(STMT *stmt, const char *query, SQLULEN query_length,
+                       ulonglong elapsed)
+{
+  DBC *dbc= stmt->dbc;
+  ulonglong hash= slow_query_hash(query, query_length);
+  const char *plan= NULL, *note= "";
+  SLOW_QUERY_PLAN *entry;
+  time_t now= time(NULL);
+  FILE *file;
+  uint i;
+
+  myodbc_mutex_lock(&dbc->explain_lock);
+
+  for (i= 0; i < SLOW_QUERY_PLANS; ++i)
+  {
+    if (dbc->slow_plans[i].query_hash == hash)
+    {
+      plan= dbc->slow_plans[i].plan;
+      note= " (cached)";
+      break;
+    }
+  }
+
+  /* Parameters of server-side prepared statements are not in the text */
+  if (plan == NULL && !ssps_used(stmt) &&
+      now - dbc->explain_time >= SLOW_QUERY_EXPLAIN_INTERVAL)
+  {
+    dbc->explain_time= now;
+
+    if ((plan= slow_query_explain(dbc, query, query_length)))
+    {
+      entry= &dbc->slow_plans[dbc->slow_plan_next++ % SLOW_QUERY_PLANS];
+      x_free(entry->plan);
+      entry->plan= (char *)plan;
+      entry->query_hash= hash;
+    }
+  }
+
+  if (!(file= fopen(DRIVER_SLOW_LOGFILE, "a+")))
+  {
+    myodbc_mutex_unlock(&dbc->explain_lock);
+    return;
+  }
+
+  fprintf(file, "-- %ld connection %p, %llu.%03llu ms\n%.*s;\n",
+          (long)now, (void *)dbc, elapsed / 1000, elapsed % 1000,
+          (int)query_length, query);
+  if (plan)
+  {
+    fprintf(file, "-- Plan%s:\n%s", note, plan);
+  }
+  else
+  {
+    fputs("-- Plan: not available\n", file);
+  }
+  fclose(file);
+
+  myodbc_mutex_unlock(&dbc->explain_lock);
+}
+
+
+/* Closes the EXPLAIN connection and frees the plans */
+void slow_query_end(DBC *dbc)
+{
+  uint i;
+
+  if (dbc->explain_mysql)
+  {
+    mysql_close(dbc->explain_mysql);
+    dbc->explain_mysql= NULL;
+  }
+
+  for (i= 0; i < SLOW_QUERY_PLANS; ++i)
+  {
+    x_free(dbc->slow_plans[i].plan);
+    dbc->slow_plans[i].plan= NULL;
+    dbc->slow_plans[i].query_hash= 0;
+  }
+  dbc->slow_plan_next= 0;
+  dbc->explain_time= 0;
+}
+
+
+/*
+  FETCH_THREADS: one pool of threads is shared by all connections. It is
+  started by the first connection asking for it, with the number of threads
+  that connection asks for. A batch of tasks is run by the pool threads and
+  the calling thread together. If another batch is running, the caller runs
+  its tasks alone rather than waiting for the pool. The threads are stopped
+  when the last environment is freed, never from DllMain where joining them
+  would deadlock on the loader lock.
+*/
+static struct
+{
+  myodbc_mutex_t    run_lock;       /* one batch at a time */
+  myodbc_mutex_t    lock;           /* protects the rest */
+  myodbc_cond_t     work_cond;      /* signalled when tasks are added */
+  myodbc_cond_t     done_cond;      /* signalled when the batch is done */
+  my_thread_handle  threads[WORKER_POOL_MAX_THREADS];
+  uint              thread_count;
+  WORKER_TASK       *tasks;
+  uint              task_count, next_task, pending;
+  uint              envs;           /* environments allocated, run_lock */
+  my_bool           stop;
+} worker_pool;
+
+
+void worker_pool_init(void)
+{
+  myodbc_mutex_init(&worker_pool.run_lock, NULL);
+  myodbc_mutex_init(&worker_pool.lock, NULL);
+  myodbc_cond_init(&worker_pool.work_cond);
+  myodbc_cond_init(&worker_pool.done_cond);
+}
+
+
+/* Takes the next task of the batch, the pool lock must be held */
+static WORKER_TASK *worker_pool_next(void)
+{
+  if (worker_pool.tasks && worker_pool.next_task < worker_pool.task_count)
+  {
+    return &worker_pool.tasks[worker_pool.next_task++];
+  }
+  return NULL;
+}
+
+
+/* Marks the task done, the pool lock must be held */
+static void worker_pool_done(void)
+{
+  if (--worker_pool.pending == 0)
+  {
+    myodbc_cond_signal(&worker_pool.done_cond);
+  }
+}
+
+
+static void *worker_thread(void *arg __attribute__((unused)))
+{
+  WORKER_TASK *task;
+
+  my_thread_init();
+  myodbc_mutex_lock(&worker_pool.lock);
+
+  while (!worker_pool.stop)
+  {
+    if (!(task= worker_pool_next()))
+    {
+      myodbc_cond_wait(&worker_pool.work_cond, &worker_pool.lock);
+      continue;
+    }
+
+    myodbc_mutex_unlock(&worker_pool.lock);
+    task->func(task->arg);
+    myodbc_mutex_lock(&worker_pool.lock);
+
+    worker_pool_done();
+  }
+
+  myodbc_mutex_unlock(&worker_pool.lock);
+  my_thread_end();
+
+  return NULL;
+}
+
+
+/**
+  Starts the pool threads, if they are not running yet.
+
+  @param[in] threads  Number of threads wanted
+
+  @return Number of threads running in the pool
+*/
+uint worker_pool_start(uint threads)
+{
+  myodbc_mutex_lock(&worker_pool.run_lock);
+
+  if (worker_pool.thread_count == 0)
+  {
+    threads= myodbc_min(threads, WORKER_POOL_MAX_THREADS);
+
+    while (worker_pool.thread_count < threads
+      && !my_thread_create(&worker_pool.threads[worker_pool.thread_count],
+                           NULL, worker_thread, NULL))
+    {
+      ++worker_pool.thread_count;
+    }
+  }
+
+  myodbc_mutex_unlock(&worker_pool.run_lock);
+
+  return worker_pool.thread_count;
+}
+
+
+/**
+  Runs the tasks and returns when all of them are done. The tasks must be
+  independent of each other, they can run in any order.
+*/
+void worker_pool_run(WORKER_TASK *tasks, uint count)
+{
+  WORKER_TASK *task;
+  uint i;
+
+  if (worker_pool.thread_count == 0 || myodbc_mutex_trylock(&worker_pool.run_lock))
+  {
+    for (i= 0; i < count; ++i)
+    {
+      tasks[i].func(tasks[i].arg);
+    }
+    return;
+  }
+
+  myodbc_mutex_lock(&worker_pool.lock);
+  worker_pool.tasks= tasks;
+  worker_pool.task_count= count;
+  worker_pool.next_task= 0;
+  worker_pool.pending= count;
+  myodbc_cond_broadcast(&worker_pool.work_cond);
+
+  /* The calling thread does its share */
+  while ((task= worker_pool_next()))
+  {
+    myodbc_mutex_unlock(&worker_pool.lock);
+    task->func(task->arg);
+    myodbc_mutex_lock(&worker_pool.lock);
+
+    worker_pool_done();
+  }
+
+  while (worker_pool.pending > 0)
+  {
+    myodbc_cond_wait(&worker_pool.done_cond, &worker_pool.lock);
+  }
+
+  worker_pool.tasks= NULL;
+  myodbc_mutex_unlock(&worker_pool.lock);
+  myodbc_mutex_unlock(&worker_pool.run_lock);
+}
+
+
+/* Counts an allocated environment */
+void worker_pool_attach(void)
+{
+  myodbc_mutex_lock(&worker_pool.run_lock);
+  ++worker_pool.envs;
+  myodbc_mutex_unlock(&worker_pool.run_lock);
+}
+
+
+/**
+  Counts a freed environment and stops the pool threads with the last one.
+  The pool is started again by the next worker_pool_start().
+*/
+void worker_pool_detach(void)
+{
+  uint i;
+
+  /* Waits for a running batch */
+  myodbc_mutex_lock(&worker_pool.run_lock);
+
+  if (worker_pool.envs > 0 && --worker_pool.envs == 0
+    && worker_pool.thread_count > 0)
+  {
+    myodbc_mutex_lock(&worker_pool.lock);
+    worker_pool.stop= TRUE;
+    myodbc_cond_broadcast(&worker_pool.work_cond);
+    myodbc_mutex_unlock(&worker_pool.lock);
+
+    for (i= 0; i < worker_pool.thread_count; ++i)
+    {
+      my_thread_join(&worker_pool.threads[i], NULL);
+    }
+
+    worker_pool.thread_count= 0;
+    worker_pool.stop= FALSE;
+  }
+
+  myodbc_mutex_unlock(&worker_pool.run_lock);
+}
+
+
+/*
+  Can be called from DllMain, so the threads are not joined here. They are
+  gone already unless an environment was leaked, in which case they are
+  told to stop and the objects they use are left alone.
+*/
+void worker_pool_end(void)
+{
+  if (worker_pool.thread_count > 0)
+  {
+    myodbc_mutex_lock(&worker_pool.lock);
+    worker_pool.stop= TRUE;
+    myodbc_cond_broadcast(&worker_pool.work_cond);
+    myodbc_mutex_unlock(&worker_pool.lock);
+    return;
+  }
+
+  myodbc_cond_destroy(&worker_pool.work_cond);
+  myodbc_cond_destroy(&worker_pool.done_cond);
+  myodbc_mutex_destroy(&worker_pool.lock);
+  myodbc_mutex_destroy(&worker_pool.run_lock);
+}
+
+
+
+/*
+  MAX_QUERIES: the limiters of all connections, one per server. They are
+  kept until the driver is unloaded.
+*/
+static myodbc_mutex_t admission_lock;
+static ADMISSION      *admission_list;
+
+
+void admission_init(void)
+{
+  myodbc_mutex_init(&admission_lock, NULL);
+}
+
+
+void admission_end(void)
+{
+  ADMISSION *adm;
+
+  while ((adm= admission_list))
+  {
+    admission_list= adm->next;
+    x_free(adm->key);
+    x_free(adm);
+  }
+
+  myodbc_mutex_destroy(&admission_lock);
+}
+
+
+/**
+  Returns the limiter of the server, creating it with the given limit if
+  this is the first connection to the server asking for one.
+*/
+ADMISSION *admission_get(const char *host, uint port, uint limit)
+{
+  ADMISSION *adm;
+  char key[256];
+
+  myodbc_snprintf(key, sizeof(key), "%s:%u", host, port);
+
+  myodbc_mutex_lock(&admission_lock);
+
+  for (adm= admission_list; adm; adm= adm->next)
+  {
+    if (!strcmp(adm->key, key))
+    {
+      break;
+    }
+  }
+
+  if (!adm && (adm= myodbc_malloc(sizeof(ADMISSION), MYF(MY_ZEROFILL))))
+  {
+    if ((adm->key= myodbc_strdup(key, MYF(0))))
+    {
+      adm->limit= limit;
+      adm->next= admission_list;
+      admission_list= adm;
+    }
+    else
+    {
+      x_free(adm);
+      adm= NULL;
+    }
+  }
+
+  myodbc_mutex_unlock(&admission_lock);
+
+  return adm;
+}
+
+
+/* Takes the waiter out of the queue, the admission lock must be held */
+static void admission_unqueue(ADMISSION *adm, ADMISSION_WAITER *waiter)
+{
+  ADMISSION_WAITER **prev, *last= NULL;
+
+  for (prev= &adm->head; *prev; last= *prev, prev= &(*prev)->next)
+  {
+    if (*prev == waiter)
+    {
+      *prev= waiter->next;
+      if (adm->tail == waiter)
+      {
+        adm->tail= last;
+      }
+      --adm->queued;
+      return;
+    }
+  }
+}
+
+
+/**
+  Waits until the query can be run against the server.
+
+  @param[in] adm         Limiter of the server
+  @param[in] timeout_ms  Longest time to wait, 0 - no limit
+
+  @return TRUE if the time ran out, FALSE if the query may be run and
+          admission_leave() has to be called after it.
+*/
+my_bool admission_enter(ADMISSION *adm, uint timeout_ms)
+{
+  ADMISSION_WAITER waiter;
+  struct timespec abstime;
+  ulonglong start, waited;
+
+  myodbc_mutex_lock(&admission_lock);
+
+  if (adm->in_flight < adm->limit && !adm->head)
+  {
+    ++adm->in_flight;
+    ++adm->admitted;
+    myodbc_mutex_unlock(&admission_lock);
+    return FALSE;
+  }
+
+  myodbc_cond_init(&waiter.cond);
+  waiter.admitted= FALSE;
+  waiter.next= NULL;
+
+  if (adm->tail)
+  {
+    adm->tail->next= &waiter;
+  }
+  else
+  {
+    adm->head= &waiter;
+  }
+  adm->tail= &waiter;
+  adm->max_queued= myodbc_max(adm->max_queued, ++adm->queued);
+
+  start= myodbc_micro_time();
+  if (timeout_ms)
+  {
+    set_timespec_nsec(&abstime, (ulonglong)timeout_ms * 1000000ULL);
+  }
+
+  while (!waiter.admitted)
+  {
+    int rc;
+
+    if (!timeout_ms)
+    {
+      myodbc_cond_wait(&waiter.cond, &admission_lock);
+      continue;
+    }
+
+    rc= myodbc_cond_timedwait(&waiter.cond, &admission_lock, &abstime);
+    if ((rc == ETIMEDOUT || rc == ETIME) && !waiter.admitted)
+    {
+      admission_unqueue(adm, &waiter);
+      ++adm->timeouts;
+      break;
+    }
+  }
+
+  waited= myodbc_micro_time() - start;
+  ++adm->waited;
+  adm->wait_us+= waited;
+  adm->max_wait_us= myodbc_max(adm->max_wait_us, waited);
+  if (waiter.admitted)
+  {
+    ++adm->admitted;
+  }
+
+  myodbc_mutex_unlock(&admission_lock);
+  myodbc_cond_destroy(&waiter.cond);
+
+  return !waiter.admitted;
+}
+
+
+/* Hands the slot over to the first waiting query, if there is one */
+void admission_leave(ADMISSION *adm)
+{
+  ADMISSION_WAITER *waiter;
+
+  myodbc_mutex_lock(&admission_lock);
+
+  if ((waiter= adm->head))
+  {
+    adm->head= waiter->next;
+    if (!adm->head)
+    {
+      adm->tail= NULL;
+    }
+    --adm->queued;
+
+    waiter->admitted= TRUE;
+    myodbc_cond_signal(&waiter->cond);
+  }
+  else
+  {
+    --adm->in_flight;
+  }
+
+  myodbc_mutex_unlock(&admission_lock);
+}
+
+
+/*
+  Returns the counters of the connection's limiter as text, or NULL if
+  MAX_QUERIES is not set. Wait times are in microseconds.
+*/
+char *admission_dump(DBC *dbc)
+{
+  ADMISSION *adm= dbc->admission;
+
+  if (adm == NULL)
+  {
+    return NULL;
+  }
+
+  x_free(dbc->admission_dump);
+
+  if (!(dbc->admission_dump= myodbc_malloc(512, MYF(0))))
+  {
+    return NULL;
+  }
+
+  myodbc_mutex_lock(&admission_lock);
+  myodbc_snprintf(dbc->admission_dump, 512,
+                  "server=%s limit=%u in_flight=%u queued=%u max_queued=%u "
+                  "admitted=%llu waited=%llu timeouts=%llu wait_us=%llu "
+                  "max_wait_us=%llu",
+                  adm->key, adm->limit, adm->in_flight, adm->queued,
+                  adm->max_queued, adm->admitted, adm->waited, adm->timeouts,
+                  adm->wait_us, adm->max_wait_us);
+  myodbc_mutex_unlock(&admission_lock);
+
+  return dbc->admission_dump;
+}
+
 my_bool is_minimum_version(const char *server_version,const char *version)
 {
   /* 
@@ -2725,7 +3797,7 @@ void sqlnum_from_str(const char *numstr, SQL_NUMERIC_STRUCT *sqlnum,
   int usedig;
   int i;
   int len;
-  char *decpt= strchr(numstr, '.');
+  const char *decpt;
   int overflow= 0;
   SQLSCHAR reqscale= sqlnum->scale;
   SQLCHAR reqprec= sqlnum->precision;
@@ -2738,6 +3810,12 @@ void sqlnum_from_str(const char *numstr, SQL_NUMERIC_STRUCT *sqlnum,
     ++numstr;
 
   len= (int) strlen(numstr);
+
+  /* The integer part is normally all digits up to the decimal point */
+  decpt= numstr + myodbc_kernels.digit_span(numstr, len);
+  if (*decpt != '.')
+    decpt= strchr(decpt, '.');
+
   sqlnum->precision= len;
   sqlnum->scale= 0;
 
@@ -483,10 +483,12 @@ extern CHARSET_INFO my_charset_latin1;
 typedef DWORD thread_local_key_t;
 typedef CRITICAL_SECTION native_mutex_t;
 typedef int native_mutexattr_t;
+typedef CONDITION_VARIABLE native_cond_t;
 #else
 typedef pthread_key_t thread_local_key_t;
 typedef pthread_mutex_t native_mutex_t;
 typedef pthread_mutexattr_t native_mutexattr_t;
+typedef pthread_cond_t native_cond_t;
 #endif
 
 static inline int native_mutex_init(native_mutex_t *mutex,
@@ -548,6 +550,109 @@ static inline int native_mutex_destroy(native_mutex_t *mutex)
 #endif
 }
 
+static inline int native_cond_init(native_cond_t *cond)
+{
+#ifdef _WIN32
+  InitializeConditionVariable(cond);
+  return 0;
+#else
+  return pthread_cond_init(cond, NULL);
+#endif
+}
+
+static inline int native_cond_destroy(native_cond_t *cond)
+{
+#ifdef _WIN32
+  return 0; /* no destroy function */
+#else
+  return pthread_cond_destroy(cond);
+#endif
+}
+
+static inline int native_cond_wait(native_cond_t *cond, native_mutex_t *mutex)
+{
+#ifdef _WIN32
+  if (!SleepConditionVariableCS(cond, mutex, INFINITE))
+    return ETIMEDOUT;
+  return 0;
+#else
+  return pthread_cond_wait(cond, mutex);
+#endif
+}
+
+#ifdef _WIN32
+/* Time left until abstime in milliseconds, for SleepConditionVariableCS */
+static inline DWORD native_cond_timeout_ms(const struct timespec *abstime)
+{
+#ifndef HAVE_STRUCT_TIMESPEC
+  long long millis;
+  union ft64 now;
+
+  if (abstime == NULL)
+    return INFINITE;
+
+  GetSystemTimeAsFileTime(&now.ft);
+  millis= (abstime->tv.i64 - now.i64) / 10000;
+
+  if (millis < 0)
+    return 0;
+  /* Don't wait forever if the system time changes */
+  if (millis > abstime->max_timeout_msec)
+    millis= abstime->max_timeout_msec;
+  if (millis > UINT_MAX)
+    millis= UINT_MAX;
+
+  return (DWORD)millis;
+#else
+  ulonglong future, now;
+
+  if (abstime == NULL)
+    return INFINITE;
+
+  future= abstime->tv_sec * 1000 + abstime->tv_nsec / 1000000;
+  now= my_getsystime() / 10000;
+
+  return future < now ? 0 : (DWORD)(future - now);
+#endif
+}
+#endif
+
+/*
+  Returns ETIMEDOUT once abstime, as set by set_timespec_nsec(), has passed
+*/
+static inline int native_cond_timedwait(native_cond_t *cond,
+                                        native_mutex_t *mutex,
+                                        const struct timespec *abstime)
+{
+#ifdef _WIN32
+  if (!SleepConditionVariableCS(cond, mutex, native_cond_timeout_ms(abstime)))
+    return ETIMEDOUT;
+  return 0;
+#else
+  return pthread_cond_timedwait(cond, mutex, abstime);
+#endif
+}
+
+static inline int native_cond_signal(native_cond_t *cond)
+{
+#ifdef _WIN32
+  WakeConditionVariable(cond);
+  return 0;
+#else
+  return pthread_cond_signal(cond);
+#endif
+}
+
+static inline int native_cond_broadcast(native_cond_t *cond)
+{
+#ifdef _WIN32
+  WakeAllConditionVariable(cond);
+  return 0;
+#else
+  return pthread_cond_broadcast(cond);
+#endif
+}
+
 /* Debugging */
 #define DBUG_ENTER(a1)
 #define DBUG_LEAVE
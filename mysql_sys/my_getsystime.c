@@ -0,0 +1,52 @@
+/* Copyright (c) 2004, 2015, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA */
+
+#include "mysys_priv.h"
+#include "my_sys.h"
+#include "my_static.h"
+
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
+
+/**
+  Get high-resolution time, in 100ns units since the epoch.
+
+  Used by set_timespec_nsec() to compute the deadline of a timed
+  condition wait.
+*/
+
+ulonglong my_getsystime()
+{
+#ifdef HAVE_CLOCK_GETTIME
+  struct timespec tp;
+  clock_gettime(CLOCK_REALTIME, &tp);
+  return (ulonglong)tp.tv_sec*10000000+(ulonglong)tp.tv_nsec/100;
+#elif defined(_WIN32)
+  LARGE_INTEGER t_cnt;
+  if (query_performance_frequency)
+  {
+    QueryPerformanceCounter(&t_cnt);
+    return ((t_cnt.QuadPart / query_performance_frequency * 10000000) +
+            ((t_cnt.QuadPart % query_performance_frequency) * 10000000 /
+             query_performance_frequency) + query_performance_offset);
+  }
+  return 0;
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (ulonglong)tv.tv_sec*10000000+(ulonglong)tv.tv_usec*10;
+#endif
+}
@@ -81,6 +81,18 @@ static const char *MYODBC_OPTIONS[][3] = {
   {"CAN_HANDLE_EXP_PWD",      "C", "Can Handle Expired Password"},
   {"ENABLE_CLEARTEXT_PLUGIN", "C", "Enable Cleartext Authentication"},
   {"NO_SSPS",                 "C", "Prepare statements on the client"},
+  {"LAZY_CONNECT",            "C", "Delay connecting to the server until it is needed"},
+  {"ADAPTIVE_SSPS",           "C", "Prepare statements on the server only when re-executed"},
+  {"CONVERSION_MEMO",         "C", "Reuse conversions of values repeated in a column"},
+  {"OPTIONAL_METADATA",       "C", "Reuse result set metadata of repeated queries"},
+  {"FLIGHT_RECORDER",         "C", "Keep the latest connection events in memory"},
+  {"SLOW_QUERY_MS",           "T", "Log plans of queries slower than N milliseconds"},
+  {"LOCAL_PROBES",            "C", "Answer connection validation queries without the server"},
+  {"FETCH_THREADS",           "T", "Fill large rowsets using N worker threads"},
+  {"READ_AHEAD",              "T", "Read up to N rows of forward-only results in advance"},
+  {"PREFETCH_KEYSET",         "C", "Continue prefetch chunks from the last ORDER BY key"},
+  {"MAX_QUERIES",             "T", "Run at most N queries against the server at once"},
+  {"QUEUE_TIMEOUT",           "T", "Wait at most N milliseconds for a query slot"},
   {NULL, NULL, NULL}
 };
 
@@ -1203,6 +1203,488 @@ DECLARE_TEST(t_ssl_mode)
   return OK;
 }
 
+/*
+  LAZY_CONNECT: the physical connection is made by the first call that
+  needs the server, with the catalog and autocommit set beforehand applied.
+*/
+DECLARE_TEST(t_lazy_connect)
+{
+  HDBC hdbc1;
+  HSTMT hstmt1;
+  SQLCHAR buf[255];
+  SQLINTEGER len;
+  SQLUINTEGER dead= SQL_CD_TRUE;
+
+  ok_env(henv, SQLAllocHandle(SQL_HANDLE_DBC, henv, &hdbc1));
+  ok_con(hdbc1, get_connection(&hdbc1, NULL, NULL, NULL, NULL,
+                               "LAZY_CONNECT=1"));
+
+  /* None of these needs the server */
+  ok_con(hdbc1, SQLGetConnectAttr(hdbc1, SQL_ATTR_CONNECTION_DEAD, &dead,
+                                  0, NULL));
+  is_num(dead, SQL_CD_FALSE);
+  ok_con(hdbc1, SQLSetConnectAttr(hdbc1, SQL_ATTR_AUTOCOMMIT,
+                                  (SQLPOINTER)SQL_AUTOCOMMIT_OFF, 0));
+  ok_con(hdbc1, SQLSetConnectAttr(hdbc1, SQL_ATTR_CURRENT_CATALOG,
+                                  "information_schema", SQL_NTS));
+  ok_con(hdbc1, SQLGetConnectAttr(hdbc1, SQL_ATTR_CURRENT_CATALOG, buf,
+                                  sizeof(buf), &len));
+  is_str(buf, "information_schema", 19);
+  ok_con(hdbc1, SQLEndTran(SQL_HANDLE_DBC, hdbc1, SQL_ROLLBACK));
+
+  /* The statement handle brings the connection up */
+  ok_con(hdbc1, SQLAllocStmt(hdbc1, &hstmt1));
+  ok_sql(hstmt1, "SELECT DATABASE(), @@autocommit");
+  ok_stmt(hstmt1, SQLFetch(hstmt1));
+  is_str(my_fetch_str(hstmt1, buf, 1), "information_schema", 19);
+  is_num(my_fetch_int(hstmt1, 2), 0);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_DROP));
+
+  ok_con(hdbc1, SQLDisconnect(hdbc1));
+
+  /* Disconnecting before anything needed the server */
+  ok_con(hdbc1, get_connection(&hdbc1, NULL, NULL, NULL, NULL,
+                               "LAZY_CONNECT=1"));
+  ok_con(hdbc1, SQLDisconnect(hdbc1));
+  ok_con(hdbc1, SQLFreeConnect(hdbc1));
+
+  return OK;
+}
+
+#ifndef USE_IODBC
+/*
+  A connection reset for the pool keeps the character set and the session
+  set up by the driver and INITSTMT, user variables are gone. Servers that
+  can reset the session do it without authenticating the user again.
+*/
+DECLARE_TEST(t_reset_connection)
+{
+  HDBC hdbc1;
+  HSTMT hstmt1;
+  SQLCHAR charset[64], buf[64];
+  SQLLEN len;
+  SQLINTEGER connection_id, change_user;
+
+  ok_env(henv, SQLAllocHandle(SQL_HANDLE_DBC, henv, &hdbc1));
+  ok_con(hdbc1, get_connection(&hdbc1, NULL, NULL, NULL, NULL,
+                               "CHARSET=latin1;"
+                               "INITSTMT=SET @@div_precision_increment=7"));
+
+  ok_con(hdbc1, SQLAllocStmt(hdbc1, &hstmt1));
+  ok_sql(hstmt1, "SELECT @@character_set_client, @t_reset_connection:=1, "
+                 "CONNECTION_ID()");
+  ok_stmt(hstmt1, SQLFetch(hstmt1));
+  strcpy((char *)charset, (char *)my_fetch_str(hstmt1, buf, 1));
+  connection_id= my_fetch_int(hstmt1, 3);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  ok_sql(hstmt1, "SHOW GLOBAL STATUS LIKE 'Com_change_user'");
+  ok_stmt(hstmt1, SQLFetch(hstmt1));
+  change_user= my_fetch_int(hstmt1, 2);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_DROP));
+
+  /* As the driver manager does it when the connection goes to the pool */
+  ok_con(hdbc1, SQLSetConnectAttr(hdbc1, SQL_ATTR_RESET_CONNECTION,
+                                  (SQLPOINTER)SQL_RESET_CONNECTION_YES,
+                                  SQL_IS_UINTEGER));
+
+  ok_con(hdbc1, SQLAllocStmt(hdbc1, &hstmt1));
+  ok_sql(hstmt1, "SELECT @@character_set_client, @@character_set_results, "
+                 "@@sql_auto_is_null, @@div_precision_increment, "
+                 "@t_reset_connection");
+  ok_stmt(hstmt1, SQLFetch(hstmt1));
+  is_str(my_fetch_str(hstmt1, buf, 1), charset, strlen((char *)charset));
+  /* The driver converts results itself */
+  ok_stmt(hstmt1, SQLGetData(hstmt1, 2, SQL_C_CHAR, buf, sizeof(buf), &len));
+  is_num(len, SQL_NULL_DATA);
+  is_num(my_fetch_int(hstmt1, 3), 0);
+  is_num(my_fetch_int(hstmt1, 4), 7);
+  ok_stmt(hstmt1, SQLGetData(hstmt1, 5, SQL_C_CHAR, buf, sizeof(buf), &len));
+  is_num(len, SQL_NULL_DATA);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  /* The same session, the handshake and the auth plugin did not run again */
+  ok_sql(hstmt1, "SELECT CONNECTION_ID()");
+  ok_stmt(hstmt1, SQLFetch(hstmt1));
+  is_num(my_fetch_int(hstmt1, 1), connection_id);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  if (mysql_min_version(hdbc1, "5.7.3", 5))
+  {
+    ok_sql(hstmt1, "SHOW GLOBAL STATUS LIKE 'Com_change_user'");
+    ok_stmt(hstmt1, SQLFetch(hstmt1));
+    is_num(my_fetch_int(hstmt1, 2), change_user);
+    ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+  }
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_DROP));
+
+  ok_con(hdbc1, SQLDisconnect(hdbc1));
+  ok_con(hdbc1, SQLFreeConnect(hdbc1));
+
+  return OK;
+}
+#endif
+
+/* Driver specific connection attribute of FLIGHT_RECORDER */
+#define SQL_ATTR_MYODBC_FLIGHT_RECORDER (SQL_DRIVER_CONN_ATTR_BASE + 1)
+
+/*
+  FLIGHT_RECORDER: queries, fetches and errors of the connection are
+  returned by the driver specific connection attribute.
+*/
+DECLARE_TEST(t_flight_recorder)
+{
+  DECLARE_BASIC_HANDLES(henv1, hdbc1, hstmt1);
+  SQLCHAR dump[256 * 96 + 1];
+  SQLINTEGER len, i;
+
+  /* Not available without the option */
+  expect_dbc(hdbc, SQLGetConnectAttr(hdbc, SQL_ATTR_MYODBC_FLIGHT_RECORDER,
+                                     dump, sizeof(dump), &len), SQL_ERROR);
+
+  is(OK == alloc_basic_handles_with_opt(&henv1, &hdbc1, &hstmt1, NULL,
+                                        NULL, NULL, NULL, "FLIGHT_RECORDER=1"));
+
+  ok_sql(hstmt1, "SELECT 1 UNION SELECT 2 UNION SELECT 3");
+  for (i= 0; i < 3; ++i)
+  {
+    ok_stmt(hstmt1, SQLFetch(hstmt1));
+  }
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  expect_sql(hstmt1, "SELECT * FROM t_flight_recorder_no_such_table", SQL_ERROR);
+
+  ok_con(hdbc1, SQLGetConnectAttr(hdbc1, SQL_ATTR_MYODBC_FLIGHT_RECORDER,
+                                  dump, sizeof(dump), &len));
+  printMessage("%s", dump);
+
+  is(strstr((char *)dump, " connect ") != NULL);
+  is(strstr((char *)dump, " query_start ") != NULL);
+  is(strstr((char *)dump, " query_end ") != NULL);
+  /* Row by row fetches are summed up in one event */
+  is(strstr((char *)dump, " fetch 0 3\n") != NULL);
+  /* ER_NO_SUCH_TABLE */
+  is(strstr((char *)dump, " error 1146 ") != NULL);
+
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  return OK;
+}
+
+
+#ifdef _WIN32
+# define SLOW_QUERY_LOGFILE "myodbc_slow.log"
+#else
+# define SLOW_QUERY_LOGFILE "/tmp/myodbc_slow.log"
+#endif
+
+/*
+  SLOW_QUERY_MS: slow SELECTs are logged with their plans and the results
+  are not affected by the EXPLAIN.
+*/
+DECLARE_TEST(t_slow_query)
+{
+  DECLARE_BASIC_HANDLES(henv1, hdbc1, hstmt1);
+  SQLINTEGER i;
+  char log[16384];
+  size_t len;
+  FILE *file;
+
+  remove(SLOW_QUERY_LOGFILE);
+
+  is(OK == alloc_basic_handles_with_opt(&henv1, &hdbc1, &hstmt1, NULL,
+                                        NULL, NULL, NULL, "SLOW_QUERY_MS=1"));
+
+  /* The second run with another value takes the cached plan */
+  for (i= 1; i <= 2; ++i)
+  {
+    SQLCHAR query[64];
+    sprintf((char *)query, "SELECT %d, SLEEP(0.05) AS t_slow_query", (int)i);
+
+    ok_stmt(hstmt1, SQLExecDirect(hstmt1, query, SQL_NTS));
+    ok_stmt(hstmt1, SQLFetch(hstmt1));
+    is_num(my_fetch_int(hstmt1, 1), i);
+    expect_stmt(hstmt1, SQLFetch(hstmt1), SQL_NO_DATA);
+    ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+  }
+
+  /* Fast queries are not logged */
+  ok_sql(hstmt1, "SELECT 1");
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  file= fopen(SLOW_QUERY_LOGFILE, "r");
+  is(file != NULL);
+  len= fread(log, 1, sizeof(log) - 1, file);
+  fclose(file);
+  log[len]= '\0';
+  printMessage("%s", log);
+
+  is(strstr(log, "\nSELECT 1, SLEEP(0.05) AS t_slow_query;\n-- Plan:\n")
+     != NULL);
+  /* The plan of the first one is reused */
+  is(strstr(log, "\nSELECT 2, SLEEP(0.05) AS t_slow_query;\n"
+                 "-- Plan (cached):\n") != NULL);
+  /* EXPLAIN of a query without tables */
+  is(strstr(log, "No tables used") != NULL);
+  is(strstr(log, "\nSELECT 1;\n") == NULL);
+
+  return OK;
+}
+
+
+/* Number of the queries sent to the server, as seen by the flight recorder */
+static int flight_query_count(SQLHDBC hdbc1)
+{
+  SQLCHAR dump[256 * 96 + 1];
+  SQLINTEGER len;
+  char *pos;
+  int count= 0;
+
+  if (!SQL_SUCCEEDED(SQLGetConnectAttr(hdbc1, SQL_ATTR_MYODBC_FLIGHT_RECORDER,
+                                       dump, sizeof(dump), &len)))
+  {
+    return -1;
+  }
+
+  for (pos= strstr((char *)dump, " query_start "); pos != NULL;
+       pos= strstr(pos + 1, " query_start "))
+  {
+    ++count;
+  }
+
+  return count;
+}
+
+
+/*
+  LOCAL_PROBES: validation queries following a successful one are answered
+  by the driver with the same results the server gives.
+*/
+DECLARE_TEST(t_local_probes)
+{
+  DECLARE_BASIC_HANDLES(henv1, hdbc1, hstmt1);
+  SQLCHAR version[MAX_ROW_DATA_LEN + 1], buf[MAX_ROW_DATA_LEN + 1];
+  SQLCHAR *probes[]= {(SQLCHAR *)"SELECT 1", (SQLCHAR *)"SELECT 1",
+                      (SQLCHAR *)"SELECT 1;", (SQLCHAR *)"select 1 ;"};
+  SQLSMALLINT columns;
+  SQLINTEGER i;
+
+  is(OK == alloc_basic_handles_with_opt(&henv1, &hdbc1, &hstmt1, NULL,
+                                        NULL, NULL, NULL,
+                                        "LOCAL_PROBES=1;FLIGHT_RECORDER=1"));
+
+  /* The first one goes to the server, the rest are answered locally */
+  for (i= 0; i < (SQLINTEGER)(sizeof(probes) / sizeof(probes[0])); ++i)
+  {
+    ok_stmt(hstmt1, SQLExecDirect(hstmt1, probes[i], SQL_NTS));
+    ok_stmt(hstmt1, SQLNumResultCols(hstmt1, &columns));
+    is_num(columns, 1);
+    ok_stmt(hstmt1, SQLFetch(hstmt1));
+    is_num(my_fetch_int(hstmt1, 1), 1);
+    expect_stmt(hstmt1, SQLFetch(hstmt1), SQL_NO_DATA);
+    ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+    is_num(flight_query_count(hdbc1), 1);
+  }
+
+  ok_sql(hstmt1, "SELECT @@version");
+  ok_stmt(hstmt1, SQLFetch(hstmt1));
+  strcpy((char *)version, (char *)my_fetch_str(hstmt1, buf, 1));
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  ok_sql(hstmt1, "SELECT VERSION()");
+  ok_stmt(hstmt1, SQLFetch(hstmt1));
+  is_str(my_fetch_str(hstmt1, buf, 1), version, strlen((char *)version));
+  expect_stmt(hstmt1, SQLFetch(hstmt1), SQL_NO_DATA);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+  is_num(flight_query_count(hdbc1), 1);
+
+  /* Not a validation query */
+  ok_sql(hstmt1, "SELECT 1 + 1");
+  ok_stmt(hstmt1, SQLFetch(hstmt1));
+  is_num(my_fetch_int(hstmt1, 1), 2);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+  is_num(flight_query_count(hdbc1), 2);
+
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  return OK;
+}
+
+
+/* Driver specific connection attribute of MAX_QUERIES */
+#define SQL_ATTR_MYODBC_ADMISSION (SQL_DRIVER_CONN_ATTR_BASE + 2)
+
+/*
+  MAX_QUERIES: connections to one server share the limiter, queries are
+  admitted one at a time and the slot is given back after each of them.
+*/
+DECLARE_TEST(t_max_queries)
+{
+  DECLARE_BASIC_HANDLES(henv1, hdbc1, hstmt1);
+  DECLARE_BASIC_HANDLES(henv2, hdbc2, hstmt2);
+  SQLCHAR stats[512];
+  SQLINTEGER len, i;
+
+  /* Not available without the option */
+  expect_dbc(hdbc, SQLGetConnectAttr(hdbc, SQL_ATTR_MYODBC_ADMISSION,
+                                     stats, sizeof(stats), &len), SQL_ERROR);
+
+  is(OK == alloc_basic_handles_with_opt(&henv1, &hdbc1, &hstmt1, NULL,
+                                        NULL, NULL, NULL,
+                                        "MAX_QUERIES=1;QUEUE_TIMEOUT=5000"));
+  is(OK == alloc_basic_handles_with_opt(&henv2, &hdbc2, &hstmt2, NULL,
+                                        NULL, NULL, NULL,
+                                        "MAX_QUERIES=1;QUEUE_TIMEOUT=5000"));
+
+  for (i= 0; i < 3; ++i)
+  {
+    ok_sql(hstmt1, "SELECT 1");
+    ok_stmt(hstmt1, SQLFetch(hstmt1));
+    is_num(my_fetch_int(hstmt1, 1), 1);
+    ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+    ok_sql(hstmt2, "SELECT 2");
+    ok_stmt(hstmt2, SQLFetch(hstmt2));
+    is_num(my_fetch_int(hstmt2, 1), 2);
+    ok_stmt(hstmt2, SQLFreeStmt(hstmt2, SQL_CLOSE));
+  }
+
+  ok_con(hdbc1, SQLGetConnectAttr(hdbc1, SQL_ATTR_MYODBC_ADMISSION,
+                                  stats, sizeof(stats), &len));
+  printMessage("%s", stats);
+
+  is(strstr((char *)stats, " limit=1 in_flight=0 queued=0 ") != NULL);
+  is(strstr((char *)stats, " timeouts=0 ") != NULL);
+  /* Both connections went through the same limiter */
+  is(strstr((char *)stats, " admitted=") != NULL);
+  is(atoi(strstr((char *)stats, " admitted=") + 10) >= 6);
+
+  free_basic_handles(&henv2, &hdbc2, &hstmt2);
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  return OK;
+}
+
+
+/* Runs a query holding the admission slot for a while */
+typedef struct
+{
+  SQLHSTMT  hstmt;
+  SQLRETURN rc;
+} SLOT_HOLDER;
+
+#ifdef WIN32
+DWORD WINAPI hold_admission_slot(LPVOID arg)
+#else
+#include <pthread.h>
+
+void *hold_admission_slot(void *arg)
+#endif
+{
+  SLOT_HOLDER *holder= (SLOT_HOLDER *)arg;
+
+  holder->rc= SQLExecDirect(holder->hstmt, (SQLCHAR *)"SELECT SLEEP(2)",
+                            SQL_NTS);
+  if (SQL_SUCCEEDED(holder->rc))
+  {
+    SQLFreeStmt(holder->hstmt, SQL_CLOSE);
+  }
+
+  return 0;
+}
+
+
+/*
+  MAX_QUERIES: while one connection holds the only slot, a query with a
+  short QUEUE_TIMEOUT gives up with HYT00 and a patient one gets the slot
+  handed over when the first query is done.
+*/
+DECLARE_TEST(t_max_queries_wait)
+{
+  DECLARE_BASIC_HANDLES(henv1, hdbc1, hstmt1);
+  DECLARE_BASIC_HANDLES(henv2, hdbc2, hstmt2);
+  DECLARE_BASIC_HANDLES(henv3, hdbc3, hstmt3);
+  SLOT_HOLDER holder;
+  SQLCHAR stats[512];
+  SQLINTEGER len, i;
+#ifdef WIN32
+  HANDLE thread;
+#else
+  pthread_t thread;
+#endif
+
+  is(OK == alloc_basic_handles_with_opt(&henv1, &hdbc1, &hstmt1, NULL,
+                                        NULL, NULL, NULL,
+                                        "MAX_QUERIES=1;QUEUE_TIMEOUT=5000"));
+  is(OK == alloc_basic_handles_with_opt(&henv2, &hdbc2, &hstmt2, NULL,
+                                        NULL, NULL, NULL,
+                                        "MAX_QUERIES=1;QUEUE_TIMEOUT=200"));
+  is(OK == alloc_basic_handles_with_opt(&henv3, &hdbc3, &hstmt3, NULL,
+                                        NULL, NULL, NULL,
+                                        "MAX_QUERIES=1;QUEUE_TIMEOUT=10000"));
+
+  holder.hstmt= hstmt1;
+  holder.rc= SQL_ERROR;
+#ifdef WIN32
+  thread= CreateThread(NULL, 0, hold_admission_slot, &holder, 0, NULL);
+#else
+  pthread_create(&thread, NULL, hold_admission_slot, &holder);
+#endif
+
+  /* Waiting for the holder to take the slot */
+  for (i= 0; i < 50; ++i)
+  {
+    ok_con(hdbc2, SQLGetConnectAttr(hdbc2, SQL_ATTR_MYODBC_ADMISSION,
+                                    stats, sizeof(stats), &len));
+    if (strstr((char *)stats, " in_flight=1 ") != NULL)
+    {
+      break;
+    }
+#ifdef WIN32
+    Sleep(20);
+#else
+    usleep(20000);
+#endif
+  }
+  is(strstr((char *)stats, " in_flight=1 ") != NULL);
+
+  expect_sql(hstmt2, "SELECT 2", SQL_ERROR);
+  is(check_sqlstate(hstmt2, "HYT00") == OK);
+
+  /* Queued until the holder is done */
+  ok_sql(hstmt3, "SELECT 3");
+  ok_stmt(hstmt3, SQLFetch(hstmt3));
+  is_num(my_fetch_int(hstmt3, 1), 3);
+  ok_stmt(hstmt3, SQLFreeStmt(hstmt3, SQL_CLOSE));
+
+#ifdef WIN32
+  is(WaitForSingleObject(thread, 10000) != WAIT_TIMEOUT);
+  CloseHandle(thread);
+#else
+  pthread_join(thread, NULL);
+#endif
+  is(SQL_SUCCEEDED(holder.rc));
+
+  ok_con(hdbc1, SQLGetConnectAttr(hdbc1, SQL_ATTR_MYODBC_ADMISSION,
+                                  stats, sizeof(stats), &len));
+  printMessage("%s", stats);
+
+  is(strstr((char *)stats, " in_flight=0 queued=0 ") != NULL);
+  is(atoi(strstr((char *)stats, " timeouts=") + 10) >= 1);
+  is(atoi(strstr((char *)stats, " waited=") + 8) >= 2);
+  /* The query of hstmt3 waited for the most part of the SLEEP */
+  is(atoi(strstr((char *)stats, " max_wait_us=") + 13) >= 1000000);
+
+  free_basic_handles(&henv3, &hdbc3, &hstmt3);
+  free_basic_handles(&henv2, &hdbc2, &hstmt2);
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  return OK;
+}
+
+
 BEGIN_TESTS
   ADD_TEST(t_tls_opts)
   ADD_TEST(t_ssl_mode)
@@ -1237,6 +1719,15 @@ BEGIN_TESTS
   ADD_TEST(t_bug45378)
   ADD_TEST(t_bug63844)
   ADD_TEST(t_bug52996)
+  ADD_TEST(t_lazy_connect)
+#ifndef USE_IODBC
+  ADD_TEST(t_reset_connection)
+#endif
+  ADD_TEST(t_flight_recorder)
+  ADD_TEST(t_slow_query)
+  ADD_TEST(t_local_probes)
+  ADD_TEST(t_max_queries)
+  ADD_TEST(t_max_queries_wait)
   END_TESTS
 
 
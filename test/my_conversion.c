@@ -0,0 +1,752 @@
+/*
+  Copyright (c) 2018-Present MongoDB Inc.
+
+  The MySQL Connector/ODBC is licensed under the terms of the GPLv2
+  <http://www.gnu.org/licenses/old-licenses/gpl-2.0.html>, like most
+  MySQL Connectors. There are special exceptions to the terms and
+  conditions of the GPLv2 as it is applied to this software, see the
+  FLOSS License Exception
+  <http://www.mysql.com/about/legal/licensing/foss-exception.html>.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published
+  by the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+  for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+#include "odbctap.h"
+
+/*
+  Differential check of data conversions. Fast paths of the driver are
+  switched on by connection options, so the same generated and edge-case
+  data is read through the default connection and through a connection with
+  an option, and everything the application gets - return codes, SQLSTATEs,
+  indicators and whole buffers - has to match byte for byte. Throughput of
+  both is printed for comparison.
+
+  A new fast path gets covered by adding its option to oracle_options.
+  Conversions done the same way on every connection - text transcoding,
+  binary to hex and SQL_C_NUMERIC - are checked against values the test
+  computes itself from what the server returns.
+*/
+
+#define ORACLE_ROWS    300
+#define ORACLE_CHUNK   5    /* Characters per chunk of chunked reads */
+#define ORACLE_BUFF    512
+#define ORACLE_ROWSET  100  /* Not less than PARALLEL_FETCH_MIN_ROWS */
+#define ORACLE_COLS    8
+#define ORACLE_QUERY   "SELECT * FROM t_conv_oracle ORDER BY id"
+
+static const char *oracle_options[]=
+{
+  "NO_SSPS=1",
+  "CONVERSION_MEMO=1",
+  "NO_SSPS=1;OPTIONAL_METADATA=1",
+  "NO_SSPS=1;FETCH_THREADS=4",
+  "NO_SSPS=1;NO_CACHE=1;READ_AHEAD=64",
+  "NO_SSPS=1;PREFETCH=7;PREFETCH_KEYSET=1"
+};
+
+typedef struct
+{
+  SQLSMALLINT type;
+  const char  *name;
+  SQLLEN      size;     /* Buffer length passed to SQLGetData */
+  int         chunked;  /* Read until SQL_NO_DATA */
+} ORACLE_CTYPE;
+
+static ORACLE_CTYPE oracle_ctypes[]=
+{
+  {SQL_C_CHAR,           "SQL_C_CHAR",           ORACLE_BUFF, 0},
+  {SQL_C_CHAR,           "SQL_C_CHAR chunks",    ORACLE_CHUNK + 1, 1},
+  {SQL_C_WCHAR,          "SQL_C_WCHAR",          ORACLE_BUFF, 0},
+  {SQL_C_WCHAR,          "SQL_C_WCHAR chunks",
+                         (ORACLE_CHUNK + 1) * sizeof(SQLWCHAR), 1},
+  {SQL_C_BINARY,         "SQL_C_BINARY",         ORACLE_BUFF, 0},
+  {SQL_C_BINARY,         "SQL_C_BINARY chunks",  ORACLE_CHUNK, 1},
+  {SQL_C_SBIGINT,        "SQL_C_SBIGINT",        sizeof(SQLBIGINT), 0},
+  {SQL_C_LONG,           "SQL_C_LONG",           sizeof(SQLINTEGER), 0},
+  {SQL_C_DOUBLE,         "SQL_C_DOUBLE",         sizeof(SQLDOUBLE), 0},
+  {SQL_C_NUMERIC,        "SQL_C_NUMERIC",        sizeof(SQL_NUMERIC_STRUCT), 0},
+  {SQL_C_BIT,            "SQL_C_BIT",            sizeof(SQLCHAR), 0},
+  {SQL_C_TYPE_DATE,      "SQL_C_TYPE_DATE",      sizeof(SQL_DATE_STRUCT), 0},
+  {SQL_C_TYPE_TIME,      "SQL_C_TYPE_TIME",      sizeof(SQL_TIME_STRUCT), 0},
+  {SQL_C_TYPE_TIMESTAMP, "SQL_C_TYPE_TIMESTAMP", sizeof(SQL_TIMESTAMP_STRUCT), 0}
+};
+
+static const char *oracle_param_values[]=
+{
+  "0", "-1", "9223372036854775807", "-9223372036854775808",
+  "18446744073709551616", "0.1", "-1.25e-5", "1e308", " 12 ", "abc",
+  "2000-02-29 12:34:56.123456", "1000-01-01", "23:59:59", "838:59:59",
+  "a'b\\c", "\xc3\xa3\xe3\x82\xa1\xf0\x9f\x98\x80", ""
+};
+
+static SQLSMALLINT oracle_param_types[]=
+{
+  SQL_VARCHAR, SQL_BIGINT, SQL_INTEGER, SQL_DECIMAL, SQL_DOUBLE, SQL_BIT,
+  SQL_TYPE_DATE, SQL_TYPE_TIME, SQL_TYPE_TIMESTAMP, SQL_VARBINARY
+};
+
+/* Everything the application has got from the driver */
+typedef struct
+{
+  char   *data;
+  size_t length, size;
+} TRANSCRIPT;
+
+static unsigned long long oracle_seed= 20180101;
+
+
+static unsigned int oracle_rand(void)
+{
+  oracle_seed= oracle_seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (unsigned int)(oracle_seed >> 33);
+}
+
+
+static void transcript_add(TRANSCRIPT *t, const void *data, size_t length)
+{
+  if (t->length + length > t->size)
+  {
+    t->size= (t->length + length) * 2;
+    t->data= realloc(t->data, t->size);
+  }
+
+  memcpy(t->data + t->length, data, length);
+  t->length+= length;
+}
+
+
+static void transcript_add_rc(TRANSCRIPT *t, SQLHSTMT hstmt, SQLRETURN rc)
+{
+  transcript_add(t, &rc, sizeof(rc));
+
+  if (rc == SQL_SUCCESS_WITH_INFO || rc == SQL_ERROR)
+  {
+    SQLCHAR sqlstate[6]= "", message[SQL_MAX_MESSAGE_LENGTH];
+    SQLINTEGER native_error;
+    SQLSMALLINT message_len;
+
+    SQLGetDiagRec(SQL_HANDLE_STMT, hstmt, 1, sqlstate, &native_error,
+                  message, sizeof(message), &message_len);
+    transcript_add(t, sqlstate, 5);
+  }
+}
+
+
+static void transcript_free(TRANSCRIPT *t)
+{
+  free(t->data);
+  t->data= NULL;
+  t->length= t->size= 0;
+}
+
+
+/* UTF-8 text mixing ASCII runs with 2, 3 and 4 byte characters, as hex */
+static char * oracle_text_hex(char *to, unsigned int chars)
+{
+  static const char *ascii[]= {"61", "5a", "30", "20", "27", "5c"};
+  static const char *mb[]= {"c3a3", "d0af", "e382a1", "e282ac", "f09f9880"};
+
+  while (chars--)
+  {
+    to+= sprintf(to, "%s", oracle_rand() % 4 ? ascii[oracle_rand() % 6]
+                                              : mb[oracle_rand() % 5]);
+  }
+
+  return to;
+}
+
+
+static int oracle_fill(SQLHSTMT hstmt)
+{
+  SQLCHAR query[2048];
+  char *pos;
+  unsigned int id, len;
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_conv_oracle");
+  ok_sql(hstmt, "CREATE TABLE t_conv_oracle (id INT PRIMARY KEY, i BIGINT, "
+                "d DECIMAL(30,10), f DOUBLE, dt DATETIME(6), tm TIME, "
+                "s VARCHAR(200) CHARACTER SET utf8mb4, b VARBINARY(64))");
+
+  /* Edge cases */
+  ok_sql(hstmt, "INSERT INTO t_conv_oracle VALUES "
+    "(1, 0, 0, 0, '1000-01-01 00:00:00', '00:00:00', '', X''),"
+    "(2, 9223372036854775807, 99999999999999999999.9999999999, 1e300,"
+    " '9999-12-31 23:59:59.999999', '838:59:59',"
+    " CONVERT(X'f09f9880' USING utf8mb4), X'ff00'),"
+    "(3, -9223372036854775808, -0.0000000001, -0.125,"
+    " '2000-02-29 12:34:56.000001', '-838:59:59', 'a''b\\\\c', X'00'),"
+    "(4, NULL, NULL, NULL, NULL, NULL, NULL, NULL),"
+    "(5, 1, 1, 2.5e-300, '1970-01-01 00:00:01', '-00:00:01',"
+    " REPEAT('x', 200), X'00000000')");
+
+  for (id= 6; id <= ORACLE_ROWS; ++id)
+  {
+    pos= (char *)query;
+    pos+= sprintf(pos, "INSERT INTO t_conv_oracle VALUES (%u, %lld, "
+                  "%s%u%05u.%05u%05u, %d/64, "
+                  "'%04u-%02u-%02u %02u:%02u:%02u.%06u', "
+                  "'%s%u:%02u:%02u', CONVERT(X'",
+                  id,
+                  (long long)(((unsigned long long)oracle_rand() << 32) |
+                              oracle_rand()),
+                  oracle_rand() % 2 ? "-" : "", oracle_rand() % 100000,
+                  oracle_rand() % 100000, oracle_rand() % 100000,
+                  oracle_rand() % 100000,
+                  (int)(oracle_rand() % 2000000) - 1000000,
+                  1000 + oracle_rand() % 9000, 1 + oracle_rand() % 12,
+                  1 + oracle_rand() % 28, oracle_rand() % 24,
+                  oracle_rand() % 60, oracle_rand() % 60,
+                  oracle_rand() % 2 ? oracle_rand() % 1000000 : 0,
+                  oracle_rand() % 2 ? "-" : "", oracle_rand() % 839,
+                  oracle_rand() % 60, oracle_rand() % 60);
+
+    /* Every 10th text is long enough for many chunks */
+    pos= oracle_text_hex(pos, id % 10 ? oracle_rand() % 40 : 150);
+    pos+= sprintf(pos, "' USING utf8mb4), X'");
+
+    for (len= oracle_rand() % 64; len > 0; --len)
+    {
+      pos+= sprintf(pos, "%02x", oracle_rand() % 256);
+    }
+    sprintf(pos, "')");
+
+    ok_stmt(hstmt, SQLExecDirect(hstmt, query, SQL_NTS));
+  }
+
+  return OK;
+}
+
+
+static void oracle_get_data(SQLHSTMT hstmt, SQLUSMALLINT col,
+                            ORACLE_CTYPE *ctype, TRANSCRIPT *t)
+{
+  SQLCHAR buff[ORACLE_BUFF];
+  SQLLEN ind;
+  SQLRETURN rc;
+
+  do
+  {
+    /* The driver must not touch bytes it does not return either */
+    memset(buff, 0xA5, sizeof(buff));
+    ind= 0x5A5A;
+
+    rc= SQLGetData(hstmt, col, ctype->type, buff, ctype->size, &ind);
+    transcript_add_rc(t, hstmt, rc);
+
+    if (!SQL_SUCCEEDED(rc))
+    {
+      break;
+    }
+
+    transcript_add(t, &ind, sizeof(ind));
+    transcript_add(t, buff, ctype->size);
+  } while (ctype->chunked);
+}
+
+
+/* Reads all columns of all rows with SQLGetData as ctype */
+static int oracle_read(SQLHSTMT hstmt, ORACLE_CTYPE *ctype, TRANSCRIPT *t,
+                       int *rows)
+{
+  SQLSMALLINT cols;
+  SQLUSMALLINT col;
+  SQLRETURN rc;
+
+  ok_stmt(hstmt, SQLPrepare(hstmt, (SQLCHAR *)ORACLE_QUERY, SQL_NTS));
+  ok_stmt(hstmt, SQLExecute(hstmt));
+  ok_stmt(hstmt, SQLNumResultCols(hstmt, &cols));
+
+  while ((rc= SQLFetch(hstmt)) != SQL_NO_DATA)
+  {
+    transcript_add_rc(t, hstmt, rc);
+
+    if (!SQL_SUCCEEDED(rc))
+    {
+      break;
+    }
+
+    for (col= 2; col <= cols; ++col)
+    {
+      oracle_get_data(hstmt, col, ctype, t);
+    }
+    ++*rows;
+  }
+
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  return OK;
+}
+
+
+/* Reads rowsets bound as SQL_C_CHAR into buffers short for some values */
+static int oracle_read_rowset(SQLHSTMT hstmt, TRANSCRIPT *t, int *rows)
+{
+  SQLCHAR buff[ORACLE_COLS][ORACLE_ROWSET][ORACLE_CHUNK * 8];
+  SQLLEN ind[ORACLE_COLS][ORACLE_ROWSET];
+  SQLUSMALLINT status[ORACLE_ROWSET], col;
+  SQLULEN fetched;
+  SQLRETURN rc;
+
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_ARRAY_SIZE,
+                                (SQLPOINTER)ORACLE_ROWSET, 0));
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_STATUS_PTR, status, 0));
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ROWS_FETCHED_PTR, &fetched, 0));
+
+  for (col= 0; col < ORACLE_COLS; ++col)
+  {
+    ok_stmt(hstmt, SQLBindCol(hstmt, col + 1, SQL_C_CHAR, buff[col],
+                              sizeof(buff[col][0]), ind[col]));
+  }
+
+  ok_stmt(hstmt, SQLPrepare(hstmt, (SQLCHAR *)ORACLE_QUERY, SQL_NTS));
+  ok_stmt(hstmt, SQLExecute(hstmt));
+
+  for (;;)
+  {
+    memset(buff, 0xA5, sizeof(buff));
+    memset(ind, 0x5A, sizeof(ind));
+    memset(status, 0x5A, sizeof(status));
+    fetched= 0;
+
+    rc= SQLFetch(hstmt);
+    transcript_add_rc(t, hstmt, rc);
+
+    if (!SQL_SUCCEEDED(rc))
+    {
+      break;
+    }
+
+    transcript_add(t, &fetched, sizeof(fetched));
+    transcript_add(t, status, sizeof(status[0]) * fetched);
+
+    for (col= 0; col < ORACLE_COLS; ++col)
+    {
+      transcript_add(t, ind[col], sizeof(ind[col][0]) * fetched);
+      transcript_add(t, buff[col], sizeof(buff[col][0]) * fetched);
+    }
+    *rows+= (int)fetched;
+  }
+
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_UNBIND));
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_ARRAY_SIZE,
+                                (SQLPOINTER)1, 0));
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_STATUS_PTR, NULL, 0));
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ROWS_FETCHED_PTR, NULL, 0));
+
+  return OK;
+}
+
+
+/* Sends every value as a parameter of each SQL type and reads it back */
+static int oracle_read_params(SQLHSTMT hstmt, TRANSCRIPT *t, int *rows)
+{
+  SQLCHAR value[64];
+  SQLLEN value_len;
+  SQLRETURN rc;
+  unsigned int i, j;
+
+  for (i= 0; i < sizeof(oracle_param_types) / sizeof(oracle_param_types[0]);
+       ++i)
+  {
+    ok_stmt(hstmt, SQLPrepare(hstmt, (SQLCHAR *)"SELECT ?", SQL_NTS));
+    ok_stmt(hstmt, SQLBindParameter(hstmt, 1, SQL_PARAM_INPUT, SQL_C_CHAR,
+                                    oracle_param_types[i], 30, 6, value,
+                                    sizeof(value), &value_len));
+
+    for (j= 0;
+         j < sizeof(oracle_param_values) / sizeof(oracle_param_values[0]);
+         ++j)
+    {
+      strcpy((char *)value, oracle_param_values[j]);
+      value_len= SQL_NTS;
+
+      rc= SQLExecute(hstmt);
+      transcript_add_rc(t, hstmt, rc);
+
+      if (SQL_SUCCEEDED(rc))
+      {
+        rc= SQLFetch(hstmt);
+        transcript_add_rc(t, hstmt, rc);
+
+        if (SQL_SUCCEEDED(rc))
+        {
+          oracle_get_data(hstmt, 1, &oracle_ctypes[0], t);
+        }
+      }
+
+      ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+      ++*rows;
+    }
+
+    ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_RESET_PARAMS));
+  }
+
+  return OK;
+}
+
+
+static unsigned int oracle_hex_value(char c)
+{
+  return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+}
+
+
+/* Decodes UTF-8 given as hex into SQLWCHARs, returns the number of them */
+static size_t oracle_hex_to_wchar(SQLWCHAR *to, const char *hex)
+{
+  SQLWCHAR *start= to;
+  unsigned char utf8[ORACLE_BUFF * 2];
+  size_t len= 0, i;
+  unsigned int cp;
+
+  for (; hex[0] && hex[1]; hex+= 2)
+  {
+    utf8[len++]= (unsigned char)(oracle_hex_value(hex[0]) << 4 |
+                                 oracle_hex_value(hex[1]));
+  }
+
+  for (i= 0; i < len;)
+  {
+    if (utf8[i] < 0x80)
+    {
+      cp= utf8[i++];
+    }
+    else if (utf8[i] < 0xE0)
+    {
+      cp= (utf8[i] & 0x1F) << 6 | (utf8[i + 1] & 0x3F);
+      i+= 2;
+    }
+    else if (utf8[i] < 0xF0)
+    {
+      cp= (utf8[i] & 0x0F) << 12 | (utf8[i + 1] & 0x3F) << 6 |
+          (utf8[i + 2] & 0x3F);
+      i+= 3;
+    }
+    else
+    {
+      cp= (utf8[i] & 0x07) << 18 | (utf8[i + 1] & 0x3F) << 12 |
+          (utf8[i + 2] & 0x3F) << 6 | (utf8[i + 3] & 0x3F);
+      i+= 4;
+    }
+
+    if (sizeof(SQLWCHAR) == 2 && cp > 0xFFFF)
+    {
+      cp-= 0x10000;
+      *to++= (SQLWCHAR)(0xD800 | cp >> 10);
+      *to++= (SQLWCHAR)(0xDC00 | (cp & 0x3FF));
+    }
+    else
+    {
+      *to++= (SQLWCHAR)cp;
+    }
+  }
+
+  return to - start;
+}
+
+
+/* SQL_NUMERIC_STRUCT of a decimal string with scale 0, fraction truncated */
+static void oracle_str_to_numeric(SQL_NUMERIC_STRUCT *num, const char *str)
+{
+  unsigned int carry, i;
+
+  memset(num, 0, sizeof(*num));
+  num->sign= *str != '-';
+  if (*str == '-')
+  {
+    ++str;
+  }
+
+  for (; *str >= '0' && *str <= '9'; ++str)
+  {
+    carry= *str - '0';
+    for (i= 0; i < SQL_MAX_NUMERIC_LEN; ++i)
+    {
+      carry+= num->val[i] * 10;
+      num->val[i]= (SQLCHAR)(carry & 0xFF);
+      carry>>= 8;
+    }
+  }
+}
+
+
+/* Concatenates a value read in chunks, returns its length in bytes */
+static size_t oracle_get_chunks(SQLHSTMT hstmt, SQLUSMALLINT col,
+                                SQLSMALLINT type, char *to, SQLLEN *total)
+{
+  SQLWCHAR chunk[ORACLE_CHUNK + 1];
+  size_t unit= type == SQL_C_WCHAR ? sizeof(SQLWCHAR) : 1, length= 0, n;
+  SQLLEN ind;
+  SQLRETURN rc;
+
+  *total= 0;
+
+  while (SQL_SUCCEEDED(rc= SQLGetData(hstmt, col, type, chunk,
+                                      sizeof(chunk), &ind)))
+  {
+    if (length == 0)
+    {
+      *total= ind;
+    }
+    if (ind == SQL_NULL_DATA)
+    {
+      break;
+    }
+
+    /* Values have no zeros, the copied part is terminated */
+    for (n= 0; n * unit < sizeof(chunk)
+                 && memcmp((char *)chunk + n * unit, "\0\0\0\0", unit); ++n);
+    memcpy(to + length, chunk, n * unit);
+    length+= n * unit;
+  }
+
+  return length;
+}
+
+
+/*
+  ASCII parameters come back as they were sent, whatever needs escaping in
+  them and wherever it is. The long ones span several kernel blocks.
+*/
+static int oracle_check_params(SQLHSTMT hstmt)
+{
+  SQLCHAR value[ORACLE_BUFF], got[ORACLE_BUFF];
+  SQLLEN value_len, got_len;
+  unsigned int i, j;
+  const char *special= "'\\\"";
+
+  ok_stmt(hstmt, SQLPrepare(hstmt, (SQLCHAR *)"SELECT ?", SQL_NTS));
+  ok_stmt(hstmt, SQLBindParameter(hstmt, 1, SQL_PARAM_INPUT, SQL_C_CHAR,
+                                  SQL_VARCHAR, sizeof(value), 0, value,
+                                  sizeof(value), &value_len));
+
+  for (i= 0; i < 200; ++i)
+  {
+    if (i < sizeof(oracle_param_values) / sizeof(oracle_param_values[0]))
+    {
+      strcpy((char *)value, oracle_param_values[i]);
+    }
+    else
+    {
+      /* A special character somewhere in a long run of plain ones */
+      for (j= 0; j < 150; ++j)
+      {
+        value[j]= (SQLCHAR)('a' + j % 26);
+      }
+      value[i % 150]= special[i % 3];
+      value[150]= '\0';
+    }
+
+    for (j= 0; value[j] && value[j] < 0x80; ++j);
+    if (value[j])
+    {
+      continue;
+    }
+
+    value_len= SQL_NTS;
+    ok_stmt(hstmt, SQLExecute(hstmt));
+    ok_stmt(hstmt, SQLFetch(hstmt));
+    ok_stmt(hstmt, SQLGetData(hstmt, 1, SQL_C_CHAR, got, sizeof(got),
+                              &got_len));
+    is_num(got_len, strlen((char *)value));
+    is_str(got, value, got_len + 1);
+    ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+  }
+
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_RESET_PARAMS));
+
+  return OK;
+}
+
+
+/*
+  Checks the conversions that have no fast path switched by an option
+  against values computed from the server's HEX() and CAST().
+*/
+static int oracle_check_reference(SQLHSTMT hstmt)
+{
+  SQLCHAR text_hex[ORACLE_BUFF * 4], bin_hex[ORACLE_BUFF], dec[64];
+  SQLWCHAR expected_w[ORACLE_BUFF], got_w[ORACLE_BUFF];
+  char got[ORACLE_BUFF];
+  SQL_NUMERIC_STRUCT expected_num, got_num;
+  SQLLEN text_ind, bin_ind, dec_ind, total;
+  size_t length;
+  int rows= 0;
+
+  ok_sql(hstmt, "SELECT HEX(s), HEX(b), CAST(d AS CHAR), s, b, d "
+                "FROM t_conv_oracle ORDER BY id");
+
+  while (SQLFetch(hstmt) == SQL_SUCCESS)
+  {
+    ok_stmt(hstmt, SQLGetData(hstmt, 1, SQL_C_CHAR, text_hex,
+                              sizeof(text_hex), &text_ind));
+    ok_stmt(hstmt, SQLGetData(hstmt, 2, SQL_C_CHAR, bin_hex,
+                              sizeof(bin_hex), &bin_ind));
+    ok_stmt(hstmt, SQLGetData(hstmt, 3, SQL_C_CHAR, dec, sizeof(dec),
+                              &dec_ind));
+
+    /* Text transcoded to SQLWCHAR a few characters at a time */
+    length= oracle_get_chunks(hstmt, 4, SQL_C_WCHAR, (char *)got_w, &total);
+    if (text_ind == SQL_NULL_DATA)
+    {
+      is_num(total, SQL_NULL_DATA);
+    }
+    else
+    {
+      size_t expected_len= oracle_hex_to_wchar(expected_w, (char *)text_hex);
+
+      is_num(total, expected_len * sizeof(SQLWCHAR));
+      is_num(length, expected_len * sizeof(SQLWCHAR));
+      is(memcmp(got_w, expected_w, length) == 0);
+    }
+
+    /* Binary as hex, in chunks */
+    length= oracle_get_chunks(hstmt, 5, SQL_C_CHAR, got, &total);
+    if (bin_ind == SQL_NULL_DATA)
+    {
+      is_num(total, SQL_NULL_DATA);
+    }
+    else
+    {
+      is_num(total, bin_ind);
+      is_num(length, bin_ind);
+      is(memcmp(got, bin_hex, length) == 0);
+    }
+
+    /* SQL_C_NUMERIC with the default scale 0 */
+    memset(&got_num, 0xA5, sizeof(got_num));
+    is(SQL_SUCCEEDED(SQLGetData(hstmt, 6, SQL_C_NUMERIC, &got_num,
+                                sizeof(got_num), &total)));
+    if (dec_ind == SQL_NULL_DATA)
+    {
+      is_num(total, SQL_NULL_DATA);
+    }
+    else
+    {
+      oracle_str_to_numeric(&expected_num, (char *)dec);
+      is_num(got_num.sign, expected_num.sign);
+      is(memcmp(got_num.val, expected_num.val, SQL_MAX_NUMERIC_LEN) == 0);
+    }
+    ++rows;
+  }
+
+  is_num(rows, ORACLE_ROWS);
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  return oracle_check_params(hstmt);
+}
+
+
+static int oracle_compare(const char *option, const char *pass,
+                          TRANSCRIPT *expected, double expected_time,
+                          TRANSCRIPT *got, double got_time, int rows)
+{
+  size_t i;
+
+  printMessage("%-40s %-22s default %10.0f rows/s, with option %10.0f rows/s",
+               option, pass,
+               expected_time > 0 ? rows / expected_time : 0.0,
+               got_time > 0 ? rows / got_time : 0.0);
+
+  for (i= 0; i < expected->length && i < got->length; ++i)
+  {
+    if (expected->data[i] != got->data[i])
+    {
+      break;
+    }
+  }
+
+  if (i < expected->length || i < got->length)
+  {
+    printMessage("%s, %s: output differs from byte %lu of %lu", option,
+                 pass, (unsigned long)i, (unsigned long)expected->length);
+    return FAIL;
+  }
+
+  return OK;
+}
+
+
+/*
+  Runs the reading function on both connections, compares what they have
+  got and prints the throughput.
+*/
+#define ORACLE_PASS(option, pass, call_expected, call_got) \
+do { \
+  TRANSCRIPT expected= {NULL, 0, 0}, got= {NULL, 0, 0}; \
+  int expected_rows= 0, got_rows= 0; \
+  clock_t start= clock(); \
+  double expected_time, got_time; \
+  is(call_expected == OK); \
+  expected_time= (double)(clock() - start) / CLOCKS_PER_SEC; \
+  start= clock(); \
+  is(call_got == OK); \
+  got_time= (double)(clock() - start) / CLOCKS_PER_SEC; \
+  is_num(got_rows, expected_rows); \
+  is(oracle_compare(option, pass, &expected, expected_time, &got, got_time, \
+                    expected_rows) == OK); \
+  transcript_free(&expected); \
+  transcript_free(&got); \
+} while (0)
+
+
+DECLARE_TEST(t_conversion_oracle)
+{
+  unsigned int i, c;
+
+  is(oracle_fill(hstmt) == OK);
+  is(oracle_check_reference(hstmt) == OK);
+
+  for (i= 0; i < sizeof(oracle_options) / sizeof(oracle_options[0]); ++i)
+  {
+    DECLARE_BASIC_HANDLES(henv1, hdbc1, hstmt1);
+
+    is(OK == alloc_basic_handles_with_opt(&henv1, &hdbc1, &hstmt1, NULL,
+                                          NULL, NULL, NULL,
+                                          (SQLCHAR *)oracle_options[i]));
+
+    is(oracle_check_reference(hstmt1) == OK);
+
+    for (c= 0; c < sizeof(oracle_ctypes) / sizeof(oracle_ctypes[0]); ++c)
+    {
+      ORACLE_PASS(oracle_options[i], oracle_ctypes[c].name,
+                  oracle_read(hstmt, &oracle_ctypes[c], &expected,
+                              &expected_rows),
+                  oracle_read(hstmt1, &oracle_ctypes[c], &got, &got_rows));
+    }
+
+    ORACLE_PASS(oracle_options[i], "rowset SQL_C_CHAR",
+                oracle_read_rowset(hstmt, &expected, &expected_rows),
+                oracle_read_rowset(hstmt1, &got, &got_rows));
+
+    ORACLE_PASS(oracle_options[i], "parameters",
+                oracle_read_params(hstmt, &expected, &expected_rows),
+                oracle_read_params(hstmt1, &got, &got_rows));
+
+    free_basic_handles(&henv1, &hdbc1, &hstmt1);
+  }
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_conv_oracle");
+
+  return OK;
+}
+
+
+BEGIN_TESTS
+  ADD_TEST(t_conversion_oracle)
+END_TESTS
+
+
+RUN_TESTS
@@ -3415,6 +3415,146 @@ DECLARE_TEST(t_18805455)
 }
 
 
+/*
+  READ_AHEAD: rows of a forward-only result come in order while they are
+  read in advance, and closing the cursor in the middle leaves the
+  connection usable.
+*/
+DECLARE_TEST(t_read_ahead)
+{
+  DECLARE_BASIC_HANDLES(henv1, hdbc1, hstmt1);
+  SQLCHAR insert[100 * 32], *pos, buf[MAX_ROW_DATA_LEN + 1];
+  char expected[32];
+  SQLINTEGER i;
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_read_ahead");
+  ok_sql(hstmt, "CREATE TABLE t_read_ahead (id INT, name VARCHAR(20))");
+
+  pos= insert + sprintf((char *)insert, "INSERT INTO t_read_ahead VALUES ");
+  for (i= 0; i < 100; ++i)
+  {
+    if (i % 7)
+    {
+      pos+= sprintf((char *)pos, "%s(%d,'row %d')", i ? "," : "", (int)i,
+                    (int)i);
+    }
+    else
+    {
+      pos+= sprintf((char *)pos, "%s(%d,NULL)", i ? "," : "", (int)i);
+    }
+  }
+  ok_stmt(hstmt, SQLExecDirect(hstmt, insert, SQL_NTS));
+
+  is(OK == alloc_basic_handles_with_opt(&henv1, &hdbc1, &hstmt1, NULL, NULL,
+                                        NULL, NULL, "NO_CACHE=1;READ_AHEAD=4"));
+
+  ok_sql(hstmt1, "SELECT id, name FROM t_read_ahead ORDER BY id");
+  for (i= 0; i < 100; ++i)
+  {
+    SQLLEN len;
+
+    ok_stmt(hstmt1, SQLFetch(hstmt1));
+    is_num(my_fetch_int(hstmt1, 1), i);
+
+    ok_stmt(hstmt1, SQLGetData(hstmt1, 2, SQL_C_CHAR, buf, sizeof(buf), &len));
+    if (i % 7)
+    {
+      sprintf(expected, "row %d", (int)i);
+      is_str(buf, expected, strlen(expected));
+    }
+    else
+    {
+      is_num(len, SQL_NULL_DATA);
+    }
+  }
+  expect_stmt(hstmt1, SQLFetch(hstmt1), SQL_NO_DATA);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  /* Closing the cursor before the end */
+  ok_sql(hstmt1, "SELECT id FROM t_read_ahead ORDER BY id");
+  ok_stmt(hstmt1, SQLFetch(hstmt1));
+  is_num(my_fetch_int(hstmt1, 1), 0);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  ok_sql(hstmt1, "SELECT COUNT(*) FROM t_read_ahead");
+  ok_stmt(hstmt1, SQLFetch(hstmt1));
+  is_num(my_fetch_int(hstmt1, 1), 100);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_read_ahead");
+
+  return OK;
+}
+
+
+/*
+  SQL_REFRESH re-reads the rows of the rowset by their primary key:
+  changed rows get the new values, deleted ones SQL_ROW_DELETED.
+*/
+DECLARE_TEST(t_setpos_refresh_key)
+{
+  SQLHSTMT hstmt1;
+  SQLINTEGER id[3];
+  SQLCHAR name[3][20];
+  SQLLEN name_len[3];
+  SQLUSMALLINT status[3];
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_setpos_refresh_key");
+  ok_sql(hstmt, "CREATE TABLE t_setpos_refresh_key (id INT PRIMARY KEY, "
+                "name VARCHAR(20))");
+  ok_sql(hstmt, "INSERT INTO t_setpos_refresh_key VALUES "
+                "(1,'one'),(2,'two'),(3,'three'),(4,'four')");
+
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_CURSOR_TYPE,
+                                (SQLPOINTER)SQL_CURSOR_STATIC, 0));
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_ARRAY_SIZE,
+                                (SQLPOINTER)3, 0));
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_STATUS_PTR, status, 0));
+  ok_stmt(hstmt, SQLBindCol(hstmt, 1, SQL_C_LONG, id, 0, NULL));
+  ok_stmt(hstmt, SQLBindCol(hstmt, 2, SQL_C_CHAR, name, sizeof(name[0]),
+                            name_len));
+
+  ok_sql(hstmt, "SELECT id, name FROM t_setpos_refresh_key ORDER BY id");
+  ok_stmt(hstmt, SQLFetchScroll(hstmt, SQL_FETCH_NEXT, 0));
+  is_str(name[1], "two", 4);
+
+  ok_stmt(hdbc, SQLAllocHandle(SQL_HANDLE_STMT, hdbc, &hstmt1));
+  ok_sql(hstmt1, "UPDATE t_setpos_refresh_key SET name='TWO' WHERE id=2");
+  ok_sql(hstmt1, "DELETE FROM t_setpos_refresh_key WHERE id=3");
+  ok_stmt(hstmt1, SQLFreeHandle(SQL_HANDLE_STMT, hstmt1));
+
+  ok_stmt(hstmt, SQLSetPos(hstmt, 0, SQL_REFRESH, SQL_LOCK_NO_CHANGE));
+  is_num(id[0], 1);
+  is_str(name[0], "one", 4);
+  is_num(status[0], SQL_ROW_SUCCESS);
+  is_num(id[1], 2);
+  is_str(name[1], "TWO", 4);
+  is_num(status[1], SQL_ROW_SUCCESS);
+  is_num(status[2], SQL_ROW_DELETED);
+
+  /* A single row, the rest of the rowset stays as it was */
+  strcpy((char *)name[0], "stale");
+  ok_stmt(hstmt, SQLSetPos(hstmt, 2, SQL_REFRESH, SQL_LOCK_NO_CHANGE));
+  is_str(name[0], "stale", 6);
+  is_str(name[1], "TWO", 4);
+
+  /* The next rowset comes from the stored result */
+  ok_stmt(hstmt, SQLFetchScroll(hstmt, SQL_FETCH_NEXT, 0));
+  is_num(id[0], 4);
+
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_UNBIND));
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_STATUS_PTR, NULL, 0));
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_ARRAY_SIZE,
+                                (SQLPOINTER)1, 0));
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_setpos_refresh_key");
+
+  return OK;
+}
+
+
 BEGIN_TESTS
   ADD_TEST(my_positioned_cursor)
   ADD_TEST(my_setpos_cursor)
@@ -3476,6 +3616,8 @@ BEGIN_TESTS
   ADD_TEST(t_bug41946)
   /*ADD_TEST(t_sqlputdata)*/
   // ADD_TEST(t_18805455) TODO: Fix
+  ADD_TEST(t_read_ahead)
+  ADD_TEST(t_setpos_refresh_key)
 END_TESTS
 
 
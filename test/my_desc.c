@@ -646,6 +646,59 @@ DECLARE_TEST(t_bug18641633)
 }
 
 
+/*
+  IRD attributes are computed on first access, after the rows were fetched,
+  and before the IRD is copied to another descriptor
+*/
+DECLARE_TEST(t_ird_lazy)
+{
+  SQLHANDLE   ird, desc;
+  SQLCHAR     name[32];
+  SQLSMALLINT concise_type, nullable;
+  SQLULEN     size;
+  SQLINTEGER  nullable_attr;
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_ird_lazy");
+  ok_sql(hstmt, "CREATE TABLE t_ird_lazy (a INT NOT NULL, b VARCHAR(20), "
+                "c DATE, d DECIMAL(10,3), e DOUBLE)");
+  ok_sql(hstmt, "INSERT INTO t_ird_lazy VALUES (1, 'x', '2000-10-10', 1.5, 2)");
+
+  ok_sql(hstmt, "SELECT a, b, c, d, e, a AS a2, b AS b2, c AS c2, d AS d2 "
+                "FROM t_ird_lazy");
+  ok_stmt(hstmt, SQLFetch(hstmt));
+  is_num(my_fetch_int(hstmt, 6), 1);
+
+  ok_stmt(hstmt, SQLDescribeCol(hstmt, 9, name, sizeof(name), NULL,
+                                &concise_type, &size, NULL, &nullable));
+  is_str(name, "d2", 3);
+  is_num(concise_type, SQL_DECIMAL);
+  is_num(size, 10);
+  is_num(nullable, SQL_NULLABLE);
+
+  ok_stmt(hstmt, SQLColAttribute(hstmt, 6, SQL_DESC_NULLABLE, NULL, 0, NULL,
+                                 &nullable_attr));
+  is_num(nullable_attr, SQL_NO_NULLS);
+
+  ok_stmt(hstmt, SQLGetStmtAttr(hstmt, SQL_ATTR_IMP_ROW_DESC, &ird, 0, NULL));
+  ok_desc(ird, SQLGetDescField(ird, 8, SQL_DESC_CONCISE_TYPE, &concise_type,
+                               SQL_IS_SMALLINT, NULL));
+  is_num(concise_type, SQL_TYPE_DATE);
+
+  /* Column 1 has not been looked at yet */
+  ok_con(hdbc, SQLAllocHandle(SQL_HANDLE_DESC, hdbc, &desc));
+  ok_desc(desc, SQLCopyDesc(ird, desc));
+  ok_desc(desc, SQLGetDescField(desc, 1, SQL_DESC_CONCISE_TYPE,
+                                &concise_type, SQL_IS_SMALLINT, NULL));
+  is_num(concise_type, SQL_INTEGER);
+  ok_desc(desc, SQLFreeHandle(SQL_HANDLE_DESC, desc));
+
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_ird_lazy");
+
+  return OK;
+}
+
+
 DECLARE_TEST(dummy_test)
 {
   return OK;
@@ -664,6 +717,7 @@ BEGIN_TESTS
   ADD_TEST(t_free_stmt_with_exp_desc)
   ADD_TEST(t_bug41081)
   ADD_TEST(t_bug44576)
+  ADD_TEST(t_ird_lazy)
 #endif
   ADD_TEST(t_bug18641633)
   ADD_TEST(t_bug18636600)
@@ -103,9 +103,156 @@ DECLARE_TEST(t_dummy_test)
   return OK;
 }
 
+
+#if defined(HAVE_SQLSPI_H) && ODBCVER >= 0x0380
+#include <sqlspi.h>
+#ifndef _WIN32
+# include <dlfcn.h>
+#endif
+
+typedef SQLRETURN (SQL_API *ALLOC_HANDLE_FUNC)(SQLSMALLINT, SQLHANDLE,
+                                               SQLHANDLE *);
+typedef SQLRETURN (SQL_API *FREE_HANDLE_FUNC)(SQLSMALLINT, SQLHANDLE);
+typedef SQLRETURN (SQL_API *CONNECT_INFO_FUNC)(SQLHDBC_INFO_TOKEN, SQLCHAR *,
+                                               SQLSMALLINT);
+typedef SQLRETURN (SQL_API *CONNECT_INFOW_FUNC)(SQLHDBC_INFO_TOKEN,
+                                                SQLWCHAR *, SQLSMALLINT);
+typedef SQLRETURN (SQL_API *RATE_FUNC)(SQLHDBC_INFO_TOKEN, SQLHDBC, BOOL,
+                                       TRANSID, SQLConnPoolRating *);
+
+/* Entry point of the driver the driver manager has loaded */
+static void *driver_function(SQLHDBC hdbc1, const char *name)
+{
+  SQLCHAR driver[256];
+  SQLSMALLINT len;
+#ifdef _WIN32
+  HMODULE module;
+#else
+  void *module;
+#endif
+
+  if (!SQL_SUCCEEDED(SQLGetInfo(hdbc1, SQL_DRIVER_NAME, driver,
+                                sizeof(driver), &len)))
+  {
+    return NULL;
+  }
+
+#ifdef _WIN32
+  module= GetModuleHandleA((char *)driver);
+  return module ? (void *)GetProcAddress(module, name) : NULL;
+#else
+  module= dlopen((char *)driver, RTLD_LAZY | RTLD_NOLOAD);
+  return module ? dlsym(module, name) : NULL;
+#endif
+}
+
+
+/*
+  Driver-aware pooling: the driver reports the capability, and a session
+  changed by a batch of statements rates lower for reuse than a clean one,
+  even if the batch starts with a SELECT.
+*/
+DECLARE_TEST(t_driver_aware_pooling)
+{
+  SQLHDBC hdbc1;
+  SQLHSTMT hstmt1;
+  SQLHENV driver_henv;
+  SQLHDBC driver_hdbc;
+  SQLHDBC_INFO_TOKEN token;
+  SQLConnPoolRating clean, dirty;
+  SQLCHAR conn[512];
+  SQLWCHAR connw[512];
+  SQLUINTEGER capable= 0;
+  ALLOC_HANDLE_FUNC alloc_handle;
+  FREE_HANDLE_FUNC free_handle;
+  CONNECT_INFO_FUNC connect_info;
+  CONNECT_INFOW_FUNC connect_infow;
+  RATE_FUNC rate;
+  unsigned int i;
+
+  ok_con(hdbc, SQLGetInfo(hdbc, SQL_DRIVER_AWARE_POOLING_SUPPORTED, &capable,
+                          sizeof(capable), NULL));
+  is_num(capable, SQL_DRIVER_AWARE_POOLING_CAPABLE);
+
+  sprintf((char *)conn, "DSN=%s;UID=%s;PWD=%s;MULTI_STATEMENTS=1",
+          (char *)mydsn, (char *)myuid, (char *)mypwd);
+  if (mysock != NULL)
+  {
+    strcat((char *)conn, ";SOCKET=");
+    strcat((char *)conn, (char *)mysock);
+  }
+
+  ok_env(henv, SQLAllocHandle(SQL_HANDLE_DBC, henv, &hdbc1));
+  ok_con(hdbc1, SQLDriverConnect(hdbc1, NULL, conn, SQL_NTS, NULL, 0, NULL,
+                                 SQL_DRIVER_NOPROMPT));
+  ok_con(hdbc1, SQLAllocHandle(SQL_HANDLE_STMT, hdbc1, &hstmt1));
+
+  alloc_handle=  (ALLOC_HANDLE_FUNC)driver_function(hdbc1, "SQLAllocHandle");
+  free_handle=   (FREE_HANDLE_FUNC)driver_function(hdbc1, "SQLFreeHandle");
+  connect_info=  (CONNECT_INFO_FUNC)driver_function(hdbc1,
+                                                    "SQLSetDriverConnectInfo");
+  connect_infow= (CONNECT_INFOW_FUNC)driver_function(hdbc1,
+                                                     "SQLSetDriverConnectInfoW");
+  rate=          (RATE_FUNC)driver_function(hdbc1, "SQLRateConnection");
+
+  if (!alloc_handle || !free_handle || !rate || !(connect_info || connect_infow))
+  {
+    ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_DROP));
+    ok_con(hdbc1, SQLDisconnect(hdbc1));
+    ok_con(hdbc1, SQLFreeConnect(hdbc1));
+    skip("The driver is not reachable past the driver manager");
+  }
+
+  /* The handles of the driver behind the ones of the driver manager */
+  ok_con(hdbc1, SQLGetInfo(hdbc1, SQL_DRIVER_HENV, &driver_henv,
+                           sizeof(driver_henv), NULL));
+  ok_con(hdbc1, SQLGetInfo(hdbc1, SQL_DRIVER_HDBC, &driver_hdbc,
+                           sizeof(driver_hdbc), NULL));
+
+  is(SQL_SUCCEEDED(alloc_handle(SQL_HANDLE_DBC_INFO_TOKEN, driver_henv,
+                                &token)));
+  if (connect_infow)
+  {
+    for (i= 0; i == 0 || conn[i - 1]; ++i)
+    {
+      connw[i]= conn[i];
+    }
+    is(SQL_SUCCEEDED(connect_infow(token, connw, SQL_NTS)));
+  }
+  else
+  {
+    is(SQL_SUCCEEDED(connect_info(token, conn, SQL_NTS)));
+  }
+
+  ok_sql(hstmt1, "SELECT 1");
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+  is(SQL_SUCCEEDED(rate(token, driver_hdbc, FALSE, NULL, &clean)));
+  is(clean > 0);
+
+  /* Only the 1st statement of the batch is parsed */
+  ok_sql(hstmt1, "SELECT 1; CREATE TEMPORARY TABLE t_pool_dirty (a INT)");
+  while (SQLMoreResults(hstmt1) == SQL_SUCCESS);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+  is(SQL_SUCCEEDED(rate(token, driver_hdbc, FALSE, NULL, &dirty)));
+  is(dirty < clean);
+
+  is(SQL_SUCCEEDED(free_handle(SQL_HANDLE_DBC_INFO_TOKEN, token)));
+
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_DROP));
+  ok_con(hdbc1, SQLDisconnect(hdbc1));
+  ok_con(hdbc1, SQLFreeConnect(hdbc1));
+
+  return OK;
+}
+#endif
+
+
 BEGIN_TESTS
   // ADD_TEST(t_reset_connection) TODO: Fix
   ADD_TEST(t_dummy_test)
+#if defined(HAVE_SQLSPI_H) && ODBCVER >= 0x0380
+  ADD_TEST(t_driver_aware_pooling)
+#endif
 END_TESTS
 
 myenable_pooling= 1;
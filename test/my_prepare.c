@@ -1252,6 +1252,273 @@ DECLARE_TEST(t_bug67920)
 }
 
 
+/*
+  Binary protocol values fetched as SQL_C_CHAR are formatted by the driver
+  and have to look like the text protocol ones.
+*/
+DECLARE_TEST(t_ssps_char_format)
+{
+  SQLINTEGER id= 0;
+  SQLCHAR buf[MAX_ROW_DATA_LEN+1];
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_ssps_char_format");
+  ok_sql(hstmt, "CREATE TABLE t_ssps_char_format (id int, i bigint, "
+                "u bigint unsigned, d double, f float, dt datetime(6), "
+                "dt0 datetime, t time(6), dd date)");
+  ok_sql(hstmt, "INSERT INTO t_ssps_char_format VALUES (1, "
+                "-9223372036854775808, 18446744073709551615, 0.1, 1.5, "
+                "'2015-07-04 12:34:56.5', '2015-07-04 01:02:03', "
+                "'-838:59:58.000001', '0001-01-01')");
+
+  ok_stmt(hstmt, SQLBindParameter(hstmt, 1, SQL_PARAM_INPUT, SQL_C_LONG,
+                                  SQL_INTEGER, 0, 0, &id, 0, NULL));
+  ok_stmt(hstmt, SQLExecDirect(hstmt, "SELECT i, u, d, f, dt, dt0, t, dd "
+                               "FROM t_ssps_char_format WHERE id > ?",
+                               SQL_NTS));
+  ok_stmt(hstmt, SQLFetch(hstmt));
+
+  is_str(my_fetch_str(hstmt, buf, 1), "-9223372036854775808", 21);
+  is_str(my_fetch_str(hstmt, buf, 2), "18446744073709551615", 21);
+  is_str(my_fetch_str(hstmt, buf, 3), "0.1", 4);
+  is_str(my_fetch_str(hstmt, buf, 4), "1.5", 4);
+  is_str(my_fetch_str(hstmt, buf, 5), "2015-07-04 12:34:56.500000", 27);
+  is_str(my_fetch_str(hstmt, buf, 6), "2015-07-04 01:02:03", 20);
+  is_str(my_fetch_str(hstmt, buf, 7), "-838:59:58.000001", 18);
+  is_str(my_fetch_str(hstmt, buf, 8), "0001-01-01", 11);
+
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_RESET_PARAMS));
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_ssps_char_format");
+
+  return OK;
+}
+
+
+/*
+  Re-executing prepared statement reuses the parameter binds while buffers
+  stay the same. Values changed in between and growing buffers have to be
+  picked up nevertheless.
+*/
+DECLARE_TEST(t_ssps_rebind)
+{
+  SQLINTEGER num= 0, i;
+  SQLCHAR str[300], buf[MAX_ROW_DATA_LEN+1];
+
+  ok_stmt(hstmt, SQLPrepare(hstmt, "SELECT ?, ?", SQL_NTS));
+  ok_stmt(hstmt, SQLBindParameter(hstmt, 1, SQL_PARAM_INPUT, SQL_C_LONG,
+                                  SQL_INTEGER, 0, 0, &num, 0, NULL));
+  ok_stmt(hstmt, SQLBindParameter(hstmt, 2, SQL_PARAM_INPUT, SQL_C_CHAR,
+                                  SQL_VARCHAR, sizeof(str), 0, str, 0, NULL));
+
+  for (i= 0; i < 3; ++i)
+  {
+    num= i * 100;
+    /* Longer string each time, so the driver has to grow its buffer */
+    memset(str, 'a' + i, 1 + i * 100);
+    str[1 + i * 100]= '\0';
+
+    ok_stmt(hstmt, SQLExecute(hstmt));
+    ok_stmt(hstmt, SQLFetch(hstmt));
+    is_num(my_fetch_int(hstmt, 1), i * 100);
+    is_str(my_fetch_str(hstmt, buf, 2), str, 1 + i * 100);
+    ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+  }
+
+  /* Different type for the same parameter */
+  ok_stmt(hstmt, SQLBindParameter(hstmt, 1, SQL_PARAM_INPUT, SQL_C_CHAR,
+                                  SQL_VARCHAR, sizeof(str), 0, str, 0, NULL));
+  ok_stmt(hstmt, SQLExecute(hstmt));
+  ok_stmt(hstmt, SQLFetch(hstmt));
+  is_str(my_fetch_str(hstmt, buf, 1), str, 202);
+
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_RESET_PARAMS));
+
+  return OK;
+}
+
+
+/*
+  Variable length columns of the server-side prepared statement: buffers are
+  kept between the rows, values growing and shrinking have to come intact.
+*/
+DECLARE_TEST(t_ssps_varlength)
+{
+  SQLINTEGER id= 0, i, j;
+  SQLCHAR buf[6001], expected[6001];
+  SQLLEN len;
+  const SQLINTEGER sizes[]= {10, 3000, 5, 5000, 0, 4000, 4000, 1};
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_ssps_varlength");
+  ok_sql(hstmt, "CREATE TABLE t_ssps_varlength (id int primary key, t text)");
+
+  for (i= 0; i < (SQLINTEGER)(sizeof(sizes)/sizeof(sizes[0])); ++i)
+  {
+    char query[64];
+    sprintf(query, "INSERT INTO t_ssps_varlength VALUES (%d, REPEAT('%c', %d))",
+            i, 'a' + i, sizes[i]);
+    ok_stmt(hstmt, SQLExecDirect(hstmt, (SQLCHAR *)query, SQL_NTS));
+  }
+
+  ok_stmt(hstmt, SQLPrepare(hstmt, "SELECT id, t FROM t_ssps_varlength "
+                                   "WHERE id >= ? ORDER BY id", SQL_NTS));
+  ok_stmt(hstmt, SQLBindParameter(hstmt, 1, SQL_PARAM_INPUT, SQL_C_LONG,
+                                  SQL_INTEGER, 0, 0, &id, 0, NULL));
+  ok_stmt(hstmt, SQLExecute(hstmt));
+
+  for (i= 0; i < (SQLINTEGER)(sizeof(sizes)/sizeof(sizes[0])); ++i)
+  {
+    ok_stmt(hstmt, SQLFetch(hstmt));
+    is_num(my_fetch_int(hstmt, 1), i);
+
+    for (j= 0; j < sizes[i]; ++j)
+    {
+      expected[j]= 'a' + i;
+    }
+    expected[sizes[i]]= '\0';
+
+    ok_stmt(hstmt, SQLGetData(hstmt, 2, SQL_C_CHAR, buf, sizeof(buf), &len));
+    is_num(len, sizes[i]);
+    is_str(buf, expected, sizes[i] + 1);
+  }
+
+  expect_stmt(hstmt, SQLFetch(hstmt), SQL_NO_DATA);
+
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_RESET_PARAMS));
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_ssps_varlength");
+
+  return OK;
+}
+
+
+/*
+  Columns without a buffer allocated upfront, that are not strings or BLOBs,
+  have to come intact as well.
+*/
+DECLARE_TEST(t_ssps_json)
+{
+  SQLINTEGER id= 0, i;
+  SQLCHAR buf[4096], expected[4096];
+  SQLLEN len;
+  const SQLINTEGER sizes[]= {2, 1000, 10, 2000};
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_ssps_json");
+  ok_sql(hstmt, "CREATE TABLE t_ssps_json (id int primary key, j json)");
+
+  for (i= 0; i < (SQLINTEGER)(sizeof(sizes)/sizeof(sizes[0])); ++i)
+  {
+    char query[96];
+    sprintf(query, "INSERT INTO t_ssps_json VALUES "
+                   "(%d, JSON_ARRAY(REPEAT('%c', %d)))", i, 'a' + i, sizes[i]);
+    ok_stmt(hstmt, SQLExecDirect(hstmt, (SQLCHAR *)query, SQL_NTS));
+  }
+
+  ok_stmt(hstmt, SQLPrepare(hstmt, "SELECT id, j FROM t_ssps_json "
+                                   "WHERE id >= ? ORDER BY id", SQL_NTS));
+  ok_stmt(hstmt, SQLBindParameter(hstmt, 1, SQL_PARAM_INPUT, SQL_C_LONG,
+                                  SQL_INTEGER, 0, 0, &id, 0, NULL));
+  ok_stmt(hstmt, SQLExecute(hstmt));
+
+  for (i= 0; i < (SQLINTEGER)(sizeof(sizes)/sizeof(sizes[0])); ++i)
+  {
+    ok_stmt(hstmt, SQLFetch(hstmt));
+    is_num(my_fetch_int(hstmt, 1), i);
+
+    expected[0]= '[';
+    expected[1]= '"';
+    memset(expected + 2, 'a' + i, sizes[i]);
+    strcpy((char *)expected + 2 + sizes[i], "\"]");
+
+    ok_stmt(hstmt, SQLGetData(hstmt, 2, SQL_C_CHAR, buf, sizeof(buf), &len));
+    is_num(len, sizes[i] + 4);
+    is_str(buf, expected, sizes[i] + 5);
+  }
+
+  expect_stmt(hstmt, SQLFetch(hstmt), SQL_NO_DATA);
+
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_RESET_PARAMS));
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_ssps_json");
+
+  return OK;
+}
+
+
+static int stmt_prepare_count(SQLHSTMT hstmt)
+{
+  int count= -1;
+
+  if (SQL_SUCCEEDED(SQLExecDirect(hstmt, (SQLCHAR *)"SHOW SESSION STATUS "
+                                  "LIKE 'Com_stmt_prepare'", SQL_NTS))
+    && SQL_SUCCEEDED(SQLFetch(hstmt)))
+  {
+    count= my_fetch_int(hstmt, 2);
+  }
+  SQLFreeStmt(hstmt, SQL_CLOSE);
+
+  return count;
+}
+
+
+/*
+  ADAPTIVE_SSPS: query is prepared on the server only when it is executed
+  again and returns numeric or temporal columns.
+*/
+DECLARE_TEST(t_adaptive_ssps)
+{
+  DECLARE_BASIC_HANDLES(henv1, hdbc1, hstmt1);
+  SQLHSTMT hstmt2;
+  SQLINTEGER num= 0, i, prepared;
+  SQLCHAR buf[MAX_ROW_DATA_LEN+1], expected[32];
+
+  is(OK == alloc_basic_handles_with_opt(&henv1, &hdbc1, &hstmt1, NULL,
+                                        NULL, NULL, NULL, "ADAPTIVE_SSPS=1"));
+  ok_con(hdbc1, SQLAllocStmt(hdbc1, &hstmt2));
+
+  prepared= stmt_prepare_count(hstmt2);
+
+  ok_stmt(hstmt1, SQLPrepare(hstmt1, "SELECT ?, CONCAT('a', ?)", SQL_NTS));
+  ok_stmt(hstmt1, SQLBindParameter(hstmt1, 1, SQL_PARAM_INPUT, SQL_C_LONG,
+                                   SQL_INTEGER, 0, 0, &num, 0, NULL));
+  ok_stmt(hstmt1, SQLBindParameter(hstmt1, 2, SQL_PARAM_INPUT, SQL_C_LONG,
+                                   SQL_INTEGER, 0, 0, &num, 0, NULL));
+
+  for (i= 0; i < 3; ++i)
+  {
+    num= i;
+    ok_stmt(hstmt1, SQLExecute(hstmt1));
+    ok_stmt(hstmt1, SQLFetch(hstmt1));
+    is_num(my_fetch_int(hstmt1, 1), i);
+    sprintf((char *)expected, "a%d", i);
+    is_str(my_fetch_str(hstmt1, buf, 2), expected, 3);
+    ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+    /* First execution goes over text protocol */
+    is_num(stmt_prepare_count(hstmt2), prepared + (i > 0 ? 1 : 0));
+  }
+
+  /* Only string column - preparing would not pay off */
+  ok_stmt(hstmt1, SQLPrepare(hstmt1, "SELECT CONCAT('a', ?)", SQL_NTS));
+  for (i= 0; i < 3; ++i)
+  {
+    num= i;
+    ok_stmt(hstmt1, SQLExecute(hstmt1));
+    ok_stmt(hstmt1, SQLFetch(hstmt1));
+    sprintf((char *)expected, "a%d", i);
+    is_str(my_fetch_str(hstmt1, buf, 1), expected, 3);
+    ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+  }
+  is_num(stmt_prepare_count(hstmt2), prepared + 1);
+
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_RESET_PARAMS));
+  ok_stmt(hstmt2, SQLFreeStmt(hstmt2, SQL_DROP));
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  return OK;
+}
+
+
 BEGIN_TESTS
   ADD_TEST(t_prep_basic)
   ADD_TEST(t_prep_buffer_length)
@@ -1273,6 +1540,11 @@ BEGIN_TESTS
   ADD_TEST(t_bug67702)
   ADD_TEST(t_bug68243)
   ADD_TEST(t_bug67920)
+  ADD_TEST(t_ssps_char_format)
+  ADD_TEST(t_ssps_rebind)
+  ADD_TEST(t_ssps_varlength)
+  ADD_TEST(t_ssps_json)
+  ADD_TEST(t_adaptive_ssps)
 END_TESTS
 
 
@@ -1368,6 +1368,597 @@ DECLARE_TEST(t_prefetch_bug)
     return OK;
 }
 
+/*
+  CONVERSION_MEMO: repeated values are taken from the memo, high-cardinality
+  column turns the memo off. Either way results have to stay the same.
+*/
+DECLARE_TEST(t_conversion_memo)
+{
+  DECLARE_BASIC_HANDLES(henv1, hdbc1, hstmt1);
+  SQLINTEGER i, num;
+  SQLWCHAR wbuf[20];
+  SQLLEN wlen;
+  SQL_DATE_STRUCT date;
+  wchar_t expected[3];
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_conversion_memo");
+  ok_sql(hstmt, "CREATE TABLE t_conversion_memo (id int, d date)");
+  ok_sql(hstmt, "INSERT INTO t_conversion_memo VALUES (0, '2020-01-01'), "
+                "(1, '2020-01-02'), (2, '2020-01-03'), (3, '2020-01-04'), "
+                "(4, '2020-01-05'), (5, '2020-01-06'), (6, '2020-01-07'), "
+                "(7, '2020-01-08')");
+
+  is(OK == alloc_basic_handles_with_opt(&henv1, &hdbc1, &hstmt1, NULL,
+                                        NULL, NULL, NULL, "CONVERSION_MEMO=1"));
+
+  ok_sql(hstmt1, "SELECT CONCAT('s', a.id), a.id * 10, a.d, "
+                 "a.id * 100 + b.id * 10 + c.id "
+                 "FROM t_conversion_memo a, t_conversion_memo b, "
+                 "t_conversion_memo c ORDER BY a.id, b.id, c.id");
+
+  for (i= 0; i < 512; ++i)
+  {
+    SQLINTEGER a= i / 64;
+
+    ok_stmt(hstmt1, SQLFetch(hstmt1));
+
+    ok_stmt(hstmt1, SQLGetData(hstmt1, 1, SQL_C_WCHAR, wbuf, sizeof(wbuf),
+                               &wlen));
+    is_num(wlen, 2 * sizeof(SQLWCHAR));
+    expected[0]= L's';
+    expected[1]= L'0' + a;
+    expected[2]= 0;
+    is_wstr(sqlwchar_to_wchar_t(wbuf), expected, 3);
+    expect_stmt(hstmt1, SQLGetData(hstmt1, 1, SQL_C_WCHAR, wbuf, sizeof(wbuf),
+                                   &wlen), SQL_NO_DATA);
+
+    ok_stmt(hstmt1, SQLGetData(hstmt1, 2, SQL_C_LONG, &num, 0, NULL));
+    is_num(num, a * 10);
+
+    ok_stmt(hstmt1, SQLGetData(hstmt1, 3, SQL_C_TYPE_DATE, &date, 0, NULL));
+    is_num(date.year, 2020);
+    is_num(date.month, 1);
+    is_num(date.day, a + 1);
+
+    ok_stmt(hstmt1, SQLGetData(hstmt1, 4, SQL_C_LONG, &num, 0, NULL));
+    is_num(num, (i / 64) * 100 + ((i / 8) % 8) * 10 + i % 8);
+  }
+
+  expect_stmt(hstmt1, SQLFetch(hstmt1), SQL_NO_DATA);
+
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_conversion_memo");
+
+  return OK;
+}
+
+
+/*
+  Benchmark of SQLGetData per-call overhead: many small cells are read from
+  a result that is already on the client, so the time is mostly spent in
+  the driver. Prints nanoseconds per call, does not fail on timing.
+*/
+DECLARE_TEST(t_getdata_overhead)
+{
+  SQLINTEGER num, rows= 0, col;
+  SQLCHAR buf[16];
+  SQLLEN len;
+  long calls= 0;
+  clock_t start;
+  double elapsed;
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_getdata_overhead");
+  ok_sql(hstmt, "CREATE TABLE t_getdata_overhead (a int, b int, c int, "
+                "d varchar(8), e varchar(8))");
+  ok_sql(hstmt, "INSERT INTO t_getdata_overhead VALUES (1, 2, 3, 'x', 'y'), "
+                "(4, 5, 6, 'z', 'w'), (7, 8, 9, 'v', 'u'), (0, 1, 2, 't', 's')");
+
+  /* 4^5 = 1024 rows of 5 columns */
+  ok_sql(hstmt, "SELECT a.a, b.b, c.c, d.d, e.e FROM t_getdata_overhead a, "
+                "t_getdata_overhead b, t_getdata_overhead c, "
+                "t_getdata_overhead d, t_getdata_overhead e");
+
+  start= clock();
+
+  while (SQLFetch(hstmt) == SQL_SUCCESS)
+  {
+    for (col= 1; col <= 3; ++col)
+    {
+      ok_stmt(hstmt, SQLGetData(hstmt, (SQLUSMALLINT)col, SQL_C_LONG, &num, 0,
+                                &len));
+    }
+    for (col= 4; col <= 5; ++col)
+    {
+      ok_stmt(hstmt, SQLGetData(hstmt, (SQLUSMALLINT)col, SQL_C_CHAR, buf,
+                                sizeof(buf), &len));
+    }
+    calls+= 5;
+    ++rows;
+  }
+
+  elapsed= (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  is_num(rows, 1024);
+  printMessage("SQLGetData: %ld calls, %.0f ns per call (including SQLFetch)",
+               calls, elapsed * 1e9 / calls);
+
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_getdata_overhead");
+
+  return OK;
+}
+
+
+/*
+  OPTIONAL_METADATA: repeated query gets its metadata from the cache, if the
+  server supports optional metadata, or from the server otherwise. Other
+  queries in between must get their own metadata.
+*/
+DECLARE_TEST(t_optional_metadata)
+{
+  DECLARE_BASIC_HANDLES(henv1, hdbc1, hstmt1);
+  SQLHSTMT hstmt2;
+  SQLCHAR name[MAX_NAME_LEN], buf[MAX_ROW_DATA_LEN+1];
+  SQLSMALLINT len, type, columns;
+  SQLINTEGER i, rows;
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_optional_metadata");
+  ok_sql(hstmt, "CREATE TABLE t_optional_metadata (id int, val varchar(10))");
+  ok_sql(hstmt, "INSERT INTO t_optional_metadata VALUES (1, 'a'), (2, 'b')");
+
+  is(OK == alloc_basic_handles_with_opt(&henv1, &hdbc1, &hstmt1, NULL,
+                                        NULL, NULL, NULL, "OPTIONAL_METADATA=1"));
+  ok_con(hdbc1, SQLAllocHandle(SQL_HANDLE_STMT, hdbc1, &hstmt2));
+
+  for (i= 0; i < 4; ++i)
+  {
+    ok_sql(hstmt1, "SELECT id, val AS v FROM t_optional_metadata ORDER BY id");
+
+    ok_stmt(hstmt1, SQLNumResultCols(hstmt1, &columns));
+    is_num(columns, 2);
+    ok_stmt(hstmt1, SQLDescribeCol(hstmt1, 2, name, sizeof(name), &len, &type,
+                                   NULL, NULL, NULL));
+    is_str(name, "v", 2);
+    is_num(type, SQL_VARCHAR);
+
+    ok_stmt(hstmt1, SQLColAttribute(hstmt1, 2, SQL_DESC_BASE_COLUMN_NAME, name,
+                                    sizeof(name), &len, NULL));
+    is_str(name, "val", 4);
+
+    for (rows= 0; SQLFetch(hstmt1) == SQL_SUCCESS; ++rows)
+    {
+      is_num(my_fetch_int(hstmt1, 1), rows + 1);
+      is_str(my_fetch_str(hstmt1, buf, 2), rows ? "b" : "a", 2);
+    }
+    is_num(rows, 2);
+    ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+    /* Different query on the same connection needs the server metadata */
+    ok_sql(hstmt2, "SELECT 'x' AS other");
+    ok_stmt(hstmt2, SQLDescribeCol(hstmt2, 1, name, sizeof(name), &len, &type,
+                                   NULL, NULL, NULL));
+    is_str(name, "other", 6);
+    ok_stmt(hstmt2, SQLFetch(hstmt2));
+    is_str(my_fetch_str(hstmt2, buf, 1), "x", 2);
+    ok_stmt(hstmt2, SQLFreeStmt(hstmt2, SQL_CLOSE));
+  }
+
+  /* DDL on the same connection drops the cached definitions, even though
+     the number of columns stays the same */
+  ok_sql(hstmt2, "ALTER TABLE t_optional_metadata MODIFY val char(10)");
+  ok_sql(hstmt1, "SELECT id, val AS v FROM t_optional_metadata ORDER BY id");
+  ok_stmt(hstmt1, SQLDescribeCol(hstmt1, 2, name, sizeof(name), &len, &type,
+                                 NULL, NULL, NULL));
+  is_num(type, SQL_CHAR);
+  ok_stmt(hstmt1, SQLFetch(hstmt1));
+  is_str(my_fetch_str(hstmt1, buf, 2), "a", 2);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  for (i= 0; i < 3; ++i)
+  {
+    if (i == 2)
+    {
+      ok_sql(hstmt2, "ALTER TABLE t_optional_metadata CHANGE val renamed char(10)");
+    }
+
+    ok_sql(hstmt1, "SELECT * FROM t_optional_metadata ORDER BY id");
+    ok_stmt(hstmt1, SQLDescribeCol(hstmt1, 2, name, sizeof(name), &len, &type,
+                                   NULL, NULL, NULL));
+    is_str(name, i == 2 ? "renamed" : "val", i == 2 ? 8 : 4);
+    ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+  }
+
+  /* DDL of another connection changing the number of columns, the query
+     is executed again with the metadata */
+  for (i= 0; i < 3; ++i)
+  {
+    if (i == 1)
+    {
+      ok_sql(hstmt, "ALTER TABLE t_optional_metadata ADD COLUMN extra int");
+    }
+
+    ok_sql(hstmt1, "SELECT * FROM t_optional_metadata ORDER BY id");
+    ok_stmt(hstmt1, SQLNumResultCols(hstmt1, &columns));
+    is_num(columns, i ? 3 : 2);
+    ok_stmt(hstmt1, SQLFetch(hstmt1));
+    is_num(my_fetch_int(hstmt1, 1), 1);
+    ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+  }
+
+  ok_stmt(hstmt2, SQLFreeHandle(SQL_HANDLE_STMT, hstmt2));
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_optional_metadata");
+
+  return OK;
+}
+
+
+/*
+  FETCH_THREADS: large rowsets are filled in parallel, the values, row
+  statuses and truncation warnings must be the same as row by row.
+*/
+#define FETCH_THREADS_ROWS 300
+DECLARE_TEST(t_fetch_threads)
+{
+  DECLARE_BASIC_HANDLES(henv1, hdbc1, hstmt1);
+  SQLINTEGER id[FETCH_THREADS_ROWS];
+  SQLCHAR name[FETCH_THREADS_ROWS][8];
+  SQLLEN name_len[FETCH_THREADS_ROWS];
+  SQLUSMALLINT status[FETCH_THREADS_ROWS];
+  SQLULEN fetched;
+  SQLCHAR insert[FETCH_THREADS_ROWS * 32], *pos;
+  SQLCHAR sqlstate[6], message[SQL_MAX_MESSAGE_LENGTH];
+  SQLINTEGER native_error, i;
+  SQLSMALLINT message_len;
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_fetch_threads");
+  ok_sql(hstmt, "CREATE TABLE t_fetch_threads (id INT, name VARCHAR(20))");
+
+  /* Every 10th name does not fit into the buffer */
+  pos= insert + sprintf((char *)insert, "INSERT INTO t_fetch_threads VALUES ");
+  for (i= 0; i < FETCH_THREADS_ROWS; ++i)
+  {
+    pos+= sprintf((char *)pos, "%s(%d,'%s%d')", i ? "," : "", (int)i,
+                  i % 10 ? "r" : "long row ", (int)i);
+  }
+  ok_stmt(hstmt, SQLExecDirect(hstmt, insert, SQL_NTS));
+
+  is(OK == alloc_basic_handles_with_opt(&henv1, &hdbc1, &hstmt1, NULL,
+                                        NULL, NULL, NULL, "FETCH_THREADS=4"));
+
+  ok_stmt(hstmt1, SQLSetStmtAttr(hstmt1, SQL_ATTR_ROW_ARRAY_SIZE,
+                                 (SQLPOINTER)FETCH_THREADS_ROWS, 0));
+  ok_stmt(hstmt1, SQLSetStmtAttr(hstmt1, SQL_ATTR_ROW_STATUS_PTR, status, 0));
+  ok_stmt(hstmt1, SQLSetStmtAttr(hstmt1, SQL_ATTR_ROWS_FETCHED_PTR, &fetched, 0));
+  ok_stmt(hstmt1, SQLBindCol(hstmt1, 1, SQL_C_LONG, id, 0, NULL));
+  ok_stmt(hstmt1, SQLBindCol(hstmt1, 2, SQL_C_CHAR, name, sizeof(name[0]),
+                             name_len));
+
+  ok_sql(hstmt1, "SELECT id, name FROM t_fetch_threads ORDER BY id");
+  expect_stmt(hstmt1, SQLFetch(hstmt1), SQL_SUCCESS_WITH_INFO);
+  is_num(fetched, FETCH_THREADS_ROWS);
+
+  for (i= 0; i < FETCH_THREADS_ROWS; ++i)
+  {
+    char expected[32];
+    sprintf(expected, "%s%d", i % 10 ? "r" : "long row ", (int)i);
+
+    is_num(id[i], i);
+    is_num(name_len[i], strlen(expected));
+    is_str(name[i], expected, i % 10 ? strlen(expected) : sizeof(name[0]) - 1);
+    is_num(status[i], i % 10 ? SQL_ROW_SUCCESS : SQL_ROW_SUCCESS_WITH_INFO);
+  }
+
+  ok_stmt(hstmt1, SQLGetDiagRec(SQL_HANDLE_STMT, hstmt1, 1, sqlstate,
+                                &native_error, message, sizeof(message),
+                                &message_len));
+  is_str(sqlstate, "01004", 5);
+
+  expect_stmt(hstmt1, SQLFetch(hstmt1), SQL_NO_DATA);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_fetch_threads");
+
+  return OK;
+}
+
+
+/*
+  PREFETCH_KEYSET continues prefetch chunks from the last ORDER BY key,
+  the rows have to be the same as with offsets
+*/
+DECLARE_TEST(t_prefetch_keyset)
+{
+  DECLARE_BASIC_HANDLES(henv1, hdbc1, hstmt1);
+  SQLCHAR insert[1024], *pos;
+  int i, expected;
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_prefetch_keyset");
+  ok_sql(hstmt, "CREATE TABLE t_prefetch_keyset (id INT PRIMARY KEY, "
+                "code VARCHAR(10) NOT NULL UNIQUE, v INT)");
+
+  pos= insert + sprintf((char *)insert, "INSERT INTO t_prefetch_keyset VALUES ");
+  for (i= 1; i <= 23; ++i)
+  {
+    pos+= sprintf((char *)pos, "%s(%d,'c''%02d',%d)", i > 1 ? "," : "",
+                  i, i, i % 3);
+  }
+  ok_stmt(hstmt, SQLExecDirect(hstmt, insert, SQL_NTS));
+
+  is(OK == alloc_basic_handles_with_opt(&henv1, &hdbc1, &hstmt1, NULL, NULL,
+                                        NULL, NULL,
+                                        "PREFETCH=5;PREFETCH_KEYSET=1"));
+
+  ok_sql(hstmt1, "SELECT id FROM t_prefetch_keyset "
+                 "WHERE v = 0 OR id < 4 ORDER BY id");
+  for (i= 1; i <= 23; ++i)
+  {
+    if (i % 3 == 0 || i < 4)
+    {
+      ok_stmt(hstmt1, SQLFetch(hstmt1));
+      is_num(my_fetch_int(hstmt1, 1), i);
+    }
+  }
+  expect_stmt(hstmt1, SQLFetch(hstmt1), SQL_NO_DATA);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  /* Quoted string key, descending */
+  ok_sql(hstmt1, "SELECT id, code FROM t_prefetch_keyset ORDER BY code DESC");
+  for (expected= 23; expected > 0; --expected)
+  {
+    ok_stmt(hstmt1, SQLFetch(hstmt1));
+    is_num(my_fetch_int(hstmt1, 1), expected);
+  }
+  expect_stmt(hstmt1, SQLFetch(hstmt1), SQL_NO_DATA);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  /* Not a key - scrolled by offsets */
+  ok_sql(hstmt1, "SELECT id FROM t_prefetch_keyset ORDER BY v");
+  is_num(myrowcount(hstmt1), 23);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  /* Same column names from both tables, ordered by the second one */
+  ok_sql(hstmt1, "SELECT a.id, b.id FROM t_prefetch_keyset a "
+                 "JOIN t_prefetch_keyset b ON b.id = 24 - a.id ORDER BY b.id");
+  for (i= 1; i <= 23; ++i)
+  {
+    ok_stmt(hstmt1, SQLFetch(hstmt1));
+    is_num(my_fetch_int(hstmt1, 1), 24 - i);
+    is_num(my_fetch_int(hstmt1, 2), i);
+  }
+  expect_stmt(hstmt1, SQLFetch(hstmt1), SQL_NO_DATA);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  /*
+    Rows deleted behind the cursor shift the offsets but not the keys, the
+    next chunk starts right after the last row only if the key is used
+  */
+  ok_sql(hstmt1, "SELECT id FROM t_prefetch_keyset ORDER BY id");
+  for (i= 1; i <= 5; ++i)
+  {
+    ok_stmt(hstmt1, SQLFetch(hstmt1));
+    is_num(my_fetch_int(hstmt1, 1), i);
+  }
+  ok_sql(hstmt, "DELETE FROM t_prefetch_keyset WHERE id <= 2");
+  for (i= 6; i <= 23; ++i)
+  {
+    ok_stmt(hstmt1, SQLFetch(hstmt1));
+    is_num(my_fetch_int(hstmt1, 1), i);
+  }
+  expect_stmt(hstmt1, SQLFetch(hstmt1), SQL_NO_DATA);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_prefetch_keyset");
+
+  return OK;
+}
+
+
+/* Driver specific statement attribute, writes the result set to a file */
+#define SQL_ATTR_MYODBC_EXPORT (SQL_DRIVER_STMT_ATTR_BASE + 1)
+
+/*
+  SQL_ATTR_MYODBC_EXPORT: the rest of the result set is written as CSV,
+  with the quoting, NULL and binary values as documented.
+*/
+DECLARE_TEST(t_export)
+{
+  const char *expected= "a,b,c,d,e,f\r\n"
+                        "1,\"x,y\",,\"\",\"q\"\"\",00FF\r\n"
+                        "2,\"line\nbreak\",3,plain,\\,\"\"\r\n";
+  char buf[1024];
+  size_t len;
+  FILE *file;
+
+  ok_sql(hstmt, "SELECT 1 AS a, 'x,y' AS b, NULL AS c, '' AS d, 'q\"' AS e, "
+                "X'00FF' AS f UNION ALL "
+                "SELECT 2, 'line\\nbreak', 3, 'plain', '\\\\', X''");
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_MYODBC_EXPORT,
+                                "t_export.csv", SQL_NTS));
+  /* The cursor is closed by the export */
+  expect_stmt(hstmt, SQLFetch(hstmt), SQL_ERROR);
+
+  is(file= fopen("t_export.csv", "rb"));
+  len= fread(buf, 1, sizeof(buf) - 1, file);
+  buf[len]= '\0';
+  fclose(file);
+  remove("t_export.csv");
+
+  printMessage("%s", buf);
+  is_num(len, strlen(expected));
+  is_str(buf, expected, len);
+
+  /* Without a result set */
+  ok_sql(hstmt, "SET @t_export= 1");
+  expect_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_MYODBC_EXPORT,
+                                    "t_export.csv", SQL_NTS), SQL_ERROR);
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  /* PREFETCH: the next chunks are queried during the export */
+  {
+    DECLARE_BASIC_HANDLES(henv1, hdbc1, hstmt1);
+
+    is(OK == alloc_basic_handles_with_opt(&henv1, &hdbc1, &hstmt1, NULL,
+                                          NULL, NULL, NULL,
+                                          "PREFETCH=3;NO_SSPS=1"));
+
+    ok_sql(hstmt1, "DROP TABLE IF EXISTS t_export");
+    ok_sql(hstmt1, "CREATE TABLE t_export (id INT PRIMARY KEY)");
+    ok_sql(hstmt1, "INSERT INTO t_export VALUES (1),(2),(3),(4),(5),(6),(7)");
+
+    ok_sql(hstmt1, "SELECT id FROM t_export ORDER BY id");
+    ok_stmt(hstmt1, SQLSetStmtAttr(hstmt1, SQL_ATTR_MYODBC_EXPORT,
+                                   "t_export.csv", SQL_NTS));
+
+    is(file= fopen("t_export.csv", "rb"));
+    len= fread(buf, 1, sizeof(buf) - 1, file);
+    buf[len]= '\0';
+    fclose(file);
+    remove("t_export.csv");
+
+    expected= "id\r\n1\r\n2\r\n3\r\n4\r\n5\r\n6\r\n7\r\n";
+    is_num(len, strlen(expected));
+    is_str(buf, expected, len);
+
+    /* Catalog results are exported from the rows the driver made up */
+    ok_stmt(hstmt1, SQLTables(hstmt1, NULL, 0, NULL, 0,
+                              (SQLCHAR *)"t_export", SQL_NTS, NULL, 0));
+    ok_stmt(hstmt1, SQLSetStmtAttr(hstmt1, SQL_ATTR_MYODBC_EXPORT,
+                                   "t_export.csv", SQL_NTS));
+
+    is(file= fopen("t_export.csv", "rb"));
+    len= fread(buf, 1, sizeof(buf) - 1, file);
+    buf[len]= '\0';
+    fclose(file);
+    remove("t_export.csv");
+
+    printMessage("%s", buf);
+    is(strncmp(buf, "TABLE_CAT,TABLE_SCHEM,TABLE_NAME,TABLE_TYPE,", 44) == 0);
+    is(strstr(buf, ",t_export,TABLE,") != NULL);
+    /* The header and one row */
+    is(strstr(buf, "\r\n") != NULL);
+    is(strstr(strstr(buf, "\r\n") + 2, "\r\n") == buf + len - 2);
+
+    ok_stmt(hstmt1, SQLGetTypeInfo(hstmt1, SQL_INTEGER));
+    ok_stmt(hstmt1, SQLSetStmtAttr(hstmt1, SQL_ATTR_MYODBC_EXPORT,
+                                   "t_export.csv", SQL_NTS));
+
+    is(file= fopen("t_export.csv", "rb"));
+    len= fread(buf, 1, sizeof(buf) - 1, file);
+    buf[len]= '\0';
+    fclose(file);
+    remove("t_export.csv");
+
+    printMessage("%s", buf);
+    is(strncmp(buf, "TYPE_NAME,DATA_TYPE,", 20) == 0);
+    is(strstr(buf, "\r\nint") != NULL);
+
+    ok_sql(hstmt1, "DROP TABLE IF EXISTS t_export");
+    free_basic_handles(&henv1, &hdbc1, &hstmt1);
+  }
+
+  return OK;
+}
+
+
+/*
+  SQL_ATTR_MAX_LENGTH: long columns are truncated by the server, the data
+  and metadata of the result are the same as with truncation by the driver.
+*/
+DECLARE_TEST(t_max_length)
+{
+  SQLCHAR     name[32];
+  SQLSMALLINT type, full_type;
+  SQLULEN     size, full_size;
+  SQLLEN      len;
+  char        buff[64];
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_max_length");
+  ok_sql(hstmt, "CREATE TABLE t_max_length (id INT, t TEXT, b BLOB)");
+  ok_sql(hstmt, "INSERT INTO t_max_length VALUES "
+                "(1, REPEAT('a', 1000), REPEAT('b', 1000)), (2, 'short', '')");
+
+  ok_sql(hstmt, "SELECT id, t AS txt, b FROM t_max_length ORDER BY id");
+  ok_stmt(hstmt, SQLDescribeCol(hstmt, 2, name, sizeof(name), NULL,
+                                &full_type, &full_size, NULL, NULL));
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_MAX_LENGTH,
+                                (SQLPOINTER)10, 0));
+
+  ok_sql(hstmt, "SELECT id, t AS txt, b FROM t_max_length ORDER BY id");
+  ok_stmt(hstmt, SQLDescribeCol(hstmt, 2, name, sizeof(name), NULL,
+                                &type, &size, NULL, NULL));
+  is_str(name, "txt", 4);
+  is_num(type, full_type);
+  is_num(size, full_size);
+
+  ok_stmt(hstmt, SQLFetch(hstmt));
+  is_num(my_fetch_int(hstmt, 1), 1);
+  ok_stmt(hstmt, SQLGetData(hstmt, 2, SQL_C_CHAR, buff, sizeof(buff), &len));
+  is_num(len, 10);
+  is_str(buff, "aaaaaaaaaa", 11);
+  ok_stmt(hstmt, SQLGetData(hstmt, 3, SQL_C_BINARY, buff, sizeof(buff), &len));
+  is_num(len, 10);
+
+  ok_stmt(hstmt, SQLFetch(hstmt));
+  is_str(my_fetch_str(hstmt, buff, 2), "short", 6);
+  expect_stmt(hstmt, SQLFetch(hstmt), SQL_NO_DATA);
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  ok_sql(hstmt, "INSERT INTO t_max_length VALUES "
+                "(3, 'aaaaaaaaaab', ''), (4, 'aaaaaaaaaaz', '')");
+
+  /* Sorted by the whole values, not by the truncated ones */
+  ok_sql(hstmt, "SELECT id, t AS txt FROM t_max_length WHERE id > 2 "
+                "ORDER BY txt DESC, id");
+  ok_stmt(hstmt, SQLFetch(hstmt));
+  is_num(my_fetch_int(hstmt, 1), 4);
+  is_str(my_fetch_str(hstmt, buff, 2), "aaaaaaaaaa", 11);
+  ok_stmt(hstmt, SQLFetch(hstmt));
+  is_num(my_fetch_int(hstmt, 1), 3);
+  expect_stmt(hstmt, SQLFetch(hstmt), SQL_NO_DATA);
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  /* DISTINCT compares the whole values */
+  ok_sql(hstmt, "SELECT DISTINCT t FROM t_max_length WHERE id > 2");
+  is_num(myrowcount(hstmt), 2);
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  /* The same by the position in the select list */
+  ok_sql(hstmt, "SELECT id, t FROM t_max_length WHERE id > 2 "
+                "ORDER BY 2 DESC, 1");
+  ok_stmt(hstmt, SQLFetch(hstmt));
+  is_num(my_fetch_int(hstmt, 1), 4);
+  is_str(my_fetch_str(hstmt, buff, 2), "aaaaaaaaaa", 11);
+  ok_stmt(hstmt, SQLFetch(hstmt));
+  is_num(my_fetch_int(hstmt, 1), 3);
+  expect_stmt(hstmt, SQLFetch(hstmt), SQL_NO_DATA);
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  ok_sql(hstmt, "SELECT MIN(id), t FROM t_max_length WHERE id > 2 GROUP BY 2");
+  is_num(myrowcount(hstmt), 2);
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  /* A wildcard is not rewritten, the driver still truncates */
+  ok_sql(hstmt, "SELECT * FROM t_max_length ORDER BY id");
+  ok_stmt(hstmt, SQLFetch(hstmt));
+  is_str(my_fetch_str(hstmt, buff, 2), "aaaaaaaaaa", 11);
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_MAX_LENGTH,
+                                (SQLPOINTER)0, 0));
+  ok_sql(hstmt, "DROP TABLE IF EXISTS t_max_length");
+
+  return OK;
+}
+
+
 BEGIN_TESTS
   ADD_TEST(t_bug32420)
   ADD_TEST(t_bug34575)
@@ -1395,6 +1986,13 @@ BEGIN_TESTS
 #endif
   ADD_TEST(t_bug17311065)
   ADD_TEST(t_prefetch_bug)
+  ADD_TEST(t_conversion_memo)
+  ADD_TEST(t_getdata_overhead)
+  ADD_TEST(t_optional_metadata)
+  ADD_TEST(t_fetch_threads)
+  ADD_TEST(t_prefetch_keyset)
+  ADD_TEST(t_export)
+  ADD_TEST(t_max_length)
 END_TESTS
 
 
@@ -1412,6 +1412,51 @@ DECLARE_TEST(t_bug14838690)
 }
 
 
+/*
+  Reading a text column by small chunks: every chunk has to continue where
+  the previous one stopped, and report what is left of the value.
+*/
+DECLARE_TEST(t_getdata_chunks)
+{
+  SQLWCHAR wbuff[8], expected[102];
+  SQLLEN len;
+  SQLRETURN rc;
+  int i, pos= 0;
+
+  for (i= 0; i < 100; ++i)
+    expected[i]= 'a';
+  expected[100]= 0x00e3;
+  expected[101]= 0x30a1;
+
+  ok_sql(hstmt, "SELECT CONCAT(REPEAT('a', 100), _utf8 0xC3A3E382A1)");
+  ok_stmt(hstmt, SQLFetch(hstmt));
+
+  while (pos < 102)
+  {
+    int chunk= 102 - pos < 7 ? 102 - pos : 7;
+
+    rc= SQLGetData(hstmt, 1, SQL_C_WCHAR, wbuff, sizeof(wbuff), &len);
+    is_num(len, (102 - pos) * sizeof(SQLWCHAR));
+    is_num(rc, pos + chunk < 102 ? SQL_SUCCESS_WITH_INFO : SQL_SUCCESS);
+
+    for (i= 0; i < chunk; ++i)
+    {
+      is(wbuff[i] == expected[pos + i]);
+    }
+    is(wbuff[chunk] == 0);
+
+    pos+= chunk;
+  }
+
+  expect_stmt(hstmt, SQLGetData(hstmt, 1, SQL_C_WCHAR, wbuff, sizeof(wbuff),
+                                &len), SQL_NO_DATA_FOUND);
+
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  return OK;
+}
+
+
 BEGIN_TESTS
   ADD_TEST(sqlconnect)
   ADD_TEST_UNICODE(sqlprepare)
@@ -1439,6 +1484,7 @@ BEGIN_TESTS
   ADD_TEST_UNICODE(t_bug32161)
   // ADD_TEST_UNICODE(t_bug34672) TODO: Fix
   ADD_TEST_UNICODE(t_bug28168)
+  ADD_TEST(t_getdata_chunks)
   // ADD_TEST_UNICODE(t_bug14363601) TODO: Fix
   // ADD_TEST_UNICODE(t_bug14838690) TODO: Fix
 END_TESTS
@@ -187,6 +187,30 @@ static SQLWCHAR W_SSLMODE[] =
 { 'S', 'S', 'L', 'M', 'O', 'D', 'E', 0 };
 static SQLWCHAR W_NO_DATE_OVERFLOW[] =
 { 'N', 'O', '_', 'D', 'A', 'T', 'E', '_', 'O', 'V', 'E', 'R', 'F', 'L', 'O', 'W', 0 };
+static SQLWCHAR W_LAZY_CONNECT[] =
+{ 'L', 'A', 'Z', 'Y', '_', 'C', 'O', 'N', 'N', 'E', 'C', 'T', 0 };
+static SQLWCHAR W_ADAPTIVE_SSPS[] =
+{ 'A', 'D', 'A', 'P', 'T', 'I', 'V', 'E', '_', 'S', 'S', 'P', 'S', 0 };
+static SQLWCHAR W_CONVERSION_MEMO[] =
+{ 'C', 'O', 'N', 'V', 'E', 'R', 'S', 'I', 'O', 'N', '_', 'M', 'E', 'M', 'O', 0 };
+static SQLWCHAR W_OPTIONAL_METADATA[] =
+{ 'O', 'P', 'T', 'I', 'O', 'N', 'A', 'L', '_', 'M', 'E', 'T', 'A', 'D', 'A', 'T', 'A', 0 };
+static SQLWCHAR W_FLIGHT_RECORDER[] =
+{ 'F', 'L', 'I', 'G', 'H', 'T', '_', 'R', 'E', 'C', 'O', 'R', 'D', 'E', 'R', 0 };
+static SQLWCHAR W_SLOW_QUERY_MS[] =
+{ 'S', 'L', 'O', 'W', '_', 'Q', 'U', 'E', 'R', 'Y', '_', 'M', 'S', 0 };
+static SQLWCHAR W_LOCAL_PROBES[] =
+{ 'L', 'O', 'C', 'A', 'L', '_', 'P', 'R', 'O', 'B', 'E', 'S', 0 };
+static SQLWCHAR W_FETCH_THREADS[] =
+{ 'F', 'E', 'T', 'C', 'H', '_', 'T', 'H', 'R', 'E', 'A', 'D', 'S', 0 };
+static SQLWCHAR W_READ_AHEAD[] =
+{ 'R', 'E', 'A', 'D', '_', 'A', 'H', 'E', 'A', 'D', 0 };
+static SQLWCHAR W_PREFETCH_KEYSET[] =
+{ 'P', 'R', 'E', 'F', 'E', 'T', 'C', 'H', '_', 'K', 'E', 'Y', 'S', 'E', 'T', 0 };
+static SQLWCHAR W_MAX_QUERIES[] =
+{ 'M', 'A', 'X', '_', 'Q', 'U', 'E', 'R', 'I', 'E', 'S', 0 };
+static SQLWCHAR W_QUEUE_TIMEOUT[] =
+{ 'Q', 'U', 'E', 'U', 'E', '_', 'T', 'I', 'M', 'E', 'O', 'U', 'T', 0 };
 
 /* DS_PARAM */
 /* externally used strings */
@@ -220,7 +244,11 @@ SQLWCHAR *dsnparams[]= {W_DSN, W_DRIVER, W_DESCRIPTION, W_SERVER,
                         W_SAVEFILE, W_RSAKEY, W_PLUGIN_DIR, W_DEFAULT_AUTH,
                         W_DISABLE_SSL_DEFAULT, W_SSL_ENFORCE,
                         W_TLS_1, W_NO_TLS_1_1, W_NO_TLS_1_2,
-                        W_SSLMODE, W_NO_DATE_OVERFLOW};
+                        W_SSLMODE, W_NO_DATE_OVERFLOW, W_LAZY_CONNECT,
+                        W_ADAPTIVE_SSPS, W_CONVERSION_MEMO, W_OPTIONAL_METADATA,
+                        W_FLIGHT_RECORDER, W_SLOW_QUERY_MS, W_LOCAL_PROBES,
+                        W_FETCH_THREADS, W_READ_AHEAD, W_PREFETCH_KEYSET,
+                        W_MAX_QUERIES, W_QUEUE_TIMEOUT};
 static const
 int dsnparamcnt= sizeof(dsnparams) / sizeof(SQLWCHAR *);
 /* DS_PARAM */
@@ -888,6 +916,30 @@ void ds_map_param(DataSource *ds, const SQLWCHAR *param,
     *booldest = &ds->no_tls_1_2;
   else if (!sqlwcharcasecmp(W_NO_DATE_OVERFLOW, param))
     *booldest = &ds->no_date_overflow;
+  else if (!sqlwcharcasecmp(W_LAZY_CONNECT, param))
+    *booldest = &ds->lazy_connect;
+  else if (!sqlwcharcasecmp(W_ADAPTIVE_SSPS, param))
+    *booldest = &ds->adaptive_ssps;
+  else if (!sqlwcharcasecmp(W_CONVERSION_MEMO, param))
+    *booldest = &ds->conversion_memo;
+  else if (!sqlwcharcasecmp(W_OPTIONAL_METADATA, param))
+    *booldest = &ds->optional_metadata;
+  else if (!sqlwcharcasecmp(W_FLIGHT_RECORDER, param))
+    *booldest = &ds->flight_recorder;
+  else if (!sqlwcharcasecmp(W_SLOW_QUERY_MS, param))
+    *intdest= &ds->slow_query_ms;
+  else if (!sqlwcharcasecmp(W_LOCAL_PROBES, param))
+    *booldest = &ds->local_probes;
+  else if (!sqlwcharcasecmp(W_FETCH_THREADS, param))
+    *intdest= &ds->fetch_threads;
+  else if (!sqlwcharcasecmp(W_READ_AHEAD, param))
+    *intdest= &ds->read_ahead;
+  else if (!sqlwcharcasecmp(W_PREFETCH_KEYSET, param))
+    *booldest = &ds->prefetch_keyset;
+  else if (!sqlwcharcasecmp(W_MAX_QUERIES, param))
+    *intdest= &ds->max_queries;
+  else if (!sqlwcharcasecmp(W_QUEUE_TIMEOUT, param))
+    *intdest= &ds->queue_timeout;
 
   /* DS_PARAM */
 }
@@ -1382,6 +1434,18 @@ int ds_add(DataSource *ds)
   if (ds_add_intprop(ds->name, W_NO_TLS_1_1, ds->no_tls_1_1)) goto error;
   if (ds_add_intprop(ds->name, W_NO_TLS_1_2, ds->no_tls_1_2)) goto error;
   if (ds_add_intprop(ds->name, W_NO_DATE_OVERFLOW, ds->no_date_overflow)) goto error;
+  if (ds_add_intprop(ds->name, W_LAZY_CONNECT, ds->lazy_connect)) goto error;
+  if (ds_add_intprop(ds->name, W_ADAPTIVE_SSPS, ds->adaptive_ssps)) goto error;
+  if (ds_add_intprop(ds->name, W_CONVERSION_MEMO, ds->conversion_memo)) goto error;
+  if (ds_add_intprop(ds->name, W_OPTIONAL_METADATA, ds->optional_metadata)) goto error;
+  if (ds_add_intprop(ds->name, W_FLIGHT_RECORDER, ds->flight_recorder)) goto error;
+  if (ds_add_intprop(ds->name, W_SLOW_QUERY_MS, ds->slow_query_ms)) goto error;
+  if (ds_add_intprop(ds->name, W_LOCAL_PROBES, ds->local_probes)) goto error;
+  if (ds_add_intprop(ds->name, W_FETCH_THREADS, ds->fetch_threads)) goto error;
+  if (ds_add_intprop(ds->name, W_READ_AHEAD, ds->read_ahead)) goto error;
+  if (ds_add_intprop(ds->name, W_PREFETCH_KEYSET, ds->prefetch_keyset)) goto error;
+  if (ds_add_intprop(ds->name, W_MAX_QUERIES, ds->max_queries)) goto error;
+  if (ds_add_intprop(ds->name, W_QUEUE_TIMEOUT, ds->queue_timeout)) goto error;
   /* DS_PARAM */
 
   rc= 0;
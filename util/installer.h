@@ -162,6 +162,18 @@ typedef struct {
   BOOL no_tls_1_2;
 
   BOOL no_date_overflow;
+  BOOL lazy_connect;
+  BOOL adaptive_ssps;
+  BOOL conversion_memo;
+  BOOL optional_metadata;
+  BOOL flight_recorder;
+  unsigned int slow_query_ms;
+  BOOL local_probes;
+  unsigned int fetch_threads;
+  unsigned int read_ahead;
+  BOOL prefetch_keyset;
+  unsigned int max_queries;
+  unsigned int queue_timeout;
 } DataSource;
 
 /* perhaps that is a good idea to have const ds object with defaults */